@@ -0,0 +1,286 @@
+/*!
+    \file
+    \brief Редукция Барретта: многократное приведение marty::BigInt по одному и тому же модулю
+ */
+#pragma once
+
+#include "marty_bigint.h"
+
+//
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+
+//
+#include "undef_min_max.h"
+
+
+// #include "marty_bigint/barrett.h"
+// marty::
+namespace marty {
+
+
+//----------------------------------------------------------------------------
+//! Приведение по фиксированному модулю m (любому положительному, в том числе чётному) без
+//! деления. Обратная величина mu = floor(B^2n / m) (n - число чанков модуля) считается один
+//! раз в конструкторе, дальше число до 2n чанков приводится двумя "половинными" умножениями:
+//! частное - старшие чанки (x/B^(n-1))*mu, остаток - x минус младшие n+1 чанков частного на m,
+//! и не больше трёх вычитаний m. Более длинные числа приводятся окнами по n чанков от старших.
+//! Результат всегда в [0, m), и для отрицательных аргументов тоже. mul/sqr - произведение по
+//! модулю, для модулярной арифметики по чётному модулю, где не подходит MontgomeryContext.
+//! Версии с результатом в r не аллоцируют, если ёмкости r хватает; временные значения - в
+//! рабочей области текущего контекста арифметики, для диапазона - одна на весь диапазон.
+//! Сам объект после создания не меняется, так что его можно использовать из разных потоков
+class BarrettReducer
+{
+    using chunk_type      = BigInt::chunk_type;
+    using number_holder_t = bigint_details::number_holder_t;
+
+    BigInt                   m_modulus;
+    number_holder_t          m_m;   // модуль, n+1 чанков (старший - ноль)
+    number_holder_t          m_mu;  // floor(B^2n / m), n+1 чанков (n+2 для m = B^(n-1))
+
+public:
+
+    explicit BarrettReducer(const BigInt &modulus)
+    : m_modulus(modulus)
+    {
+        if (modulus.sign()<=0)
+            throw std::invalid_argument("BarrettReducer: modulus must be positive");
+
+        const std::size_t n = modulus.chunksSize();
+        m_m.assign(n+1u, chunk_type(0));
+        std::copy(modulus.chunksData(), modulus.chunksData()+n, m_m.begin());
+
+        const BigInt mu = (BigInt(1)<<int(2u*n*sizeof(chunk_type)*CHAR_BIT)) / modulus;
+        m_mu.assign(mu.chunksData(), mu.chunksData()+mu.chunksSize());
+    }
+
+    const BigInt& modulus() const { return m_modulus; }
+
+    //! Размер модуля в чанках
+    std::size_t size() const { return m_m.size()-1u; }
+
+    //! a mod m, в [0, m)
+    BigInt reduce(const BigInt &a) const
+    {
+        BigInt res;
+        reduce(res, a);
+        return res;
+    }
+
+    //! r = a mod m, r может быть a
+    void reduce(BigInt &r, const BigInt &a) const
+    {
+        const BigInt::arithmetic_context     &ctx = BigInt::currentContext();
+        const bigint_limbs::mul_thresholds   &th  = ctx.getMulThresholds();
+
+        bigint_details::scratch_holder s(ctx.getWorkspace(), scratchSize(th));
+        s->resize(scratchSize(th));
+        reduceImpl(r, a.sign(), a.chunksData(), a.sign()==0 ? 0u : a.chunksSize(), s->data(), th);
+    }
+
+    //! Приводит все числа [first, last) и пишет результаты в out, как std::transform.
+    //! Рабочая область берётся один раз на весь диапазон. out может совпадать с first
+    template<typename InputIt, typename OutputIt>
+    OutputIt reduce(InputIt first, InputIt last, OutputIt out) const
+    {
+        const BigInt::arithmetic_context     &ctx = BigInt::currentContext();
+        const bigint_limbs::mul_thresholds   &th  = ctx.getMulThresholds();
+
+        bigint_details::scratch_holder s(ctx.getWorkspace(), scratchSize(th));
+        s->resize(scratchSize(th));
+
+        for(; first!=last; ++first, ++out)
+        {
+            BigInt r;
+            const BigInt &a = *first;
+            reduceImpl(r, a.sign(), a.chunksData(), a.sign()==0 ? 0u : a.chunksSize(), s->data(), th);
+            *out = std::move(r);
+        }
+
+        return out;
+    }
+
+    BigInt operator()(const BigInt &a) const
+    {
+        return reduce(a);
+    }
+
+    //! a*b mod m
+    BigInt mul(const BigInt &a, const BigInt &b) const
+    {
+        BigInt res;
+        mul(res, a, b);
+        return res;
+    }
+
+    //! r = a*b mod m, r может быть a или b. Произведение - в рабочей области, без BigInt
+    void mul(BigInt &r, const BigInt &a, const BigInt &b) const
+    {
+        if (a.sign()==0 || b.sign()==0)
+        {
+            r = BigInt(0);
+            return;
+        }
+
+        const BigInt::arithmetic_context     &ctx = BigInt::currentContext();
+        const bigint_limbs::mul_thresholds   &th  = ctx.getMulThresholds();
+
+        const std::size_t an = a.chunksSize();
+        const std::size_t bn = b.chunksSize();
+
+        bigint_details::scratch_holder s(ctx.getWorkspace());
+        s->resize(an+bn + std::max(scratchSize(th), bigint_limbs::mulScratchSize(an, bn, th)));
+
+        chunk_type *p = s->data();
+        bigint_limbs::mul(p, a.chunksData(), an, b.chunksData(), bn, p+an+bn, th);
+        reduceImpl(r, a.sign()*b.sign(), p, bigint_limbs::normalizedSize(p, an+bn), p+an+bn, th);
+    }
+
+    //! a^2 mod m
+    BigInt sqr(const BigInt &a) const
+    {
+        BigInt res;
+        sqr(res, a);
+        return res;
+    }
+
+    //! r = a^2 mod m, r может быть a
+    void sqr(BigInt &r, const BigInt &a) const
+    {
+        if (a.sign()==0)
+        {
+            r = BigInt(0);
+            return;
+        }
+
+        const BigInt::arithmetic_context     &ctx = BigInt::currentContext();
+        const bigint_limbs::mul_thresholds   &th  = ctx.getMulThresholds();
+
+        const std::size_t n = a.chunksSize();
+
+        bigint_details::scratch_holder s(ctx.getWorkspace());
+        s->resize(2u*n + std::max(scratchSize(th), bigint_limbs::sqrScratchSize(n, th)));
+
+        chunk_type *p = s->data();
+        bigint_limbs::sqr(p, a.chunksData(), n, p+2u*n, th);
+        reduceImpl(r, 1, p, bigint_limbs::normalizedSize(p, 2u*n), p+2u*n, th);
+    }
+
+protected:
+
+    // Быстрое умножение вместо "половинных" столбиком - с порога Карацубы
+    bool useFastMul(const bigint_limbs::mul_thresholds &th) const
+    {
+        return m_m.size()>=th.karatsuba;
+    }
+
+    // Раскладка рабочей области: окно x (2n), q1*mu (n+1 + |mu|), остаток (n+1),
+    // произведение q3*m (2n+1) и рабочая область быстрого умножения
+    std::size_t scratchSize(const bigint_limbs::mul_thresholds &th) const
+    {
+        const std::size_t n  = size();
+        const std::size_t mn = m_mu.size();
+
+        std::size_t res = 2u*n + (n+1u+mn) + (n+1u) + (2u*n+1u);
+        if (useFastMul(th))
+            res += std::max(bigint_limbs::mulScratchSize(n+1u, mn, th), bigint_limbs::mulScratchSize(n+1u, n, th));
+
+        return res;
+    }
+
+    // r = a mod m, a - an чанков модуля со знаком sign. pa может указывать в r
+    void reduceImpl(BigInt &r, int sign, const chunk_type *pa, std::size_t an, chunk_type *s, const bigint_limbs::mul_thresholds &th) const
+    {
+        const std::size_t n = size();
+
+        if (an<n || (an==n && bigint_limbs::cmp(pa, m_m.data(), n)<0))
+        {
+            if (sign<0 && an!=0)
+            {
+                chunk_type *rem = s;
+                bigint_limbs::sub(rem, m_m.data(), n, pa, an);
+                r.assignChunks(1, rem, n);
+            }
+            else if (pa!=r.chunksData())
+            {
+                r.assignChunks(1, pa, an);
+            }
+            return;
+        }
+
+        chunk_type *w   = s;
+        chunk_type *rem = s + 2u*n + (n+1u+m_mu.size());
+
+        // Первое окно - старшие чанки, от n+1 до 2n, дальше - по n чанков: остаток (меньше m)
+        // становится старшей половиной окна
+        const std::size_t steps = an>2u*n ? (an-2u*n+n-1u)/n : 0u;
+        std::size_t       pos   = steps*n;
+
+        std::fill(w, w+2u*n, chunk_type(0));
+        std::copy(pa+pos, pa+an, w);
+        reduceWindow(rem, w, s+2u*n, th);
+
+        while(pos!=0)
+        {
+            pos -= n;
+            std::copy(rem, rem+n, w+n);
+            std::copy(pa+pos, pa+pos+n, w);
+            reduceWindow(rem, w, s+2u*n, th);
+        }
+
+        const std::size_t rn = bigint_limbs::normalizedSize(rem, n);
+        if (sign<0 && rn!=0)
+            bigint_limbs::sub_n(rem, m_m.data(), rem, n);
+
+        r.assignChunks(1, rem, n);
+    }
+
+    // r (n+1 чанков, значимы n) = x mod m, x - 2n чанков. t - q1*mu, за ним r, за r -
+    // произведение q3*m и рабочая область быстрого умножения
+    void reduceWindow(chunk_type *r, const chunk_type *x, chunk_type *t, const bigint_limbs::mul_thresholds &th) const
+    {
+        const std::size_t n  = size();
+        const std::size_t mn = m_mu.size();
+
+        const chunk_type *q1 = x + (n-1u);  // x / B^(n-1), n+1 чанков
+        const chunk_type *q3 = t + (n+1u);  // q1*mu / B^(n+1), значимы n+1 чанков
+
+        if (useFastMul(th))
+        {
+            chunk_type *p = r + (n+1u);
+            bigint_limbs::mul(t, q1, n+1u, m_mu.data(), mn, p+2u*n+1u, th);
+            bigint_limbs::mul(p, q3, n+1u, m_m.data(), n, p+2u*n+1u, th);
+            bigint_limbs::sub_n(r, x, p, n+1u);
+        }
+        else
+        {
+            // Столбцы младше n-1 отбрасываются: частное меньше не больше чем на единицу,
+            // пока n-1 < B
+            const std::size_t skip = n-1u<=std::size_t(std::numeric_limits<chunk_type>::max()) ? n-1u : 0u;
+            bigint_limbs::mulhi_basecase(t, q1, n+1u, m_mu.data(), mn, skip);
+            bigint_limbs::mullo_basecase(r + (n+1u), q3, m_m.data(), n+1u);
+            bigint_limbs::sub_n(r, x, r + (n+1u), n+1u);
+        }
+
+        // Частное занижено не больше чем на 3, остаток меньше 4m < B^(n+1)
+        while(r[n] || bigint_limbs::cmp(r, m_m.data(), n)>=0)
+            bigint_limbs::sub_n(r, r, m_m.data(), n+1u);
+    }
+
+}; // class BarrettReducer
+
+//----------------------------------------------------------------------------
+
+} // namespace marty
+
+#define MARTY_BIGINT_BARRETT_H
+
+// BigInt::powMod нужны и MontgomeryContext, и BarrettReducer - подключается, когда есть оба
+#include "impl/powmod.h"
+
+// marty::
+// #include "marty_bigint/barrett.h"
@@ -0,0 +1,767 @@
+/*!
+    \file
+    \brief Пачка независимых небольших BigInt в SoA-раскладке и вертикальная арифметика над ней
+ */
+#pragma once
+
+#include "marty_bigint.h"
+
+//
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(MARTY_BIGINT_X86_64_CPU_FEATURES)
+    #include <immintrin.h>
+    #define MARTY_BIGINT_BATCH_SIMD
+#endif
+
+//
+#include "undef_min_max.h"
+
+
+// #include "marty_bigint/bigint_batch.h"
+// marty::bigint_batch::
+namespace marty {
+namespace bigint_batch {
+
+
+//----------------------------------------------------------------------------
+// Числа пачки хранятся "по вертикали": слово w числа lane лежит в data[w*stride + lane],
+// так что одна и та же операция над словом w у соседних чисел - это один векторный регистр
+// (4 числа в AVX2, 8 в AVX-512). Слова - 32-битные, в дополнительном коде фиксированной
+// ширины, но каждое занимает 64-битную ячейку: произведение слов (vpmuludq) и сумма с
+// переносом помещаются в ячейку без потерь, перенос - старшая половина.
+// stride - число чисел, округлённое вверх до laneBlock, лишние числа - нули.
+// Ширина результата выбирается так, чтобы переполнения не было: сумма/разность - на слово
+// шире более широкого аргумента, произведение - сумма ширин.
+
+constexpr const std::size_t        laneBlock = 8; // под AVX-512, AVX2 берёт по половине
+constexpr const std::uint64_t      wordMask  = 0xFFFFFFFFu;
+
+// Ячейки пачки - через тот же аллокатор, что и модули BigInt: выравнивание
+// MARTY_BIGINT_HEAP_ALIGNMENT (под загрузки AVX-512) и ресурс memory_resource_scope в режиме PMR.
+// Пачка - не меньше laneBlock ячеек, так что встроенный буфер не нужен, данные всегда в куче
+using cell_allocator_t = typename std::allocator_traits<bigint_details::number_allocator_t>::template rebind_alloc<std::uint64_t>;
+
+#ifndef MARTY_BIGINT_USE_VECTOR
+
+    typedef bigint_details::basic_number_holder<std::uint64_t, 1, cell_allocator_t> cell_holder_t;
+
+#else
+
+    typedef std::vector<std::uint64_t, cell_allocator_t> cell_holder_t;
+
+#endif
+
+namespace details {
+
+// Слово, которым число расширяется влево: все единицы для отрицательных
+inline
+std::uint64_t signWord(std::uint64_t top)
+{
+    return (top>>31) ? wordMask : 0u;
+}
+
+//----------------------------------------------------------------------------
+// r = a + b или a - b (subtract), по модулю 2^(32*wr), wr>=max(wa, wb)
+inline
+void addsubScalar(std::uint64_t *r, std::size_t wr, const std::uint64_t *a, std::size_t wa, const std::uint64_t *b, std::size_t wb, std::size_t stride, bool subtract)
+{
+    const std::uint64_t flip = subtract ? wordMask : 0u;
+    for(std::size_t l=0; l!=stride; ++l)
+    {
+        const std::uint64_t extA = signWord(a[(wa-1u)*stride+l]);
+        const std::uint64_t extB = signWord(b[(wb-1u)*stride+l]);
+
+        std::uint64_t c = subtract ? 1u : 0u; // a - b = a + ~b + 1
+        for(std::size_t w=0; w!=wr; ++w)
+        {
+            const std::uint64_t x = w<wa ? a[w*stride+l] : extA;
+            const std::uint64_t y = (w<wb ? b[w*stride+l] : extB) ^ flip;
+            const std::uint64_t t = x+y+c;
+            r[w*stride+l] = t & wordMask;
+            c = t>>32;
+        }
+    }
+}
+
+// r = a * b, r - wa+wb слов и не пересекается с a и b. Сначала произведение беззнаковых
+// (как слова лежат) значений, потом поправка на знаки: если a<0, из старших wb слов вычитаем b,
+// если b<0 - из старших wa слов вычитаем a (по модулю 2^(32*(wa+wb)))
+inline
+void mulScalar(std::uint64_t *r, const std::uint64_t *a, std::size_t wa, const std::uint64_t *b, std::size_t wb, std::size_t stride)
+{
+    const std::size_t wr = wa+wb;
+    for(std::size_t l=0; l!=stride; ++l)
+    {
+        for(std::size_t w=0; w!=wr; ++w)
+            r[w*stride+l] = 0;
+
+        for(std::size_t i=0; i!=wa; ++i)
+        {
+            const std::uint64_t ai = a[i*stride+l];
+            std::uint64_t c = 0;
+            for(std::size_t j=0; j!=wb; ++j)
+            {
+                const std::uint64_t t = ai*b[j*stride+l] + r[(i+j)*stride+l] + c; // < 2^64
+                r[(i+j)*stride+l] = t & wordMask;
+                c = t>>32;
+            }
+            r[(i+wb)*stride+l] = c;
+        }
+
+        auto subAt = [&](std::size_t off, const std::uint64_t *x, std::size_t wx)
+        {
+            std::uint64_t borrow = 0;
+            for(std::size_t w=0; w!=wx; ++w)
+            {
+                const std::uint64_t t = r[(off+w)*stride+l] - x[w*stride+l] - borrow;
+                r[(off+w)*stride+l] = t & wordMask;
+                borrow = t>>63;
+            }
+        };
+
+        if (a[(wa-1u)*stride+l]>>31)
+            subAt(wa, b, wb);
+        if (b[(wb-1u)*stride+l]>>31)
+            subAt(wb, a, wa);
+    }
+}
+
+// res[l] = -1, 0, 1 - знак a-b, для l<n
+inline
+void compareScalar(int *res, std::size_t n, const std::uint64_t *a, std::size_t wa, const std::uint64_t *b, std::size_t wb, std::size_t stride)
+{
+    const std::size_t wr = std::max(wa, wb);
+    for(std::size_t l=0; l!=n; ++l)
+    {
+        const std::uint64_t extA = signWord(a[(wa-1u)*stride+l]);
+        const std::uint64_t extB = signWord(b[(wb-1u)*stride+l]);
+
+        int cmp = 0;
+        for(std::size_t w=wr; w-- && !cmp; )
+        {
+            std::uint64_t x = w<wa ? a[w*stride+l] : extA;
+            std::uint64_t y = w<wb ? b[w*stride+l] : extB;
+            if (w+1u==wr)
+            {
+                // Старшее слово - со знаком
+                x ^= 0x80000000u;
+                y ^= 0x80000000u;
+            }
+            cmp = x<y ? -1 : (x>y ? 1 : 0);
+        }
+        res[l] = cmp;
+    }
+}
+
+#if defined(MARTY_BIGINT_BATCH_SIMD)
+
+//----------------------------------------------------------------------------
+// То же, что xxxScalar, по 4 числа за раз
+__attribute__((target("avx2")))
+inline
+void addsubAvx2(std::uint64_t *r, std::size_t wr, const std::uint64_t *a, std::size_t wa, const std::uint64_t *b, std::size_t wb, std::size_t stride, bool subtract)
+{
+    const __m256i mask = _mm256_set1_epi64x(std::int64_t(wordMask));
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i flip = subtract ? mask : zero;
+    const __m256i c0   = _mm256_set1_epi64x(subtract ? 1 : 0);
+
+    for(std::size_t l=0; l<stride; l+=4u)
+    {
+        const __m256i extA = _mm256_and_si256(_mm256_sub_epi64(zero, _mm256_srli_epi64(_mm256_loadu_si256((const __m256i*)(a+(wa-1u)*stride+l)), 31)), mask);
+        const __m256i extB = _mm256_and_si256(_mm256_sub_epi64(zero, _mm256_srli_epi64(_mm256_loadu_si256((const __m256i*)(b+(wb-1u)*stride+l)), 31)), mask);
+
+        __m256i c = c0;
+        for(std::size_t w=0; w!=wr; ++w)
+        {
+            const __m256i x = w<wa ? _mm256_loadu_si256((const __m256i*)(a+w*stride+l)) : extA;
+            const __m256i y = _mm256_xor_si256(w<wb ? _mm256_loadu_si256((const __m256i*)(b+w*stride+l)) : extB, flip);
+            const __m256i t = _mm256_add_epi64(_mm256_add_epi64(x, y), c);
+            _mm256_storeu_si256((__m256i*)(r+w*stride+l), _mm256_and_si256(t, mask));
+            c = _mm256_srli_epi64(t, 32);
+        }
+    }
+}
+
+// r -= x & neg по 4 числам, wx слов с шагом stride, заём за пределы r отбрасывается
+__attribute__((target("avx2")))
+inline
+void subMaskedAvx2(std::uint64_t *r, const std::uint64_t *x, std::size_t wx, std::size_t stride, __m256i neg)
+{
+    const __m256i mask = _mm256_set1_epi64x(std::int64_t(wordMask));
+    __m256i borrow = _mm256_setzero_si256();
+    for(std::size_t w=0; w!=wx; ++w)
+    {
+        __m256i *pr = (__m256i*)(r+w*stride);
+        const __m256i xv = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(x+w*stride)), neg);
+        const __m256i t  = _mm256_sub_epi64(_mm256_sub_epi64(_mm256_loadu_si256(pr), xv), borrow);
+        _mm256_storeu_si256(pr, _mm256_and_si256(t, mask));
+        borrow = _mm256_srli_epi64(t, 63);
+    }
+}
+
+__attribute__((target("avx2")))
+inline
+void mulAvx2(std::uint64_t *r, const std::uint64_t *a, std::size_t wa, const std::uint64_t *b, std::size_t wb, std::size_t stride)
+{
+    const __m256i mask = _mm256_set1_epi64x(std::int64_t(wordMask));
+    const __m256i zero = _mm256_setzero_si256();
+    const std::size_t wr = wa+wb;
+
+    for(std::size_t l=0; l<stride; l+=4u)
+    {
+        for(std::size_t w=0; w!=wr; ++w)
+            _mm256_storeu_si256((__m256i*)(r+w*stride+l), zero);
+
+        for(std::size_t i=0; i!=wa; ++i)
+        {
+            const __m256i ai = _mm256_loadu_si256((const __m256i*)(a+i*stride+l));
+            __m256i c = zero;
+            for(std::size_t j=0; j!=wb; ++j)
+            {
+                __m256i *pr = (__m256i*)(r+(i+j)*stride+l);
+                const __m256i p = _mm256_mul_epu32(ai, _mm256_loadu_si256((const __m256i*)(b+j*stride+l)));
+                const __m256i t = _mm256_add_epi64(_mm256_add_epi64(p, _mm256_loadu_si256(pr)), c);
+                _mm256_storeu_si256(pr, _mm256_and_si256(t, mask));
+                c = _mm256_srli_epi64(t, 32);
+            }
+            _mm256_storeu_si256((__m256i*)(r+(i+wb)*stride+l), c);
+        }
+
+        // Поправка на знаки: вычитаемое обнулено у неотрицательных
+        const __m256i negA = _mm256_sub_epi64(zero, _mm256_srli_epi64(_mm256_loadu_si256((const __m256i*)(a+(wa-1u)*stride+l)), 31));
+        const __m256i negB = _mm256_sub_epi64(zero, _mm256_srli_epi64(_mm256_loadu_si256((const __m256i*)(b+(wb-1u)*stride+l)), 31));
+        subMaskedAvx2(r+wa*stride+l, b+l, wb, stride, negA);
+        subMaskedAvx2(r+wb*stride+l, a+l, wa, stride, negB);
+    }
+}
+
+__attribute__((target("avx2")))
+inline
+void compareAvx2(int *res, std::size_t n, const std::uint64_t *a, std::size_t wa, const std::uint64_t *b, std::size_t wb, std::size_t stride)
+{
+    const __m256i mask = _mm256_set1_epi64x(std::int64_t(wordMask));
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i top  = _mm256_set1_epi64x(0x80000000);
+    const std::size_t wr = std::max(wa, wb);
+
+    alignas(32) std::int64_t tmp[4];
+
+    for(std::size_t l=0; l<n; l+=4u)
+    {
+        const __m256i extA = _mm256_and_si256(_mm256_sub_epi64(zero, _mm256_srli_epi64(_mm256_loadu_si256((const __m256i*)(a+(wa-1u)*stride+l)), 31)), mask);
+        const __m256i extB = _mm256_and_si256(_mm256_sub_epi64(zero, _mm256_srli_epi64(_mm256_loadu_si256((const __m256i*)(b+(wb-1u)*stride+l)), 31)), mask);
+
+        // Слова меньше 2^32, так что знаковое 64-битное сравнение их не портит.
+        // cmp - первое ненулевое (lt - gt) со старшего слова
+        __m256i cmp = zero;
+        for(std::size_t w=wr; w--; )
+        {
+            __m256i x = w<wa ? _mm256_loadu_si256((const __m256i*)(a+w*stride+l)) : extA;
+            __m256i y = w<wb ? _mm256_loadu_si256((const __m256i*)(b+w*stride+l)) : extB;
+            if (w+1u==wr)
+            {
+                x = _mm256_xor_si256(x, top);
+                y = _mm256_xor_si256(y, top);
+            }
+            const __m256i d = _mm256_sub_epi64(_mm256_cmpgt_epi64(y, x), _mm256_cmpgt_epi64(x, y));
+            cmp = _mm256_or_si256(cmp, _mm256_and_si256(d, _mm256_cmpeq_epi64(cmp, zero)));
+        }
+
+        _mm256_store_si256((__m256i*)tmp, cmp);
+        for(std::size_t k=0; k!=4u && l+k<n; ++k)
+            res[l+k] = int(tmp[k]);
+    }
+}
+
+//----------------------------------------------------------------------------
+// И по 8 чисел за раз. GCC 12 ложно предупреждает о неинициализированном значении
+// внутри _mm512_mul_epu32
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+__attribute__((target("avx512f")))
+inline
+void addsubAvx512(std::uint64_t *r, std::size_t wr, const std::uint64_t *a, std::size_t wa, const std::uint64_t *b, std::size_t wb, std::size_t stride, bool subtract)
+{
+    const __m512i mask = _mm512_set1_epi64(std::int64_t(wordMask));
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i flip = subtract ? mask : zero;
+    const __m512i c0   = _mm512_set1_epi64(subtract ? 1 : 0);
+
+    for(std::size_t l=0; l<stride; l+=8u)
+    {
+        const __m512i extA = _mm512_and_si512(_mm512_sub_epi64(zero, _mm512_srli_epi64(_mm512_loadu_si512(a+(wa-1u)*stride+l), 31)), mask);
+        const __m512i extB = _mm512_and_si512(_mm512_sub_epi64(zero, _mm512_srli_epi64(_mm512_loadu_si512(b+(wb-1u)*stride+l), 31)), mask);
+
+        __m512i c = c0;
+        for(std::size_t w=0; w!=wr; ++w)
+        {
+            const __m512i x = w<wa ? _mm512_loadu_si512(a+w*stride+l) : extA;
+            const __m512i y = _mm512_xor_si512(w<wb ? _mm512_loadu_si512(b+w*stride+l) : extB, flip);
+            const __m512i t = _mm512_add_epi64(_mm512_add_epi64(x, y), c);
+            _mm512_storeu_si512(r+w*stride+l, _mm512_and_si512(t, mask));
+            c = _mm512_srli_epi64(t, 32);
+        }
+    }
+}
+
+// r -= x по 8 числам, только там, где бит neg установлен
+__attribute__((target("avx512f")))
+inline
+void subMaskedAvx512(std::uint64_t *r, const std::uint64_t *x, std::size_t wx, std::size_t stride, __mmask8 neg)
+{
+    const __m512i mask = _mm512_set1_epi64(std::int64_t(wordMask));
+    __m512i borrow = _mm512_setzero_si512();
+    for(std::size_t w=0; w!=wx; ++w)
+    {
+        std::uint64_t *pr = r+w*stride;
+        const __m512i xv = _mm512_maskz_loadu_epi64(neg, x+w*stride);
+        const __m512i t  = _mm512_sub_epi64(_mm512_sub_epi64(_mm512_loadu_si512(pr), xv), borrow);
+        _mm512_storeu_si512(pr, _mm512_and_si512(t, mask));
+        borrow = _mm512_srli_epi64(t, 63);
+    }
+}
+
+__attribute__((target("avx512f")))
+inline
+void mulAvx512(std::uint64_t *r, const std::uint64_t *a, std::size_t wa, const std::uint64_t *b, std::size_t wb, std::size_t stride)
+{
+    const __m512i mask = _mm512_set1_epi64(std::int64_t(wordMask));
+    const __m512i zero = _mm512_setzero_si512();
+    const std::size_t wr = wa+wb;
+
+    for(std::size_t l=0; l<stride; l+=8u)
+    {
+        for(std::size_t w=0; w!=wr; ++w)
+            _mm512_storeu_si512(r+w*stride+l, zero);
+
+        for(std::size_t i=0; i!=wa; ++i)
+        {
+            const __m512i ai = _mm512_loadu_si512(a+i*stride+l);
+            __m512i c = zero;
+            for(std::size_t j=0; j!=wb; ++j)
+            {
+                std::uint64_t *pr = r+(i+j)*stride+l;
+                const __m512i p = _mm512_mul_epu32(ai, _mm512_loadu_si512(b+j*stride+l));
+                const __m512i t = _mm512_add_epi64(_mm512_add_epi64(p, _mm512_loadu_si512(pr)), c);
+                _mm512_storeu_si512(pr, _mm512_and_si512(t, mask));
+                c = _mm512_srli_epi64(t, 32);
+            }
+            _mm512_storeu_si512(r+(i+wb)*stride+l, c);
+        }
+
+        const __m512i bit31 = _mm512_set1_epi64(0x80000000);
+        subMaskedAvx512(r+wa*stride+l, b+l, wb, stride, _mm512_test_epi64_mask(_mm512_loadu_si512(a+(wa-1u)*stride+l), bit31));
+        subMaskedAvx512(r+wb*stride+l, a+l, wa, stride, _mm512_test_epi64_mask(_mm512_loadu_si512(b+(wb-1u)*stride+l), bit31));
+    }
+}
+
+__attribute__((target("avx512f")))
+inline
+void compareAvx512(int *res, std::size_t n, const std::uint64_t *a, std::size_t wa, const std::uint64_t *b, std::size_t wb, std::size_t stride)
+{
+    const __m512i mask = _mm512_set1_epi64(std::int64_t(wordMask));
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i top  = _mm512_set1_epi64(0x80000000);
+    const std::size_t wr = std::max(wa, wb);
+
+    for(std::size_t l=0; l<n; l+=8u)
+    {
+        const __m512i extA = _mm512_and_si512(_mm512_sub_epi64(zero, _mm512_srli_epi64(_mm512_loadu_si512(a+(wa-1u)*stride+l), 31)), mask);
+        const __m512i extB = _mm512_and_si512(_mm512_sub_epi64(zero, _mm512_srli_epi64(_mm512_loadu_si512(b+(wb-1u)*stride+l), 31)), mask);
+
+        // Маски: уже решено, и среди решённых - где a<b, где a>b
+        __mmask8 lt = 0, gt = 0;
+        for(std::size_t w=wr; w--; )
+        {
+            __m512i x = w<wa ? _mm512_loadu_si512(a+w*stride+l) : extA;
+            __m512i y = w<wb ? _mm512_loadu_si512(b+w*stride+l) : extB;
+            if (w+1u==wr)
+            {
+                x = _mm512_xor_si512(x, top);
+                y = _mm512_xor_si512(y, top);
+            }
+            const __mmask8 open = __mmask8(~(lt|gt));
+            lt = __mmask8(lt | _mm512_mask_cmplt_epu64_mask(open, x, y));
+            gt = __mmask8(gt | _mm512_mask_cmpgt_epu64_mask(open, x, y));
+        }
+
+        for(std::size_t k=0; k!=8u && l+k<n; ++k)
+            res[l+k] = ((lt>>k)&1u) ? -1 : (((gt>>k)&1u) ? 1 : 0);
+    }
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic pop
+#endif
+
+#endif // MARTY_BIGINT_BATCH_SIMD
+
+//----------------------------------------------------------------------------
+enum class simd_level
+{
+    scalar,
+    avx2,
+    avx512
+};
+
+inline
+simd_level detectSimdLevel()
+{
+#if defined(MARTY_BIGINT_BATCH_SIMD)
+    if (bigint_limbs::details::cpuHasAvx512f())
+        return simd_level::avx512;
+    if (bigint_limbs::details::cpuHasAvx2())
+        return simd_level::avx2;
+#endif
+    return simd_level::scalar;
+}
+
+inline
+simd_level simdLevel()
+{
+    static const simd_level level = detectSimdLevel();
+    return level;
+}
+
+} // namespace details
+
+//----------------------------------------------------------------------------
+//! r = a + b (subtract - a - b) для всех чисел пачки, wr>=max(wa, wb) слов, по модулю 2^(32*wr).
+//! r может совпадать с a или b, если у них та же ширина
+inline
+void addsub(std::uint64_t *r, std::size_t wr, const std::uint64_t *a, std::size_t wa, const std::uint64_t *b, std::size_t wb, std::size_t stride, bool subtract)
+{
+    switch(details::simdLevel())
+    {
+#if defined(MARTY_BIGINT_BATCH_SIMD)
+        case details::simd_level::avx512: details::addsubAvx512(r, wr, a, wa, b, wb, stride, subtract); return;
+        case details::simd_level::avx2  : details::addsubAvx2  (r, wr, a, wa, b, wb, stride, subtract); return;
+#endif
+        default: details::addsubScalar(r, wr, a, wa, b, wb, stride, subtract);
+    }
+}
+
+//! r = a * b для всех чисел пачки, r - wa+wb слов и не пересекается с a и b
+inline
+void mul(std::uint64_t *r, const std::uint64_t *a, std::size_t wa, const std::uint64_t *b, std::size_t wb, std::size_t stride)
+{
+    switch(details::simdLevel())
+    {
+#if defined(MARTY_BIGINT_BATCH_SIMD)
+        case details::simd_level::avx512: details::mulAvx512(r, a, wa, b, wb, stride); return;
+        case details::simd_level::avx2  : details::mulAvx2  (r, a, wa, b, wb, stride); return;
+#endif
+        default: details::mulScalar(r, a, wa, b, wb, stride);
+    }
+}
+
+//! res[i] = -1, 0, 1 - знак a[i]-b[i], для первых n чисел
+inline
+void compare(int *res, std::size_t n, const std::uint64_t *a, std::size_t wa, const std::uint64_t *b, std::size_t wb, std::size_t stride)
+{
+    switch(details::simdLevel())
+    {
+#if defined(MARTY_BIGINT_BATCH_SIMD)
+        case details::simd_level::avx512: details::compareAvx512(res, n, a, wa, b, wb, stride); return;
+        case details::simd_level::avx2  : details::compareAvx2  (res, n, a, wa, b, wb, stride); return;
+#endif
+        default: details::compareScalar(res, n, a, wa, b, wb, stride);
+    }
+}
+
+} // namespace bigint_batch
+
+//----------------------------------------------------------------------------
+//! Пачка независимых BigInt одной ширины для поэлементной арифметики: a[i]+b[i], a[i]*b[i] и т.п.
+//! сразу для всех i. Числа лежат по вертикали (см. bigint_batch), операции идут векторными
+//! командами по 4-8 чисел и без аллокаций на каждое число - выгодно для множества небольших
+//! (до десятка-другого чанков) значений. Результаты точные: ширина растёт так, чтобы не было
+//! переполнения, shrinkToFit() возвращает её к минимально нужной
+class BigIntBatch
+{
+    bigint_batch::cell_holder_t m_data;
+    std::size_t                 m_size   = 0; // чисел
+    std::size_t                 m_stride = 0; // m_size, округлённый до bigint_batch::laneBlock
+    std::size_t                 m_width  = 1; // 32-битных слов на число
+
+public:
+
+    BigIntBatch() {}
+
+    //! size нулей шириной width 32-битных слов
+    explicit BigIntBatch(std::size_t size, std::size_t width = 1)
+    {
+        reset(size, width);
+    }
+
+    template<typename InputIt>
+    BigIntBatch(InputIt b, InputIt e)
+    {
+        assign(b, e);
+    }
+
+    explicit BigIntBatch(const std::vector<BigInt> &v)
+    {
+        assign(v.begin(), v.end());
+    }
+
+    std::size_t size()  const { return m_size;  }
+    std::size_t width() const { return m_width; } // в 32-битных словах
+    bool        empty() const { return m_size==0; }
+
+    //! Сырые слова для своих вертикальных алгоритмов поверх bigint_batch::, слово w числа i -
+    //! data()[w*stride()+i]
+    const std::uint64_t* data()   const { return m_data.data(); }
+    std::size_t          stride() const { return m_stride; }
+
+    template<typename InputIt>
+    void assign(InputIt b, InputIt e)
+    {
+        using category = typename std::iterator_traits<InputIt>::iterator_category;
+        if constexpr (!std::is_base_of_v<std::forward_iterator_tag, category>)
+        {
+            // Однопроходный итератор - сначала копируем
+            const std::vector<BigInt> tmp(b, e);
+            assign(tmp.begin(), tmp.end());
+        }
+        else
+        {
+            // Ширину считаем первым проходом, значения кладём вторым
+            std::size_t width = 1;
+            for(auto it=b; it!=e; ++it)
+                width = std::max(width, wordsFor(*it));
+
+            reset(std::size_t(std::distance(b, e)), width);
+            std::size_t i = 0;
+            for(auto it=b; it!=e; ++it, ++i)
+                putValue(i, *it);
+        }
+    }
+
+    //! Если значение не влезает в текущую ширину - пачка расширяется
+    void set(std::size_t i, const BigInt &v)
+    {
+        checkIndex(i);
+        const std::size_t w = wordsFor(v);
+        if (w>m_width)
+            setWidth(w);
+        putValue(i, v);
+    }
+
+    BigInt get(std::size_t i) const
+    {
+        checkIndex(i);
+
+        // Модуль в 32-битных словах, затем упаковка в чанки BigInt
+        std::vector<std::uint32_t> words(m_width);
+        for(std::size_t w=0; w!=m_width; ++w)
+            words[w] = std::uint32_t(m_data[w*m_stride+i]);
+
+        int sign = 1;
+        if (words.back()>>31)
+        {
+            sign = -1;
+            std::uint64_t c = 1;
+            for(auto &x : words)
+            {
+                const std::uint64_t t = std::uint64_t(std::uint32_t(~x)) + c;
+                x = std::uint32_t(t);
+                c = t>>32;
+            }
+        }
+
+        using chunk_type = BigInt::chunk_type;
+        constexpr std::size_t chunkBits = sizeof(chunk_type)*CHAR_BIT;
+
+        std::vector<chunk_type> chunks((m_width*32u+chunkBits-1u)/chunkBits, chunk_type(0));
+        for(std::size_t bit=0; bit<m_width*32u; bit+=std::min<std::size_t>(chunkBits, 32u))
+        {
+            const std::uint32_t x = words[bit/32u] >> (bit%32u);
+            chunks[bit/chunkBits] = chunk_type(chunks[bit/chunkBits] | (chunk_type(x) << (bit%chunkBits)));
+        }
+
+        const BigInt res = BigInt::fromChunks(sign, chunks.data(), chunks.size());
+        return res;
+    }
+
+    BigInt operator[](std::size_t i) const { return get(i); }
+
+    std::vector<BigInt> toVector() const
+    {
+        std::vector<BigInt> res;
+        res.reserve(m_size);
+        for(std::size_t i=0; i!=m_size; ++i)
+            res.emplace_back(get(i));
+        return res;
+    }
+
+    //! Минимальная ширина, в которую влезают все числа пачки
+    void shrinkToFit()
+    {
+        std::size_t w = m_width;
+        for(; w>1u; --w)
+        {
+            // Старшее слово лишнее, если у всех чисел оно - знаковое расширение предыдущего
+            const std::uint64_t *hi = m_data.data() + (w-1u)*m_stride;
+            const std::uint64_t *lo = m_data.data() + (w-2u)*m_stride;
+            std::size_t i = 0;
+            for(; i!=m_size; ++i)
+            {
+                if (hi[i]!=bigint_batch::details::signWord(lo[i]))
+                    break;
+            }
+            if (i!=m_size)
+                break;
+        }
+
+        m_width = w;
+        m_data.resize(m_width*m_stride);
+    }
+
+    BigIntBatch operator+(const BigIntBatch &b) const { return addsubImpl(b, false); }
+    BigIntBatch operator-(const BigIntBatch &b) const { return addsubImpl(b, true ); }
+
+    BigIntBatch operator*(const BigIntBatch &b) const
+    {
+        checkSize(b);
+        BigIntBatch res;
+        res.reset(m_size, m_width+b.m_width, false);
+        bigint_batch::mul(res.m_data.data(), m_data.data(), m_width, b.m_data.data(), b.m_width, m_stride);
+        return res;
+    }
+
+    BigIntBatch& operator+=(const BigIntBatch &b) { *this = *this + b; return *this; }
+    BigIntBatch& operator-=(const BigIntBatch &b) { *this = *this - b; return *this; }
+    BigIntBatch& operator*=(const BigIntBatch &b) { *this = *this * b; return *this; }
+
+    //! res[i] = -1, 0, 1 - знак (*this)[i] - b[i]
+    std::vector<int> compare(const BigIntBatch &b) const
+    {
+        checkSize(b);
+        std::vector<int> res(m_size);
+        if (m_size)
+            bigint_batch::compare(res.data(), m_size, m_data.data(), m_width, b.m_data.data(), b.m_width, m_stride);
+        return res;
+    }
+
+protected:
+
+    void checkIndex(std::size_t i) const
+    {
+        if (i>=m_size)
+            throw std::out_of_range("BigIntBatch: index out of range");
+    }
+
+    void checkSize(const BigIntBatch &b) const
+    {
+        if (m_size!=b.m_size)
+            throw std::invalid_argument("BigIntBatch: batch sizes differ");
+    }
+
+    void reset(std::size_t size, std::size_t width, bool clear = true)
+    {
+        m_size   = size;
+        m_stride = (size+bigint_batch::laneBlock-1u)/bigint_batch::laneBlock*bigint_batch::laneBlock;
+        m_width  = std::max<std::size_t>(width, 1u);
+        if (clear)
+            m_data.assign(m_width*m_stride, 0u);
+        else
+            m_data.resize(m_width*m_stride);
+    }
+
+    // Расширение со знаком, только в большую сторону
+    void setWidth(std::size_t width)
+    {
+        m_data.resize(width*m_stride);
+        for(std::size_t w=m_width; w!=width; ++w)
+        {
+            for(std::size_t i=0; i!=m_stride; ++i)
+                m_data[w*m_stride+i] = bigint_batch::details::signWord(m_data[(m_width-1u)*m_stride+i]);
+        }
+        m_width = width;
+    }
+
+    // Сколько 32-битных слов нужно числу в дополнительном коде
+    static std::size_t wordsFor(const BigInt &v)
+    {
+        using chunk_type = BigInt::chunk_type;
+        constexpr std::size_t chunkBits = sizeof(chunk_type)*CHAR_BIT;
+
+        const chunk_type *p = v.chunksData();
+        std::size_t       n = v.sign() ? v.chunksSize() : 0u;
+        while(n && !p[n-1u])
+            --n;
+        if (!n)
+            return 1;
+
+        std::size_t bits = (n-1u)*chunkBits;
+        for(chunk_type top=p[n-1u]; top; top = chunk_type(top>>1))
+            ++bits;
+
+        return (bits+1u+31u)/32u; // плюс знаковый бит
+    }
+
+    // Ширина уже достаточная
+    void putValue(std::size_t i, const BigInt &v)
+    {
+        using chunk_type = BigInt::chunk_type;
+        constexpr std::size_t chunkBits = sizeof(chunk_type)*CHAR_BIT;
+
+        const chunk_type *p = v.chunksData();
+        const std::size_t n = v.sign() ? v.chunksSize() : 0u;
+
+        // Модуль по 32 бита, для отрицательных - сразу дополнение (~x + 1)
+        const bool    neg = v.sign()<0;
+        std::uint64_t c   = neg ? 1u : 0u;
+        for(std::size_t w=0; w!=m_width; ++w)
+        {
+            std::uint32_t x = 0;
+            for(std::size_t bit=w*32u; bit<w*32u+32u; bit+=std::min<std::size_t>(chunkBits, 32u))
+            {
+                const std::size_t idx = bit/chunkBits;
+                if (idx<n)
+                    x |= std::uint32_t(std::uint64_t(p[idx]) >> (bit%chunkBits)) << (bit%32u);
+            }
+
+            if (neg)
+            {
+                const std::uint64_t t = std::uint64_t(std::uint32_t(~x)) + c;
+                x = std::uint32_t(t);
+                c = t>>32;
+            }
+
+            m_data[w*m_stride+i] = x;
+        }
+    }
+
+    BigIntBatch addsubImpl(const BigIntBatch &b, bool subtract) const
+    {
+        checkSize(b);
+        BigIntBatch res;
+        res.reset(m_size, std::max(m_width, b.m_width)+1u, false);
+        bigint_batch::addsub(res.m_data.data(), res.m_width, m_data.data(), m_width, b.m_data.data(), b.m_width, m_stride, subtract);
+        return res;
+    }
+
+}; // class BigIntBatch
+
+//----------------------------------------------------------------------------
+
+} // namespace marty
+
+// marty::
+// #include "marty_bigint/bigint_batch.h"
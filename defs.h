@@ -46,5 +46,102 @@
     #define MARTY_BIGINT_ARITHMETIC_CONVERTION_TYPE
 #endif
 
+// Есть ли 128ми битный тип - нужен как двойной тип для 64х битных чанков.
+// Без него 64х битные чанки тоже работают, но через интринсики или переносимую эмуляцию
+#if !defined(MARTY_BIGINT_HAS_INT128)
+    #if defined(__SIZEOF_INT128__)
+        #define MARTY_BIGINT_HAS_INT128 1
+    #else
+        #define MARTY_BIGINT_HAS_INT128 0
+    #endif
+#endif
+
+// Размер встроенного буфера модуля BigInt в байтах. Числа, влезающие в этот буфер,
+// хранятся без аллокации. Количество чанков можно задать явно через MARTY_BIGINT_INLINE_CAPACITY
+#if !defined(MARTY_BIGINT_INLINE_BUFFER_SIZE)
+    #define MARTY_BIGINT_INLINE_BUFFER_SIZE 32
+#endif
+
+// Выравнивание буфера модуля BigInt, выделяемого в куче - по умолчанию размер кэш-линии
+#if !defined(MARTY_BIGINT_HEAP_ALIGNMENT)
+    #define MARTY_BIGINT_HEAP_ALIGNMENT 64
+#endif
+
+// Режим std::pmr - модуль BigInt аллоцируется через std::pmr::memory_resource,
+// текущий ресурс задаётся для потока через bigint_details::memory_resource_scope
+#if !defined(MARTY_BIGINT_USE_PMR)
+    #define MARTY_BIGINT_USE_PMR 0
+#endif
+
+// Ассемблерные вставки для x86-64 (GCC/clang) - цепочки adc/sbb в сложении/вычитании,
+// mulx/adcx/adox в умножении на чанк (выбирается в рантайме, если процессор умеет ADX/BMI2).
+// 0 - только переносимый код
+#if !defined(MARTY_BIGINT_USE_ASM)
+    #define MARTY_BIGINT_USE_ASM 1
+#endif
+
+// Пороги алгоритмов ниже - усреднённые. Под конкретную машину и тип чанка их подбирает
+// tests/tune-thresholds-*.cpp, результат - marty_bigint_tuning.h с макросами MARTY_BIGINT_TUNING_xxx.
+// Если такой файл лежит рядом с defs.h или в путях поиска заголовков - берём пороги из него, но
+// только если размер чанка тот же, что и при подборе (MARTY_BIGINT_TUNING_CHUNK_BITS, проверка -
+// в types.h), иначе - значения по умолчанию. Явно заданные макросы (-D...) важнее.
+// Пороги можно поменять и в рантайме - BigInt::setMulThresholds
+#if !defined(MARTY_BIGINT_NO_TUNING_HEADER) && defined(__has_include)
+    #if __has_include("marty_bigint_tuning.h")
+        #include "marty_bigint_tuning.h"
+    #endif
+#endif
+
+#if defined(MARTY_BIGINT_TUNING_CHUNK_BITS)
+    #define MARTY_BIGINT_TUNED_THRESHOLD(name, defaultValue)  (::marty::bigint_details::tuning_chunk_matches ? std::size_t(MARTY_BIGINT_TUNING_##name) : std::size_t(defaultValue))
+#else
+    #define MARTY_BIGINT_TUNED_THRESHOLD(name, defaultValue)  (defaultValue)
+#endif
+
+// Порог (в чанках меньшего множителя), начиная с которого умножение идёт по Карацубе.
+// Ниже порога - school/comba, в том числе на нижних уровнях рекурсии Карацубы
+#if !defined(MARTY_BIGINT_KARATSUBA_THRESHOLD)
+    #define MARTY_BIGINT_KARATSUBA_THRESHOLD MARTY_BIGINT_TUNED_THRESHOLD(KARATSUBA_THRESHOLD, 32)
+#endif
+
+// Порог Карацубы для квадратов (sqr): квадрат "столбиком" вдвое дешевле произведения,
+// поэтому порог выше. Меньше MARTY_BIGINT_KARATSUBA_THRESHOLD не бывает
+#if !defined(MARTY_BIGINT_SQR_KARATSUBA_THRESHOLD)
+    #define MARTY_BIGINT_SQR_KARATSUBA_THRESHOLD MARTY_BIGINT_TUNED_THRESHOLD(SQR_KARATSUBA_THRESHOLD, 48)
+#endif
+
+// Пороги Тоома-Кука 3 и 4 (тоже в чанках меньшего множителя)
+#if !defined(MARTY_BIGINT_TOOM3_THRESHOLD)
+    #define MARTY_BIGINT_TOOM3_THRESHOLD MARTY_BIGINT_TUNED_THRESHOLD(TOOM3_THRESHOLD, 200)
+#endif
+
+#if !defined(MARTY_BIGINT_TOOM4_THRESHOLD)
+    #define MARTY_BIGINT_TOOM4_THRESHOLD MARTY_BIGINT_TUNED_THRESHOLD(TOOM4_THRESHOLD, 600)
+#endif
+
+// Порог несбалансированных Тоомов (Тоом-2.5 и Тоом-3.5, в чанках меньшего множителя) -
+// когда длинный множитель в 1.5-2.5 раза длиннее короткого. Ниже порога - шаг Карацубы или нарезка
+#if !defined(MARTY_BIGINT_TOOM32_THRESHOLD)
+    #define MARTY_BIGINT_TOOM32_THRESHOLD MARTY_BIGINT_TUNED_THRESHOLD(TOOM32_THRESHOLD, 120)
+#endif
+
+// Порог FFT в double (в чанках меньшего множителя). Выше - FFT, пока для него гарантирована
+// точность, дальше - NTT
+#if !defined(MARTY_BIGINT_FFT_THRESHOLD)
+    #define MARTY_BIGINT_FFT_THRESHOLD MARTY_BIGINT_TUNED_THRESHOLD(FFT_THRESHOLD, 6000)
+#endif
+
+// Порог NTT (в чанках меньшего множителя)
+#if !defined(MARTY_BIGINT_NTT_THRESHOLD)
+    #define MARTY_BIGINT_NTT_THRESHOLD MARTY_BIGINT_TUNED_THRESHOLD(NTT_THRESHOLD, 40000)
+#endif
+
+// Порог многопоточного умножения (в чанках меньшего множителя), если в контексте арифметики
+// задан пул потоков (BigInt::arithmetic_context::setThreadPool). Выше порога ветки рекурсии
+// Тоома и преобразования FFT/NTT идут задачами пула, ниже - всё в вызывающем потоке
+#if !defined(MARTY_BIGINT_PARALLEL_THRESHOLD)
+    #define MARTY_BIGINT_PARALLEL_THRESHOLD 1500
+#endif
+
 // Надо настроить MARTY_BIGINT_FORCE_NUMBER_UNDERLYING_TYPE в std::uint8_t
 // если задан макрос MARTY_BIGINT_USE_MIN_SIZE_CHUNKS != 0
@@ -0,0 +1,723 @@
+/*!
+    \file
+    \brief Умножение чанков через комплексное FFT в double, с гарантией точности
+ */
+#pragma once
+
+#include "limbs.h"
+
+//
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <utility>
+
+#if defined(MARTY_BIGINT_X86_64_CPU_FEATURES)
+    #include <immintrin.h>
+    #define MARTY_BIGINT_FFT_AVX2
+#endif
+
+//
+#include "undef_min_max.h"
+
+
+// #include "marty_bigint/fft.h"
+// marty::bigint_limbs::
+namespace marty {
+namespace bigint_limbs {
+
+
+//----------------------------------------------------------------------------
+// Множители режутся на куски по pb бит (не больше 16), два вещественных множителя
+// упаковываются в один комплексный массив a + i*b, так что на умножение - одно прямое
+// и одно обратное преобразование. Комплексные массивы хранятся раздельно (re и im),
+// так бабочки векторизуются без перестановок.
+//
+// Точность: ошибка FFT-свёртки (Percival, "Rapid multiplication modulo the sum and
+// difference of highly composite numbers") не больше n * 2^(2pb) * eps * O(log n).
+// Берём её с запасом, n * 2^(2pb) * 2^-53 * 20*(log n + 1), и выбираем самые длинные
+// куски, при которых она меньше 1/4 - тогда округление до целого всегда верное.
+// Дополнительно проверяем фактическое отклонение от целых; если оценка не выполнима
+// (слишком большие числа) или проверка не прошла, mul_fft возвращает false,
+// и надо умножать чем-то другим (NTT).
+
+namespace details {
+
+constexpr const int fftMaxPieceBits = 16;
+constexpr const int fftMinPieceBits = 8;
+constexpr const int fftMaxLog       = 23; // 4*2^23 double - 256Mb рабочей области, дальше - NTT
+
+//----------------------------------------------------------------------------
+inline
+std::size_t fftSize(std::size_t na, std::size_t nb)
+{
+    std::size_t n = 1;
+    while(n<na+nb-1u)
+        n *= 2u;
+    return n;
+}
+
+inline
+int fftLog2(std::size_t n)
+{
+    int k = 0;
+    while((std::size_t(1)<<k)<n)
+        ++k;
+    return k;
+}
+
+template<typename T>
+inline
+std::size_t fftPiecesCount(std::size_t n, int pb)
+{
+    return (n*std::size_t(limbBits<T>()) + std::size_t(pb) - 1u)/std::size_t(pb);
+}
+
+// Самые длинные куски, для которых оценка ошибки меньше 1/4; 0 - таких нет
+template<typename T>
+inline
+int fftPieceBits(std::size_t an, std::size_t bn)
+{
+    for(int pb=fftMaxPieceBits; pb>=fftMinPieceBits; --pb)
+    {
+        const std::size_t n = fftSize(fftPiecesCount<T>(an, pb), fftPiecesCount<T>(bn, pb));
+        const int         k = fftLog2(n);
+        if (k>fftMaxLog)
+            return 0; // дальше куски короче, а n только больше
+
+        const double bound = std::ldexp(double(n)*20.0*double(k+1), 2*pb-53);
+        if (bound<0.25)
+            return pb;
+    }
+
+    return 0;
+}
+
+// pb бит начиная с бита pos; за пределами a - нули
+template<typename T>
+inline
+std::uint32_t fftGetBits(const T *a, std::size_t an, std::size_t pos, int pb)
+{
+    constexpr std::size_t lb = std::size_t(limbBits<T>());
+
+    std::uint32_t v   = 0;
+    int           got = 0;
+    while(got<pb)
+    {
+        const std::size_t idx = pos/lb;
+        if (idx>=an)
+            break;
+
+        const int off  = int(pos%lb);
+        const int take = std::min(pb-got, int(lb)-off);
+        v   |= std::uint32_t((std::uint64_t(a[idx])>>off) & ((std::uint64_t(1)<<take)-1u)) << got;
+        got += take;
+        pos += std::size_t(take);
+    }
+
+    return v;
+}
+
+// Дописывает pb бит начиная с бита pos (там должны быть нули); то, что за пределами r, отбрасывается
+template<typename T>
+inline
+void fftOrBits(T *r, std::size_t rn, std::size_t pos, std::uint32_t v, int pb)
+{
+    constexpr std::size_t lb = std::size_t(limbBits<T>());
+
+    while(pb>0)
+    {
+        const std::size_t idx = pos/lb;
+        if (idx>=rn)
+            break;
+
+        const int off  = int(pos%lb);
+        const int take = std::min(pb, int(lb)-off);
+        r[idx] = T(r[idx] | T(T(v & ((std::uint32_t(1)<<take)-1u))<<off));
+        v  >>= take;
+        pb  -= take;
+        pos += std::size_t(take);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Таблица корней: w[h+j] = exp(-2*pi*i*j/(2h)), h = 1, 2, 4, ..., n/2, j<h.
+// Каждый уровень - прореженный старший, а старший считается через cos/sin напрямую
+// (без рекуррентного домножения, которое накапливает ошибку), причём только на 1/8
+// круга - остальное по симметрии, точно
+inline
+void fftMakeRoots(double *wr, double *wi, std::size_t n)
+{
+    if (n<2u)
+        return;
+
+    const std::size_t half = n/2u;
+    double *topR = wr + half;
+    double *topI = wi + half;
+
+    const double pi = 3.14159265358979323846;
+
+    if (n<8u)
+    {
+        for(std::size_t j=0; j!=half; ++j)
+        {
+            const double ang = 2.0*pi*double(j)/double(n);
+            topR[j] =  std::cos(ang);
+            topI[j] = -std::sin(ang);
+        }
+    }
+    else
+    {
+        const std::size_t q = n/8u;
+        for(std::size_t j=0; j<=q; ++j)
+        {
+            const double ang = 2.0*pi*double(j)/double(n);
+            const double c   = std::cos(ang);
+            const double s   = std::sin(ang);
+
+            topR[j] = c;  topI[j] = -s;                     // x
+            topR[2u*q-j] = s;  topI[2u*q-j] = -c;           // pi/2 - x
+            if (2u*q+j<half)
+            {
+                topR[2u*q+j] = -s;  topI[2u*q+j] = -c;      // pi/2 + x
+            }
+            if (j)
+            {
+                topR[half-j] = -c;  topI[half-j] = -s;      // pi - x
+            }
+        }
+    }
+
+    for(std::size_t h=half/2u; h; h/=2u)
+    {
+        const std::size_t step = half/h;
+        for(std::size_t j=0; j!=h; ++j)
+        {
+            wr[h+j] = topR[j*step];
+            wi[h+j] = topI[j*step];
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+#if defined(MARTY_BIGINT_FFT_AVX2)
+
+__attribute__((target("avx2")))
+inline
+void fftForwardStageAvx2(double *re, double *im, std::size_t n, std::size_t h, const double *wr, const double *wi)
+{
+    for(std::size_t i=0; i<n; i+=2u*h)
+    {
+        double *xr = re+i;
+        double *xi = im+i;
+        double *yr = re+i+h;
+        double *yi = im+i+h;
+        for(std::size_t j=0; j<h; j+=4u)
+        {
+            const __m256d ur = _mm256_loadu_pd(xr+j);
+            const __m256d ui = _mm256_loadu_pd(xi+j);
+            const __m256d vr = _mm256_loadu_pd(yr+j);
+            const __m256d vi = _mm256_loadu_pd(yi+j);
+            const __m256d c  = _mm256_loadu_pd(wr+j);
+            const __m256d s  = _mm256_loadu_pd(wi+j);
+
+            _mm256_storeu_pd(xr+j, _mm256_add_pd(ur, vr));
+            _mm256_storeu_pd(xi+j, _mm256_add_pd(ui, vi));
+
+            const __m256d dr = _mm256_sub_pd(ur, vr);
+            const __m256d di = _mm256_sub_pd(ui, vi);
+            _mm256_storeu_pd(yr+j, _mm256_sub_pd(_mm256_mul_pd(dr, c), _mm256_mul_pd(di, s)));
+            _mm256_storeu_pd(yi+j, _mm256_add_pd(_mm256_mul_pd(dr, s), _mm256_mul_pd(di, c)));
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+inline
+void fftInverseStageAvx2(double *re, double *im, std::size_t n, std::size_t h, const double *wr, const double *wi)
+{
+    for(std::size_t i=0; i<n; i+=2u*h)
+    {
+        double *xr = re+i;
+        double *xi = im+i;
+        double *yr = re+i+h;
+        double *yi = im+i+h;
+        for(std::size_t j=0; j<h; j+=4u)
+        {
+            const __m256d ur = _mm256_loadu_pd(xr+j);
+            const __m256d ui = _mm256_loadu_pd(xi+j);
+            const __m256d br = _mm256_loadu_pd(yr+j);
+            const __m256d bi = _mm256_loadu_pd(yi+j);
+            const __m256d c  = _mm256_loadu_pd(wr+j);
+            const __m256d s  = _mm256_loadu_pd(wi+j);
+
+            // v = y * conj(w)
+            const __m256d vr = _mm256_add_pd(_mm256_mul_pd(br, c), _mm256_mul_pd(bi, s));
+            const __m256d vi = _mm256_sub_pd(_mm256_mul_pd(bi, c), _mm256_mul_pd(br, s));
+
+            _mm256_storeu_pd(xr+j, _mm256_add_pd(ur, vr));
+            _mm256_storeu_pd(xi+j, _mm256_add_pd(ui, vi));
+            _mm256_storeu_pd(yr+j, _mm256_sub_pd(ur, vr));
+            _mm256_storeu_pd(yi+j, _mm256_sub_pd(ui, vi));
+        }
+    }
+}
+
+#endif
+
+//----------------------------------------------------------------------------
+// Этап прямого преобразования (прореживание по частоте) с полублоком h
+inline
+void fftForwardStage(double *re, double *im, std::size_t n, std::size_t h, const double *wr, const double *wi, bool avx2)
+{
+    wr += h;
+    wi += h;
+
+#if defined(MARTY_BIGINT_FFT_AVX2)
+    if (avx2 && h>=4u)
+    {
+        fftForwardStageAvx2(re, im, n, h, wr, wi);
+        return;
+    }
+#else
+    (void)avx2;
+#endif
+
+    for(std::size_t i=0; i<n; i+=2u*h)
+    {
+        double *xr = re+i;
+        double *xi = im+i;
+        double *yr = re+i+h;
+        double *yi = im+i+h;
+        for(std::size_t j=0; j!=h; ++j)
+        {
+            const double ur = xr[j], ui = xi[j];
+            const double vr = yr[j], vi = yi[j];
+            xr[j] = ur+vr;
+            xi[j] = ui+vi;
+            const double dr = ur-vr, di = ui-vi;
+            yr[j] = dr*wr[j] - di*wi[j];
+            yi[j] = dr*wi[j] + di*wr[j];
+        }
+    }
+}
+
+// Этап обратного преобразования (прореживание по времени), корни сопряжённые
+inline
+void fftInverseStage(double *re, double *im, std::size_t n, std::size_t h, const double *wr, const double *wi, bool avx2)
+{
+    wr += h;
+    wi += h;
+
+#if defined(MARTY_BIGINT_FFT_AVX2)
+    if (avx2 && h>=4u)
+    {
+        fftInverseStageAvx2(re, im, n, h, wr, wi);
+        return;
+    }
+#else
+    (void)avx2;
+#endif
+
+    for(std::size_t i=0; i<n; i+=2u*h)
+    {
+        double *xr = re+i;
+        double *xi = im+i;
+        double *yr = re+i+h;
+        double *yi = im+i+h;
+        for(std::size_t j=0; j!=h; ++j)
+        {
+            const double vr = yr[j]*wr[j] + yi[j]*wi[j];
+            const double vi = yi[j]*wr[j] - yr[j]*wi[j];
+            const double ur = xr[j], ui = xi[j];
+            xr[j] = ur+vr;
+            xi[j] = ui+vi;
+            yr[j] = ur-vr;
+            yi[j] = ui-vi;
+        }
+    }
+}
+
+// Два последних этапа прямого (h=2 и h=1) одним проходом - корни там 1 и -i, без умножений
+inline
+void fftForwardLast2(double *re, double *im, std::size_t n)
+{
+    for(std::size_t i=0; i<n; i+=4u)
+    {
+        double *xr = re+i;
+        double *xi = im+i;
+
+        const double a0r = xr[0]+xr[2], a0i = xi[0]+xi[2];
+        const double a1r = xr[1]+xr[3], a1i = xi[1]+xi[3];
+        const double a2r = xr[0]-xr[2], a2i = xi[0]-xi[2];
+        const double a3r = xi[1]-xi[3], a3i = xr[3]-xr[1]; // (x1-x3)*(-i)
+
+        xr[0] = a0r+a1r;  xi[0] = a0i+a1i;
+        xr[1] = a0r-a1r;  xi[1] = a0i-a1i;
+        xr[2] = a2r+a3r;  xi[2] = a2i+a3i;
+        xr[3] = a2r-a3r;  xi[3] = a2i-a3i;
+    }
+}
+
+// Два первых этапа обратного (h=1 и h=2), корни сопряжённые: 1 и i
+inline
+void fftInverseFirst2(double *re, double *im, std::size_t n)
+{
+    for(std::size_t i=0; i<n; i+=4u)
+    {
+        double *xr = re+i;
+        double *xi = im+i;
+
+        const double a0r = xr[0]+xr[1], a0i = xi[0]+xi[1];
+        const double a1r = xr[0]-xr[1], a1i = xi[0]-xi[1];
+        const double a2r = xr[2]+xr[3], a2i = xi[2]+xi[3];
+        const double a3r = xi[3]-xi[2], a3i = xr[2]-xr[3]; // (x2-x3)*i
+
+        xr[0] = a0r+a2r;  xi[0] = a0i+a2i;
+        xr[2] = a0r-a2r;  xi[2] = a0i-a2i;
+        xr[1] = a1r+a3r;  xi[1] = a1i+a3i;
+        xr[3] = a1r-a3r;  xi[3] = a1i-a3i;
+    }
+}
+
+// С этой длины преобразование идёт рекурсивно (сначала одна половина целиком, потом другая),
+// чтобы последние этапы работали в кэше, а не проходили весь массив
+constexpr const std::size_t fftRecursiveSize = std::size_t(1)<<11;
+
+// С этой длины половины в рекурсии - отдельные задачи invoke (если он параллельный).
+// Короче - накладные расходы на задачу заметнее выигрыша
+constexpr const std::size_t fftParallelSize = std::size_t(1)<<14;
+
+// Прямое, на выходе - bit-reversed порядок
+template<typename Invoke = serial_invoke>
+inline
+void fftForward(double *re, double *im, std::size_t n, const double *wr, const double *wi, bool avx2, const Invoke &invoke = Invoke())
+{
+    if (n<4u)
+    {
+        if (n==2u)
+            fftForwardStage(re, im, n, 1, wr, wi, false);
+        return;
+    }
+
+    for(std::size_t h=n/2u; h>=4u; h/=2u)
+    {
+        fftForwardStage(re, im, n, h, wr, wi, avx2);
+        if (h>=fftRecursiveSize)
+        {
+            if (invoke.parallel() && n>=fftParallelSize)
+            {
+                invoke( [=, &invoke]() { fftForward(re  , im  , h, wr, wi, avx2, invoke); }
+                      , [=, &invoke]() { fftForward(re+h, im+h, h, wr, wi, avx2, invoke); }
+                      );
+            }
+            else
+            {
+                fftForward(re  , im  , h, wr, wi, avx2);
+                fftForward(re+h, im+h, h, wr, wi, avx2);
+            }
+            return;
+        }
+    }
+
+    fftForwardLast2(re, im, n);
+}
+
+// Обратное из bit-reversed порядка, без деления на n
+template<typename Invoke = serial_invoke>
+inline
+void fftInverse(double *re, double *im, std::size_t n, const double *wr, const double *wi, bool avx2, const Invoke &invoke = Invoke())
+{
+    if (n<4u)
+    {
+        if (n==2u)
+            fftInverseStage(re, im, n, 1, wr, wi, false);
+        return;
+    }
+
+    std::size_t h = 4;
+    if (n>2u*fftRecursiveSize)
+    {
+        if (invoke.parallel() && n>=fftParallelSize)
+        {
+            invoke( [=, &invoke]() { fftInverse(re     , im     , n/2u, wr, wi, avx2, invoke); }
+                  , [=, &invoke]() { fftInverse(re+n/2u, im+n/2u, n/2u, wr, wi, avx2, invoke); }
+                  );
+        }
+        else
+        {
+            fftInverse(re     , im     , n/2u, wr, wi, avx2);
+            fftInverse(re+n/2u, im+n/2u, n/2u, wr, wi, avx2);
+        }
+        h = n/2u;
+    }
+    else
+    {
+        fftInverseFirst2(re, im, n);
+    }
+
+    for(; h<n; h*=2u)
+        fftInverseStage(re, im, n, h, wr, wi, avx2);
+}
+
+//----------------------------------------------------------------------------
+// Z = FFT(a + i*b) в bit-reversed порядке. A*B по частотам: (Z_k^2 - conj(Z_-k)^2)/(4i).
+// Частота -k в bit-reversed порядке лежит в том же октавном блоке [2^m, 2^(m+1)),
+// зеркально: p <-> 3*2^m-1-p. Позиции 0 и 1 - сами себе пара. scale - заодно деление на n
+inline
+void fftPointwisePacked(double *re, double *im, std::size_t n, double scale)
+{
+    const double s = scale*0.25;
+
+    auto one = [&](std::size_t p, std::size_t q)
+    {
+        const double pr = re[p], pi = im[p];
+        const double qr = re[q], qi = im[q];
+
+        // X = Z_p^2 - conj(Z_q)^2, результат X/(4i) = (X.im, -X.re)/4
+        const double xr = (pr*pr - pi*pi) - (qr*qr - qi*qi);
+        const double xi = 2.0*pr*pi + 2.0*qr*qi;
+        return std::pair<double, double>(xi*s, -xr*s);
+    };
+
+    for(std::size_t p=0; p!=std::min<std::size_t>(n, 2u); ++p)
+    {
+        const auto c = one(p, p);
+        re[p] = c.first;
+        im[p] = c.second;
+    }
+
+    for(std::size_t m=2; m<n; m*=2u)
+    {
+        for(std::size_t p=m, q=2u*m-1u; p<q; ++p, --q)
+        {
+            const auto cp = one(p, q);
+            const auto cq = one(q, p);
+            re[p] = cp.first;  im[p] = cp.second;
+            re[q] = cq.first;  im[q] = cq.second;
+        }
+    }
+}
+
+// Квадрат вещественного x длины 2m через комплексное FFT длины m: z[j] = x[2j] + i*x[2j+1].
+// Z = FFT(z) в bit-reversed порядке, спектр x: X_k = E_k + W_2m^k * O_k, где
+// E_k = (Z_k + conj(Z_-k))/2, O_k = (Z_k - conj(Z_-k))/(2i) - спектры чётных и нечётных x.
+// Для Y = X^2 спектр упакованного обратно y: F_k = E_k^2 + W_m^k * O_k^2 + 2i*E_k*O_k,
+// обратное FFT длины m от F даёт y[2j] + i*y[2j+1]. Пары k, -k - как в fftPointwisePacked,
+// натуральный индекс k позиции нужен для корня W_m^k, его ведём счётчиком в обратном порядке бит
+inline
+void fftPointwiseSquareReal(double *re, double *im, std::size_t m, const double *wr, const double *wi, double scale)
+{
+    const double *topR = wr + m/2u;
+    const double *topI = wi + m/2u;
+
+    // W_m^k
+    auto root = [&](std::size_t k, double &cr, double &ci)
+    {
+        if (k<m/2u)
+        {
+            cr = topR[k];
+            ci = topI[k];
+        }
+        else
+        {
+            cr = -topR[k-m/2u];
+            ci = -topI[k-m/2u];
+        }
+    };
+
+    auto pair = [&](std::size_t p, std::size_t q, std::size_t k)
+    {
+        const double pr = re[p], pi = im[p];
+        const double qr = re[q], qi = im[q];
+
+        const double er = 0.5*(pr+qr), ei = 0.5*(pi-qi);
+        const double orr = 0.5*(pi+qi), oi = 0.5*(qr-pr);
+
+        double cr = 0, ci = 0;
+        root(k, cr, ci);
+
+        const double e2r = er*er - ei*ei,  e2i = 2.0*er*ei;
+        const double o2r = orr*orr - oi*oi, o2i = 2.0*orr*oi;
+        const double wor = cr*o2r - ci*o2i, woi = cr*o2i + ci*o2r;
+        const double eor = er*orr - ei*oi, eoi = er*oi + ei*orr;
+
+        // F_-k - сопряжённые E и O, корень тоже сопряжённый
+        const double fqr = (e2r + wor + 2.0*eoi)*scale;
+        const double fqi = (2.0*eor - e2i - woi)*scale;
+        re[p] = (e2r + wor - 2.0*eoi)*scale;
+        im[p] = (e2i + woi + 2.0*eor)*scale;
+        re[q] = fqr;
+        im[q] = fqi;
+    };
+
+    pair(0, 0, 0);
+    pair(1, 1, m/2u);
+
+    for(std::size_t blk=2; blk<m; blk*=2u)
+    {
+        // Позиция blk+t в обратном порядке бит - это m/(2*blk) + rev(t)
+        const std::size_t base = m/(2u*blk);
+        std::size_t rev = 0;
+        for(std::size_t p=blk, q=2u*blk-1u; p<q; ++p, --q)
+        {
+            pair(p, q, base+rev);
+
+            std::size_t bit = m/2u;
+            while(rev & bit)
+            {
+                rev ^= bit;
+                bit >>= 1;
+            }
+            rev |= bit;
+        }
+    }
+}
+
+// Округление коэффициентов свёртки coef(i), i<nc, и сборка r кусками по pb бит.
+// false - отклонение от целых слишком большое, результату верить нельзя
+template<typename T, typename CoefFn>
+inline
+bool fftRoundCarry(T *r, std::size_t rn, std::size_t nc, int pb, CoefFn coef)
+{
+    for(std::size_t i=0; i!=rn; ++i)
+        r[i] = 0;
+
+    const std::uint32_t mask   = (std::uint32_t(1)<<pb)-1u;
+    double              maxErr = 0.0;
+    std::uint64_t       acc    = 0;
+    std::size_t         i      = 0;
+    for(; i!=nc; ++i)
+    {
+        const double x  = coef(i);
+        const double rx = std::floor(x+0.5);
+        maxErr = std::max(maxErr, std::fabs(x-rx));
+        if (rx<0.0)
+            return false;
+
+        acc += std::uint64_t(rx);
+        fftOrBits(r, rn, i*std::size_t(pb), std::uint32_t(acc & mask), pb);
+        acc >>= pb;
+    }
+
+    for(; acc; ++i)
+    {
+        fftOrBits(r, rn, i*std::size_t(pb), std::uint32_t(acc & mask), pb);
+        acc >>= pb;
+    }
+
+    return maxErr<0.25;
+}
+
+} // namespace details
+
+//----------------------------------------------------------------------------
+//! Рабочая область mul_fft, в double (не в чанках). 0 - FFT для таких размеров не гарантирует
+//! точности, надо умножать иначе
+template<typename T>
+inline
+std::size_t fftWorkSize(std::size_t an, std::size_t bn)
+{
+    const int pb = details::fftPieceBits<T>(an, bn);
+    if (!pb)
+        return 0;
+    return 4u*std::max<std::size_t>(details::fftSize(details::fftPiecesCount<T>(an, pb), details::fftPiecesCount<T>(bn, pb)), 4u);
+}
+
+//----------------------------------------------------------------------------
+//! r = a^2 через FFT, an>=1, r - 2*an чанков и не пересекается с a. Преобразования вдвое
+//! короче, чем в mul_fft (a вещественное, чётные/нечётные куски - в re/im).
+//! work - не меньше fftWorkSize<T>(an, an) double. false - как у mul_fft
+template<typename T, typename Invoke = serial_invoke>
+inline
+bool sqr_fft(T *r, const T *a, std::size_t an, double *work, const Invoke &invoke = Invoke())
+{
+    const int pb = details::fftPieceBits<T>(an, an);
+    if (!pb)
+        return false;
+
+    const std::size_t na = details::fftPiecesCount<T>(an, pb);
+    const std::size_t m  = std::max<std::size_t>(details::fftSize(na, na), 4u)/2u;
+
+    double *re = work;
+    double *im = re + m;
+    double *wr = im + m;
+    double *wi = wr + m;
+
+    for(std::size_t j=0; j!=m; ++j)
+    {
+        re[j] = 2u*j   <na ? double(details::fftGetBits(a, an, (2u*j   )*std::size_t(pb), pb)) : 0.0;
+        im[j] = 2u*j+1u<na ? double(details::fftGetBits(a, an, (2u*j+1u)*std::size_t(pb), pb)) : 0.0;
+    }
+
+#if defined(MARTY_BIGINT_FFT_AVX2)
+    const bool avx2 = details::cpuHasAvx2();
+#else
+    const bool avx2 = false;
+#endif
+
+    details::fftMakeRoots(wr, wi, m);
+    details::fftForward(re, im, m, wr, wi, avx2, invoke);
+    details::fftPointwiseSquareReal(re, im, m, wr, wi, 1.0/double(m));
+    details::fftInverse(re, im, m, wr, wi, avx2, invoke);
+
+    return details::fftRoundCarry(r, 2u*an, 2u*na-1u, pb, [re, im](std::size_t i) { return (i&1u) ? im[i/2u] : re[i/2u]; });
+}
+
+//----------------------------------------------------------------------------
+//! r = a * b через FFT в double, an>=1, bn>=1, r - an+bn чанков и не пересекается с a и b.
+//! work - не меньше fftWorkSize<T>(an, bn) double, других аллокаций нет.
+//! Возвращает false, если точность не гарантирована (fftWorkSize==0) или проверка
+//! отклонения от целых не прошла - тогда содержимое r не определено.
+//! Если a и b - один и тот же массив - это sqr_fft.
+//! invoke - исполнитель для половин рекурсии преобразований (см. serial_invoke)
+template<typename T, typename Invoke = serial_invoke>
+inline
+bool mul_fft(T *r, const T *a, std::size_t an, const T *b, std::size_t bn, double *work, const Invoke &invoke = Invoke())
+{
+    if (a==b && an==bn)
+        return sqr_fft(r, a, an, work, invoke);
+
+    const int pb = details::fftPieceBits<T>(an, bn);
+    if (!pb)
+        return false;
+
+    const std::size_t na = details::fftPiecesCount<T>(an, pb);
+    const std::size_t nb = details::fftPiecesCount<T>(bn, pb);
+    const std::size_t n  = details::fftSize(na, nb);
+
+    double *re = work;
+    double *im = re + n;
+    double *wr = im + n;
+    double *wi = wr + n;
+
+    for(std::size_t i=0; i!=n; ++i)
+    {
+        re[i] = i<na ? double(details::fftGetBits(a, an, i*std::size_t(pb), pb)) : 0.0;
+        im[i] = i<nb ? double(details::fftGetBits(b, bn, i*std::size_t(pb), pb)) : 0.0;
+    }
+
+#if defined(MARTY_BIGINT_FFT_AVX2)
+    const bool avx2 = details::cpuHasAvx2();
+#else
+    const bool avx2 = false;
+#endif
+
+    details::fftMakeRoots(wr, wi, n);
+    details::fftForward(re, im, n, wr, wi, avx2, invoke);
+    details::fftPointwisePacked(re, im, n, 1.0/double(n));
+    details::fftInverse(re, im, n, wr, wi, avx2, invoke);
+
+    // Округляем и собираем кусками по pb бит
+    return details::fftRoundCarry(r, an+bn, na+nb-1u, pb, [re](std::size_t i) { return re[i]; });
+}
+
+//----------------------------------------------------------------------------
+
+} // namespace bigint_limbs
+} // namespace marty
+
+// marty::bigint_limbs::
+// #include "marty_bigint/fft.h"
+
@@ -9,28 +9,17 @@ namespace marty {
 inline
 void BigInt::moduleInc(number_holder_t &m)
 {
-    for(auto &v: m)
-    {
-        ++v;
-        if (v!=0)
-            break;
-    }
+    const unsigned_t carry = bigint_limbs::add_1(m.data(), m.data(), m.size(), unsigned_t(1));
+    if (carry)
+        m.push_back(carry);
 }
 
 //----------------------------------------------------------------------------
 inline
 void BigInt::moduleDec(number_holder_t &m)
 {
-    for(auto &v: m)
-    {
-        if (v!=0)
-        {
-            --v;
-            break;
-        }
-        
-        --v;
-    }
+    // Модуль не нулевой, заёма не будет
+    bigint_limbs::sub_1(m.data(), m.data(), m.size(), unsigned_t(1));
 }
 
 //----------------------------------------------------------------------------
@@ -48,40 +37,19 @@ bool BigInt::moduleIsZero(const number_holder_t &m)
 
 //----------------------------------------------------------------------------
 inline
-int BigInt::moduleCompare(const number_holder_t &m1, number_holder_t m2, std::size_t beginIdxM1, std::size_t endIdxM1)
+int BigInt::moduleCompare(const number_holder_t &m1, const number_holder_t &m2, std::size_t beginIdxM1, std::size_t endIdxM1)
 {
+    // Сравниваем с m2 только чанки m1 в диапазоне [endIdxM1, beginIdxM1)
     if (beginIdxM1>=m1.size())
         beginIdxM1 = m1.size();
 
-    if (endIdxM1>=m1.size())
+    if (endIdxM1==std::size_t(-1))
         endIdxM1 = 0;
 
+    if (endIdxM1>beginIdxM1)
+        endIdxM1 = beginIdxM1;
 
-    std::size_t maxSize = std::max(beginIdxM1, m2.size());
-
-    for (std::size_t i=maxSize; i-->endIdxM1;)
-    {
-        unsigned_t v1 = 0;
-        unsigned_t v2 = 0;
-
-        const std::size_t i2 = i - endIdxM1; // beginIdxM1;
-
-        if (i<m1.size())
-            v1 = m1[i];
-    
-        if (i2<m2.size())
-            v2 = m2[i2];
-
-        if (v1==v2)
-            continue;
-
-        if (v1<v2)
-            return -1;
-
-        return 1;
-    }
-
-    return 0;
+    return bigint_limbs::cmp(m1.data()+endIdxM1, beginIdxM1-endIdxM1, m2.data(), m2.size());
 }
 
 //----------------------------------------------------------------------------
@@ -108,120 +76,39 @@ void BigInt::moduleFill(number_holder_t &m, unsigned_t v, std::size_t b, std::si
 inline
 BigInt::number_holder_t BigInt::moduleAdd(const number_holder_t &m1, const number_holder_t &m2)
 {
-#if 0
-    std::size_t maxSize = std::max(m1.size(), m2.size());
-
-    number_holder_t res; res.reserve(maxSize);
-    bool prevOverflow = false;
-
-    for(std::size_t i=0; i!=maxSize; ++i)
-    {
-        unsigned_t v1 = 0;
-        unsigned_t v2 = 0;
-
-        if (i<m1.size())
-            v1 = m1[i];
-    
-        if (i<m2.size())
-            v2 = m2[i];
-
-        unsigned_t r = unsigned_t(v1 + v2);
+    const number_holder_t &a = m1.size()<m2.size() ? m2 : m1; // длинное слагаемое
+    const number_holder_t &b = m1.size()<m2.size() ? m1 : m2;
 
-        bool nextOverflow = (r<v1) || r<v2;
-
-        if (prevOverflow)
-        {
-            ++r;
-            if (r==0) // Ноль меньше единицы, произошло переполнение
-                nextOverflow = true;
-        }
-
-        prevOverflow = nextOverflow;
-
-        res.emplace_back(r);
-    
-    }
-
-    if (prevOverflow)
-        res.emplace_back(unsigned_t(1));
-
-    return res;
-#endif
-
-    number_holder_t res = m1;
-    moduleAddInplace(res, m2);
+    number_holder_t res(a.size()+1u, 0u);
+    res[a.size()] = bigint_limbs::add(res.data(), a.data(), a.size(), b.data(), b.size());
     shrinkLeadingZeros(res);
     return res;
-
 }
 
 //----------------------------------------------------------------------------
-void BigInt::moduleAddInplace(number_holder_t &m1, const number_holder_t &m2, std::size_t b, std::size_t e) // adds m2 to m1
+// Прибавляет m2 к m1, начиная с чанка b
+inline
+void BigInt::moduleAddInplace(number_holder_t &m1, const number_holder_t &m2, std::size_t b)
 {
-    if (e==std::size_t(-1))
-        e = std::max(m1.size(), m2.size());
-
-    m1.reserve(m2.size());
-
-    ++e; // увеличиваем конечный индекс, чтобы не нужно было отдельно обрабатывать последнее переполнение
-
     if (b==std::size_t(-1))
         b = 0;
 
-    bool prevOverflow = false;
-
-    std::size_t i = b;
-
-    for(; i!=e; ++i)
-    {
-        unsigned_t v1 = 0;
-        unsigned_t v2 = 0;
-
-        const std::size_t i2 = i - b;
-
-        if (i<m1.size())
-            v1 = m1[i];
-    
-        if (i2<m2.size())
-            v2 = m2[i2];
-
-        unsigned_t r = unsigned_t(v1 + v2);
-
-        bool nextOverflow = (r<v1) || r<v2;
-
-        if (prevOverflow)
-        {
-            ++r;
-            if (r==0) // Ноль меньше единицы, произошло переполнение
-                nextOverflow = true;
-        }
-
-        prevOverflow = nextOverflow;
-
-        if (i<m1.size())
-        {
-            m1[i] = r;
-        }
-        else
-        {
-            if (i!=(e-1) || r!=0)
-                m1.push_back(r);
-        }
-    }
-
-    // if (prevOverflow)
-    // {
-    //     m1.emplace_back(unsigned_t(1));
-    //  
-    // }
+    const std::size_t n2 = bigint_limbs::normalizedSize(m2.data(), m2.size());
+    if (m1.size()<b+n2)
+        m1.resize(b+n2, 0u);
 
+    const unsigned_t carry = bigint_limbs::add(m1.data()+b, m1.data()+b, m1.size()-b, m2.data(), n2);
+    if (carry)
+        m1.push_back(carry);
 }
 
 //----------------------------------------------------------------------------
 // m1 - уменьшаемое
 // m2 - вычитаемое
 // уменьшаемое должно быть больше или равно вычитаемому
-void BigInt::moduleSubInplace(number_holder_t& m1, number_holder_t m2, std::size_t beginIdxM1, std::size_t endIdxM1)
+// Вычитаем только из чанков m1 в диапазоне [beginIdxM1, endIdxM1)
+inline
+void BigInt::moduleSubInplace(number_holder_t& m1, const number_holder_t &m2, std::size_t beginIdxM1, std::size_t endIdxM1)
 {
     if (beginIdxM1>=m1.size())
         beginIdxM1 = 0;
@@ -229,95 +116,30 @@ void BigInt::moduleSubInplace(number_holder_t& m1, number_holder_t m2, std::size
     if (endIdxM1>=m1.size())
         endIdxM1 = m1.size();
 
+    if (endIdxM1<beginIdxM1)
+        endIdxM1 = beginIdxM1;
 
-    std::size_t maxSize = std::max(endIdxM1, m2.size());
-
-    // number_holder_t res; res.reserve(maxSize);
-    bool prevOverflow = false;
-
-    for(std::size_t i=beginIdxM1; i!=maxSize; ++i)
-    {
-        unsigned_t v1 = 0;
-        unsigned_t v2 = 0;
-
-        const std::size_t i2 = i - beginIdxM1;
-
-        if (i<m1.size())
-            v1 = m1[i];
-    
-        if (i2<m2.size())
-            v2 = m2[i2];
-
-        bool nextOverflow = v1 < v2;
-
-        unsigned_t r = unsigned_t(v1 - v2);
-
-        if (prevOverflow)
-        {
-            if (r==0)
-                nextOverflow = true;
-            --r;
-        }
-
-        prevOverflow = nextOverflow;
-
-        if (i<m1.size())
-            m1[i] = r;
-    
-    }
+    const std::size_t n1 = endIdxM1-beginIdxM1;
+    const std::size_t n2 = bigint_limbs::normalizedSize(m2.data(), m2.size());
+    if (n2>n1 || bigint_limbs::sub(m1.data()+beginIdxM1, m1.data()+beginIdxM1, n1, m2.data(), n2))
+        throw std::underflow_error("BigInt::moduleSubInplace: subtrahend is greater than minuend");
 }
 
 //----------------------------------------------------------------------------
 inline
-BigInt::number_holder_t BigInt::moduleSub(const number_holder_t &m1, number_holder_t m2)
+BigInt::number_holder_t BigInt::moduleSub(const number_holder_t &m1, const number_holder_t &m2)
 {
-    number_holder_t res = m1;
-    moduleSubInplace(res, m2);
-    return res;
-
-#if 0
-    std::size_t maxSize = std::max(m1.size(), m2.size());
-
-    number_holder_t res; res.reserve(maxSize);
-    bool prevOverflow = false;
-
-    for(std::size_t i=0; i!=maxSize; ++i)
-    {
-        unsigned_t v1 = 0;
-        unsigned_t v2 = 0;
-
-        if (i<m1.size())
-            v1 = m1[i];
-    
-        if (i<m2.size())
-            v2 = m2[i];
-
-        bool nextOverflow = v1 < v2;
-
-        unsigned_t r = unsigned_t(v1 - v2);
-
-        if (prevOverflow)
-        {
-            if (r==0)
-                nextOverflow = true;
-            --r;
-        }
-
-        prevOverflow = nextOverflow;
-
-        res.push_back(r);
-    
-    }
-
-    // prevOverflow никогда не должен быть true - выкинуть исключение/ассерт?
-    // if (prevOverflow)
-    //     res.emplace_back(unsigned_t(1));
+    number_holder_t res(m1.size(), 0u);
+    const std::size_t n2 = bigint_limbs::normalizedSize(m2.data(), m2.size());
+    if (n2>m1.size() || bigint_limbs::sub(res.data(), m1.data(), m1.size(), m2.data(), n2))
+        throw std::underflow_error("BigInt::moduleSub: subtrahend is greater than minuend");
 
+    shrinkLeadingZeros(res);
     return res;
-#endif
 }
 
 //----------------------------------------------------------------------------
+inline
 BigInt& BigInt::incImpl()
 {
     if (!m_sign)
@@ -340,6 +162,7 @@ BigInt& BigInt::incImpl()
 }
 
 //----------------------------------------------------------------------------
+inline
 BigInt& BigInt::decImpl()
 {
     if (!m_sign)
@@ -387,8 +210,8 @@ void BigInt::shrinkLeadingZeros(number_holder_t &m)
 inline
 int BigInt::compareImpl(int signOther, const number_holder_t &moduleOther) const
 {
-    if (m_sign==signOther)
-        return moduleCompare(m_module, moduleOther);
+    if (m_sign==signOther) // для отрицательных чисел больше то, у которого модуль меньше
+        return m_sign<0 ? -moduleCompare(m_module, moduleOther) : moduleCompare(m_module, moduleOther);
 
     if (m_sign<signOther)
         return -1;
@@ -481,90 +304,43 @@ void BigInt::moduleShiftLeft(number_holder_t &m, int v)
     if (m.empty())
         return;
 
-    const int nBitsFullChunks = v - v%iChunkSizeBits;
-    const int nFullChunks     = nBitsFullChunks / iChunkSizeBits;
-    v -= nBitsFullChunks;
-
     // Сдвиг влево - в сторону старших разрядов
     // Младшие разряды у нас идут сначала
-    // Значит, надо просто вставить nFullChunks нулей в начало
+    // Сдвигаем на v%iChunkSizeBits бит и сразу кладём на nFullChunks чанков выше,
+    // освободившиеся младшие чанки заполняем нулями
 
-    m.insert(m.begin(), std::size_t(nFullChunks), 0);
-
-    // while(!m.empty() && v>=iChunkSizeBits)
-    // {
-    //     std::rotate(m.rbegin(), m.rbegin() + 1, m.rend());
-    //     if (m[0])
-    //         m.emplace_back(m[0]);
-    //     m[0] = 0;
-    //     v -= iChunkSizeBits;
-    // }
-
-    while(!m.empty() && v>=8)
-    {
-        moduleShiftLeftHelper<8>(m);
-        v -= 8;
-    }
+    const std::size_t nFullChunks = std::size_t(v/iChunkSizeBits);
+    const int         nBits       = v%iChunkSizeBits;
+    const std::size_t n           = m.size();
 
-    while(!m.empty() && v>=4)
-    {
-        moduleShiftLeftHelper<4>(m);
-        v -= 4;
-    }
+    m.resize(n+nFullChunks+1u);
+    m[n+nFullChunks] = bigint_limbs::lshift(m.data()+nFullChunks, m.data(), n, nBits);
+    std::fill(m.begin(), m.begin()+std::ptrdiff_t(nFullChunks), unsigned_t(0));
 
-    while(!m.empty() && v>=1)
-    {
-        moduleShiftLeftHelper<1>(m);
-        v -= 1;
-    }
+    shrinkLeadingZeros(m);
 }
 
 //----------------------------------------------------------------------------
 inline
 void BigInt::moduleShiftRight(number_holder_t &m, int v)
 {
-    const int nBitsFullChunks = v - v%iChunkSizeBits;
-    const int nFullChunks     = nBitsFullChunks / iChunkSizeBits;
-    v -= nBitsFullChunks;
-
     // Сдвиг вправо - в сторону младших разрядов
-    // Младшие разряды у нас идут сначала
     // выдвигаемые значения просто пропадают
-    // Значит, надо просто удалить nFullChunks элементов в начале
 
-    if (m.size()<=std::size_t(nFullChunks))
+    const std::size_t nFullChunks = std::size_t(v/iChunkSizeBits);
+    const int         nBits       = v%iChunkSizeBits;
+
+    if (m.size()<=nFullChunks)
     {
         m.clear();
         return;
     }
 
-    m.erase(m.begin(), m.begin()+ptrdiff_t(nFullChunks));
-
+    const std::size_t n = m.size()-nFullChunks;
+    bigint_limbs::rshift(m.data(), m.data()+nFullChunks, n, nBits);
+    m.resize(n);
 
-    // while(!m.empty() && v>=iChunkSizeBits)
-    // {
-    //     std::rotate(m.begin(), m.begin() + 1, m.end());
-    //     m.pop_back();
-    //     v -= iChunkSizeBits;
-    // }
-
-    while(!m.empty() && v>=8)
-    {
-        moduleShiftRightHelper<8>(m);
-        v -= 8;
-    }
-
-    while(!m.empty() && v>=4)
-    {
-        moduleShiftRightHelper<4>(m);
-        v -= 4;
-    }
-
-    while(!m.empty() && v>=1)
-    {
-        moduleShiftRightHelper<1>(m);
-        v -= 1;
-    }
+    shrinkLeadingZeros(m);
 }
 
 //----------------------------------------------------------------------------
@@ -609,31 +385,7 @@ void BigInt::shiftRightImpl(int v)
     if (!m_sign)
         return; // сдвиг нуля даст ноль всё равно
 
-    while(!m_module.empty() && v>=iChunkSizeBits)
-    {
-        std::rotate(m_module.begin(), m_module.begin() + 1, m_module.end());
-        m_module.pop_back();
-        v -= iChunkSizeBits;
-    }
-
-    while(!m_module.empty() && v>=8)
-    {
-        moduleShiftRightHelper<8>(m_module);
-        v -= 8;
-    }
-
-    while(!m_module.empty() && v>=4)
-    {
-        moduleShiftRightHelper<4>(m_module);
-        v -= 4;
-    }
-
-    while(!m_module.empty() && v>=1)
-    {
-        moduleShiftRightHelper<1>(m_module);
-        v -= 1;
-    }
-
+    moduleShiftRight(m_module, v);
     checkModuleEmpty();
 }
 
@@ -645,7 +397,16 @@ void BigInt::shiftRightImpl(int v)
 
 //----------------------------------------------------------------------------
 inline
-BigInt::number_holder_t BigInt::moduleSchoolMul(const number_holder_t &a, const number_holder_t &b)
+void BigInt::moduleMulChunkTo(number_holder_t &res, const number_holder_t &m, unsigned_t v)
+{
+    res.resize(m.size()+1u);
+    res[m.size()] = bigint_limbs::mul_1(res.data(), m.data(), m.size(), v);
+    shrinkLeadingZeros(res);
+}
+
+//----------------------------------------------------------------------------
+inline
+void BigInt::moduleSchoolMulTo(number_holder_t &res, const number_holder_t &a, const number_holder_t &b)
 {
 /*
            1234
@@ -672,205 +433,433 @@ BigInt::number_holder_t BigInt::moduleSchoolMul(const number_holder_t &a, const
 Стартовый разряд равен сумме индексов умножаемых разрядов.
 
 */
-    // Желательно внутренний цикл сделать более длинным, чем внешний
-    const number_holder_t &m1 =  (a.size()<b.size()) ? a : b;
-    const number_holder_t &m2 = !(a.size()<b.size()) ? a : b;
-
-    number_holder_t res; res.resize(m1.size()+m2.size()+1);
-    //number_holder_t tmp; tmp.resize(m1.size()+m2.size()+1);
-    number_holder_t tmp; tmp.resize(2);
-
-    moduleFill(res, 0u);
-    moduleFill(tmp, 0u);
-
-    for(std::size_t i1=0; i1!=m1.size(); ++i1)
+    // Каждый чанк короткого множителя - одна строка: addmul_1 по всему длинному,
+    // перенос идёт в регистре, а не через moduleAddInplace на каждое произведение.
+    // Внутренний цикл (по длинному множителю) - длиннее внешнего
+    const number_holder_t &m1 = !(a.size()<b.size()) ? a : b; // длинный
+    const number_holder_t &m2 =  (a.size()<b.size()) ? a : b; // короткий
+
+    const std::size_t n1 = bigint_limbs::normalizedSize(m1.data(), m1.size());
+    const std::size_t n2 = bigint_limbs::normalizedSize(m2.data(), m2.size());
+    if (!n1 || !n2)
     {
-        for(std::size_t i2=0; i2!=m2.size(); ++i2)
-        {
-            const unsigned2_t m1_i1 = unsigned2_t(m1[i1]);
-            const unsigned2_t m2_i2 = unsigned2_t(m2[i2]);
-            unsigned2_t tmpMul = unsigned2_t(m1_i1*m2_i2);
-            const std::size_t idx = i1+i2;
-            tmp[0] += unsigned_t( tmpMul );
-            tmp[1] += unsigned_t((tmpMul>>(sizeof(unsigned_t)*CHAR_BIT)));
-            moduleAddInplace(res, tmp, idx);
-            moduleFill(tmp, 0u);
-        }
+        res.clear();
+        return;
     }
 
+    res.resize(n1+n2);
+    if (n1>=n2)
+        bigint_limbs::mul_basecase(res.data(), m1.data(), n1, m2.data(), n2);
+    else
+        bigint_limbs::mul_basecase(res.data(), m2.data(), n2, m1.data(), n1);
+
     shrinkLeadingZeros(res);
+}
+
+//----------------------------------------------------------------------------
+inline
+BigInt::number_holder_t BigInt::moduleSchoolMul(const number_holder_t &a, const number_holder_t &b)
+{
+    number_holder_t res;
+    moduleSchoolMulTo(res, a, b);
     return res;
 }
 
 //----------------------------------------------------------------------------
 inline
-BigInt::number_holder_t BigInt::moduleFurerMul(const number_holder_t &a, const number_holder_t &b)
+BigInt::number_holder_t BigInt::moduleCombaMul(const number_holder_t &a, const number_holder_t &b)
 {
-    // Алгоритм Фюрера - https://ru.wikipedia.org/wiki/%D0%90%D0%BB%D0%B3%D0%BE%D1%80%D0%B8%D1%82%D0%BC_%D0%A4%D1%8E%D1%80%D0%B5%D1%80%D0%B0
-    // Интересно про свёртки
+    // Раньше метод назывался furer, хотя к алгоритму Фюрера (https://ru.wikipedia.org/wiki/%D0%90%D0%BB%D0%B3%D0%BE%D1%80%D0%B8%D1%82%D0%BC_%D0%A4%D1%8E%D1%80%D0%B5%D1%80%D0%B0)
+    // отношения не имел - это свёртка по столбцам. Так оно и работает: элемент свёртки (столбец)
+    // складывается с переполнением от предыдущего, младший чанк уходит в результат,
+    // остальное - переполнение для следующего столбца. Сейчас - bigint_limbs::mul_comba,
+    // столбец копится в трёх чанках на регистрах, без аллокаций.
+
+    const std::size_t n1 = bigint_limbs::normalizedSize(a.data(), a.size());
+    const std::size_t n2 = bigint_limbs::normalizedSize(b.data(), b.size());
+    if (!n1 || !n2)
+        return number_holder_t();
+
+    number_holder_t res(n1+n2, 0u);
+    bigint_limbs::mul_comba(res.data(), a.data(), n1, b.data(), n2);
+    shrinkLeadingZeros(res);
 
-    // Проверил на бамажке - вроде работает. А что самое прикольное - гораздо проще всратого умножения столбиком.
-    // В статье по ссылке - число маленькое, было интересно, когда элемент свертки перевалит за два разряда.
-    // Будет не лень - настучу свой пример.
+    return res;
+}
 
-    const number_holder_t &m1 =  (a.size()<b.size()) ? a : b;
-    const number_holder_t &m2 = !(a.size()<b.size()) ? a : b;
+//----------------------------------------------------------------------------
+inline
+BigInt::number_holder_t BigInt::moduleKaratsubaMul(const number_holder_t &a, const number_holder_t &b, const arithmetic_context &ctx)
+{
+    number_holder_t res;
+    moduleKaratsubaMulTo(res, a, b, ctx);
+    return res;
+}
 
-    std::vector<number_holder_t> convolution = std::vector<number_holder_t>(m1.size()+m2.size()+1);
-    for(std::size_t i1=0; i1!=m1.size(); ++i1)
+//----------------------------------------------------------------------------
+// res не должен совпадать с a или b
+template<typename MulFn, typename ScratchSizeFn>
+inline
+void BigInt::moduleScratchMulTo(number_holder_t &res, const number_holder_t &a, const number_holder_t &b, scratch_workspace &ws, MulFn mulFn, ScratchSizeFn scratchSizeFn)
+{
+    const std::size_t n1 = bigint_limbs::normalizedSize(a.data(), a.size());
+    const std::size_t n2 = bigint_limbs::normalizedSize(b.data(), b.size());
+    if (!n1 || !n2)
     {
-        for(std::size_t i2=0; i2!=m2.size(); ++i2)
-        {
-            // convolution[i1+i2] += m1[i1] * m2[i2];
-            auto mTmp = BigInt( unsigned2_t(unsigned2_t(m1[i1])*unsigned2_t(m2[i2])) ).m_module;
-            moduleAddInplace(convolution[i1+i2], mTmp);
-        }
+        res.clear();
+        return;
     }
 
-    // Выдрано из реализации BCD десятичных чисел с плавающей точкой
-    // unsigned overflow = 0;
-    //  
-    // for( std::size_t i=0; i!=convSize; ++i )
-    // {
-    //     convolution[i] += overflow;
-    //     overflow = bcdCorrectOverflow(convolution[i]);
-    //     multRes.push_back((decimal_digit_t)convolution[i]);
-    // }
-    //  
-    // if (overflow)
-    // {
-    //     multRes.push_back((decimal_digit_t)overflow);
-    // }
+    // Вся рекурсия работает в одной непрерывной области, половинки/трети - это просто
+    // указатели внутрь a и b, сложения - со смещением в чанках
+    scratch_holder scratch(ws);
+    scratch->resize(scratchSizeFn(n1, n2));
 
-    // Переделал под BigInt, вроде даже работает
+    res.resize(n1+n2);
+    mulFn(res.data(), a.data(), n1, b.data(), n2, scratch->data());
 
+    shrinkLeadingZeros(res);
+}
 
-    number_holder_t res; res.reserve(m1.size()+m2.size()+1); // res.resize(m1.size()+m2.size()+1);
+//----------------------------------------------------------------------------
+// res не должен совпадать с a или b
+inline
+void BigInt::moduleKaratsubaMulTo(number_holder_t &res, const number_holder_t &a, const number_holder_t &b, const arithmetic_context &ctx)
+{
+    // Раньше на каждом уровне рекурсии брались семь буферов и всё складывалось через
+    // moduleAddInplace, теперь - bigint_limbs::mul_karatsuba
+    const std::size_t threshold = ctx.getMulThresholds().karatsuba;
+    moduleScratchMulTo( res, a, b, ctx.getWorkspace()
+                      , [threshold](unsigned_t *r, const unsigned_t *x, std::size_t xn, const unsigned_t *y, std::size_t yn, unsigned_t *s)
+                        {
+                            bigint_limbs::mul_karatsuba(r, x, xn, y, yn, s, threshold);
+                        }
+                      , [threshold](std::size_t xn, std::size_t yn) { return bigint_limbs::karatsubaScratchSize(xn, yn, threshold); }
+                      );
+}
 
+//----------------------------------------------------------------------------
+inline
+BigInt::number_holder_t BigInt::moduleToom3Mul(const number_holder_t &a, const number_holder_t &b, const arithmetic_context &ctx)
+{
+    const mul_thresholds th = ctx.getMulThresholds();
+    number_holder_t res;
+    moduleScratchMulTo( res, a, b, ctx.getWorkspace()
+                      , [&th](unsigned_t *r, const unsigned_t *x, std::size_t xn, const unsigned_t *y, std::size_t yn, unsigned_t *s)
+                        {
+                            bigint_limbs::mul_toom3(r, x, xn, y, yn, s, th);
+                        }
+                      , [&th](std::size_t xn, std::size_t yn) { return bigint_limbs::toom3ScratchSize(xn, yn, th); }
+                      );
+    return res;
+}
+
+//----------------------------------------------------------------------------
+inline
+BigInt::number_holder_t BigInt::moduleToom4Mul(const number_holder_t &a, const number_holder_t &b, const arithmetic_context &ctx)
+{
+    const mul_thresholds th = ctx.getMulThresholds();
+    number_holder_t res;
+    moduleScratchMulTo( res, a, b, ctx.getWorkspace()
+                      , [&th](unsigned_t *r, const unsigned_t *x, std::size_t xn, const unsigned_t *y, std::size_t yn, unsigned_t *s)
+                        {
+                            bigint_limbs::mul_toom4(r, x, xn, y, yn, s, th);
+                        }
+                      , [&th](std::size_t xn, std::size_t yn) { return bigint_limbs::toom4ScratchSize(xn, yn, th); }
+                      );
+    return res;
+}
 
-    // у нас переполнение не один признак, а число типа unsigned_t
+//----------------------------------------------------------------------------
+inline
+BigInt::thread_pool* BigInt::moduleThreadPool(const arithmetic_context &ctx, std::size_t size)
+{
+    thread_pool *pPool = ctx.getThreadPool();
+    if (!pPool || pPool->concurrency()<2u || size<ctx.getMulThresholds().parallel)
+        return nullptr;
+    return pPool;
+}
 
-    number_holder_t overflow;
+//----------------------------------------------------------------------------
+inline
+BigInt::number_holder_t BigInt::moduleNttMul(const number_holder_t &a, const number_holder_t &b, const arithmetic_context &ctx)
+{
+    number_holder_t res;
 
-    for(std::size_t i=0; i!=convolution.size(); ++i)
-    {
-        // Конвертируем одиночный unsigned_t overflow предыдущего переполнения
-        // в number_holder_t через использование конструктора BigInt 
-        // из интегрального типа, и сразу берем модуль
-        // Этот модуль передаём в функцию сложения 
-        //moduleAddInplace(convolution[i], BigInt(overflow).m_module); // convolution[i] += overflow;
-        moduleAddInplace(convolution[i], overflow); // convolution[i] += overflow;
-        // if (convolution[i].size()>2)
-        //     throw std::runtime_error("moduleFurerMul: somethin goes wrong (1)");
-
-        // auto tmp = convolution[i];
-        // tmp.erase(tmp.begin(), tmp.begin()+ptrdiff_t(1));
-        // overflow = tmp;
-        overflow = convolution[i];
-        if (!overflow.empty()) // Чёт я уже подзабыл, нафига я это сделал, надо было прокоментить
-            overflow.erase(overflow.begin(), overflow.begin()+ptrdiff_t(1));
-
-        // if (convolution[i].size()>1)
-        //     overflow = convolution[i][1];
-        // else
-        //     overflow = 0;
-
-        // if (convolution[i].empty())
-        //     throw std::runtime_error("moduleFurerMul: somethin goes wrong (2)");
-
-        if (!convolution[i].empty())
-            res.push_back(convolution[i][0]);
-        
-    }
+    const std::size_t n1 = bigint_limbs::normalizedSize(a.data(), a.size());
+    const std::size_t n2 = bigint_limbs::normalizedSize(b.data(), b.size());
+    if (!n1 || !n2)
+        return res;
 
-    // if (overflow!=0)
-    //     res.emplace_back(overflow);
-    res.insert(res.end(), overflow.begin(), overflow.end());
+    // Вычеты - 32-битные слова, не чанки, берём их из отдельного буфера рабочей области.
+    // В пуле потоков свёртки по трём модулям идут одновременно, буфер больше
+    thread_pool       *pPool = moduleThreadPool(ctx, std::min(n1, n2));
+    scratch_workspace &ws    = ctx.getWorkspace();
+    std::uint32_t     *work  = ws.residues(bigint_limbs::nttWorkSize<unsigned_t>(n1, n2, pPool!=nullptr));
 
-    // using unsigned_t      = marty::bigint_details::unsigned_t;
-    // using unsigned2_t     = marty::bigint_details::unsigned2_t;
+    res.resize(n1+n2);
+    if (pPool)
+        bigint_limbs::mul_ntt(res.data(), a.data(), n1, b.data(), n2, work, bigint_details::pool_invoke(*pPool));
+    else
+        bigint_limbs::mul_ntt(res.data(), a.data(), n1, b.data(), n2, work);
 
     shrinkLeadingZeros(res);
-
     return res;
-
 }
 
 //----------------------------------------------------------------------------
 inline
-BigInt::number_holder_t BigInt::moduleKaratsubaMul(const number_holder_t &a, const number_holder_t &b)
+BigInt::number_holder_t BigInt::moduleFftMul(const number_holder_t &a, const number_holder_t &b, const arithmetic_context &ctx)
 {
-    // std::size_t size = m1.size()+m2.size();
-    std::size_t size = std::min(a.size(),b.size());
-    // if ((a.size()+b.size()) <= 4)
-    if (size<=2)
-       return moduleSchoolMul(a, b);
-
-    auto mid  = std::max(a.size(), b.size())/2u;
-    auto midA = ptrdiff_t(std::min(mid, a.size()));
-    auto midB = ptrdiff_t(std::min(mid, b.size()));
-    
-    auto low1  = number_holder_t(a.begin()       , a.begin() + midA);
-    auto high1 = number_holder_t(a.begin() + midA, a.end()         );
-    auto low2  = number_holder_t(b.begin()       , b.begin() + midB);
-    auto high2 = number_holder_t(b.begin() + midB, b.end()         );
-    
-    // Конвертим в BigInt, так как у нас есть вычитания, и, хотя в итоге должно получится положительное
-    // число, в промежуточных вычислениях теоретически могут получаться отрицательные значения
-    // (но я не проверял), а значит, нужна полновесная арифметика с учетом знака.
-    // Оверхед на учёт знака минимален.
+    scratch_workspace &ws = ctx.getWorkspace();
+
+    const std::size_t n1 = bigint_limbs::normalizedSize(a.data(), a.size());
+    const std::size_t n2 = bigint_limbs::normalizedSize(b.data(), b.size());
+    if (!n1 || !n2)
+        return number_holder_t();
+
+    // Для таких размеров точность double не гарантирована
+    const std::size_t workSize = bigint_limbs::fftWorkSize<unsigned_t>(n1, n2);
+    if (!workSize)
+        return moduleChunkedFftMul(a, b, ctx);
 
-    auto z0 = BigInt(1, moduleKaratsubaMul(low1, low2));
-    auto z1 = BigInt(1, moduleKaratsubaMul(moduleAdd(low1, high1), moduleAdd(low2, high2)));
-    auto z2 = BigInt(1, moduleKaratsubaMul(high1, high2));
+    thread_pool *pPool = moduleThreadPool(ctx, std::min(n1, n2));
 
-    auto z2_shifted_by_2mid = BigInt(1, moduleShiftLeftCopy(z2.m_module, 2*int(mid))); // (z2 << (2*std::size_t(mid)))
+    number_holder_t res;
+    res.resize(n1+n2);
+    const bool exact = pPool
+                     ? bigint_limbs::mul_fft(res.data(), a.data(), n1, b.data(), n2, ws.fftData(workSize), bigint_details::pool_invoke(*pPool))
+                     : bigint_limbs::mul_fft(res.data(), a.data(), n1, b.data(), n2, ws.fftData(workSize))
+                     ;
+    if (!exact)
+        return moduleNttMul(a, b, ctx); // отклонение от целых больше допустимого
+
+    shrinkLeadingZeros(res);
+    return res;
+}
+
+//----------------------------------------------------------------------------
+inline
+BigInt::number_holder_t BigInt::moduleChunkedFftMul(const number_holder_t &a, const number_holder_t &b, const arithmetic_context &ctx)
+{
+    // Всё произведение для FFT слишком длинное, но множители сильно разной длины -
+    // режем длинный на куски по длине короткого, каждый кусок - своим FFT.
+    // Если и короткий не проходит по точности - NTT
+    const std::size_t n1 = bigint_limbs::normalizedSize(a.data(), a.size());
+    const std::size_t n2 = bigint_limbs::normalizedSize(b.data(), b.size());
+    if (!n1 || !n2)
+        return number_holder_t();
+
+    const number_holder_t &m1 = !(n1<n2) ? a : b; // длинный
+    const number_holder_t &m2 =  (n1<n2) ? a : b;
+    const std::size_t      ns = std::min(n1, n2);
+
+    scratch_workspace &ws = ctx.getWorkspace();
+
+    const std::size_t workSize = bigint_limbs::fftWorkSize<unsigned_t>(ns, ns);
+    if (!workSize)
+        return moduleNttMul(a, b, ctx);
+
+    double *work = ws.fftData(workSize);
+
+    // Куски идут по очереди, параллельны (если есть пул) преобразования внутри куска
+    thread_pool *pPool = moduleThreadPool(ctx, ns);
+
+    // Если кусок всё же не пройдёт проверку точности - он умножается через bigint_limbs::mul,
+    // рабочая область - под этот случай
+    const mul_thresholds th = ctx.getMulThresholds();
+    number_holder_t res;
+    auto chunkedMul = [&](const auto &invoke)
+    {
+        moduleScratchMulTo( res, m1, m2, ws
+                          , [&th, work, &invoke](unsigned_t *r, const unsigned_t *x, std::size_t xn, const unsigned_t *y, std::size_t yn, unsigned_t *s)
+                            {
+                                bigint_limbs::details::mulChunked( r, x, xn, y, yn, s
+                                                                 , [&th, work, &invoke](unsigned_t *r_, const unsigned_t *x_, std::size_t xn_, const unsigned_t *y_, std::size_t yn_, unsigned_t *s_)
+                                                                   {
+                                                                       if (!bigint_limbs::mul_fft(r_, x_, xn_, y_, yn_, work, invoke))
+                                                                           bigint_limbs::mul(r_, x_, xn_, y_, yn_, s_, th);
+                                                                   }
+                                                                 );
+                            }
+                          , [&th](std::size_t xn, std::size_t yn)
+                            {
+                                return bigint_limbs::details::mulChunkedScratchSize(xn, yn, [&th](std::size_t xn_, std::size_t yn_) { return bigint_limbs::mulScratchSize(xn_, yn_, th); });
+                            }
+                          );
+    };
 
-    return (z2_shifted_by_2mid + (((z1 - z2 - z0) << int(mid))) + z0).m_module;
+    if (pPool)
+        chunkedMul(bigint_details::pool_invoke(*pPool));
+    else
+        chunkedMul(bigint_limbs::serial_invoke());
 
+    return res;
 }
 
 //----------------------------------------------------------------------------
 inline
-BigInt::number_holder_t BigInt::moduleAutoMul(const number_holder_t &m1, const number_holder_t &m2)
+BigInt::number_holder_t BigInt::moduleAutoMul(const number_holder_t &m1, const number_holder_t &m2, const arithmetic_context &ctx)
 {
+    // Пороги читаем один раз - размер рабочей области и само умножение должны считаться по одним
+    const mul_thresholds th = ctx.getMulThresholds();
+    scratch_workspace   &ws = ctx.getWorkspace();
+
     // std::size_t size = m1.size()+m2.size();
     std::size_t size = std::min(m1.size(),m2.size());
     //if (size<12)
-    if (size<=6)
+    // До 8 чанков у school есть развёрнутые варианты. Дальше по столбцам (comba) быстрее,
+    // чем по строкам, если только addmul_1 не идёт через ADX/BMI2
+    if (size<=8 || (size<th.karatsuba && bigint_limbs::hasFastAddmul<unsigned_t>()))
         return moduleSchoolMul(m1, m2);
-    // //else if (size<100)
-    // else if (size<50)
-    //     return moduleFurerMul(m1, m2);
-    // else
-    //     return moduleKaratsubaMul(m1, m2);
-    return moduleFurerMul(m1, m2);
+    else if (size<th.karatsuba)
+        return moduleCombaMul(m1, m2);
+    else if (size>=th.fft && bigint_limbs::fftWorkSize<unsigned_t>(m1.size(), m2.size()))
+        return moduleFftMul(m1, m2, ctx);
+    else if (size>=th.fft && bigint_limbs::fftWorkSize<unsigned_t>(size, size))
+        return moduleChunkedFftMul(m1, m2, ctx); // короткий проходит в FFT, всё произведение - нет
+    else if (size>=th.ntt)
+        return moduleNttMul(m1, m2, ctx);
+
+    // Дальше Карацуба/Тоом-3/Тоом-4 по размеру, на каждом уровне рекурсии заново.
+    // Сильно разные по длине множители - Тоом-2.5/3.5 или нарезка длинного по длине короткого
+    number_holder_t res;
+    if (thread_pool *pPool = moduleThreadPool(ctx, size))
+    {
+        // Верхние уровни - шаги Тоома-3, пять произведений в точках - задачи пула
+        const bigint_details::pool_invoke invoke(*pPool);
+        moduleScratchMulTo( res, m1, m2, ws
+                          , [&th, &invoke](unsigned_t *r, const unsigned_t *x, std::size_t xn, const unsigned_t *y, std::size_t yn, unsigned_t *s)
+                            {
+                                bigint_limbs::mul_parallel(r, x, xn, y, yn, s, th, invoke);
+                            }
+                          , [&th](std::size_t xn, std::size_t yn) { return bigint_limbs::parallelMulScratchSize(xn, yn, th); }
+                          );
+        return res;
+    }
+
+    moduleScratchMulTo( res, m1, m2, ws
+                      , [&th](unsigned_t *r, const unsigned_t *x, std::size_t xn, const unsigned_t *y, std::size_t yn, unsigned_t *s)
+                        {
+                            bigint_limbs::mul(r, x, xn, y, yn, s, th);
+                        }
+                      , [&th](std::size_t xn, std::size_t yn) { return bigint_limbs::mulScratchSize(xn, yn, th); }
+                      );
+    return res;
+}
+
+//----------------------------------------------------------------------------
+inline
+BigInt::number_holder_t BigInt::moduleBasecaseSqr(const number_holder_t &m)
+{
+    const std::size_t n = bigint_limbs::normalizedSize(m.data(), m.size());
+    if (!n)
+        return number_holder_t();
+
+    number_holder_t res;
+    res.resize(2u*n);
+    bigint_limbs::sqr_basecase(res.data(), m.data(), n);
+    shrinkLeadingZeros(res);
+
+    return res;
+}
+
+//----------------------------------------------------------------------------
+inline
+BigInt::number_holder_t BigInt::moduleAutoSqr(const number_holder_t &m, const arithmetic_context &ctx)
+{
+    // То же, что moduleAutoMul, но до Карацубы - квадрат по строкам, а рабочая область
+    // для Карацубы/Тоома - меньше
+    const mul_thresholds th = ctx.getMulThresholds();
+    scratch_workspace   &ws = ctx.getWorkspace();
+
+    const std::size_t size = m.size();
+    if (size<th.sqrKaratsuba)
+        return moduleBasecaseSqr(m);
+    else if (size>=th.fft && bigint_limbs::fftWorkSize<unsigned_t>(size, size))
+        return moduleFftMul(m, m, ctx);
+    else if (size>=th.ntt)
+        return moduleNttMul(m, m, ctx);
+
+    number_holder_t res;
+    if (thread_pool *pPool = moduleThreadPool(ctx, size))
+    {
+        // mul_parallel с одним и тем же массивом - квадраты на всех уровнях
+        const bigint_details::pool_invoke invoke(*pPool);
+        moduleScratchMulTo( res, m, m, ws
+                          , [&th, &invoke](unsigned_t *r, const unsigned_t *a, std::size_t an, const unsigned_t*, std::size_t, unsigned_t *s)
+                            {
+                                bigint_limbs::mul_parallel(r, a, an, a, an, s, th, invoke);
+                            }
+                          , [&th](std::size_t an, std::size_t) { return bigint_limbs::parallelMulScratchSize(an, an, th); }
+                          );
+        return res;
+    }
+
+    moduleScratchMulTo( res, m, m, ws
+                      , [&th](unsigned_t *r, const unsigned_t *a, std::size_t an, const unsigned_t*, std::size_t, unsigned_t *s)
+                        {
+                            bigint_limbs::sqr(r, a, an, s, th);
+                        }
+                      , [&th](std::size_t an, std::size_t) { return bigint_limbs::sqrScratchSize(an, th); }
+                      );
+    return res;
+}
+
+//----------------------------------------------------------------------------
+inline
+BigInt::number_holder_t BigInt::moduleSqr(const number_holder_t &m, const arithmetic_context &ctx)
+{
+    switch(ctx.getMultiplicationMethod())
+    {
+        case MultiplicationMethod::school:
+        case MultiplicationMethod::comba: // aka furer
+             return moduleBasecaseSqr(m);
+
+        case MultiplicationMethod::auto_:
+             return moduleAutoSqr(m, ctx);
+
+        default:
+             return moduleMul(m, m, ctx);
+    }
 }
 
 //----------------------------------------------------------------------------
 inline
-BigInt::number_holder_t BigInt::moduleMul(const number_holder_t &m1, const number_holder_t &m2)
+BigInt::number_holder_t BigInt::moduleMul(const number_holder_t &m1, const number_holder_t &m2, const arithmetic_context &ctx)
 {
-    switch(s_multiplicationMethod)
+    switch(ctx.getMultiplicationMethod())
     {
         case MultiplicationMethod::school:
              return moduleSchoolMul(m1, m2);
 
         case MultiplicationMethod::karatsuba:
-             return moduleKaratsubaMul(m1, m2);
+             return moduleKaratsubaMul(m1, m2, ctx);
+
+        case MultiplicationMethod::comba: // aka furer
+             return moduleCombaMul(m1, m2);
+
+        case MultiplicationMethod::toom3:
+             return moduleToom3Mul(m1, m2, ctx);
 
-        case MultiplicationMethod::furer:
-             return moduleFurerMul(m1, m2);
+        case MultiplicationMethod::toom4:
+             return moduleToom4Mul(m1, m2, ctx);
+
+        case MultiplicationMethod::ntt:
+             return moduleNttMul(m1, m2, ctx);
+
+        case MultiplicationMethod::fft:
+             return moduleFftMul(m1, m2, ctx);
 
         case MultiplicationMethod::auto_: [[fallthrough]];
         default:
-             return moduleAutoMul(m1, m2);
+             return moduleAutoMul(m1, m2, ctx);
     }
 }
 
 //----------------------------------------------------------------------------
 inline
-BigInt& BigInt::mulImpl(const BigInt &b)
+BigInt& BigInt::mulImpl(const BigInt &b, const arithmetic_context &ctx)
 {
     m_sign = m_sign*b.m_sign;
     if (m_sign==0)
@@ -879,8 +868,223 @@ BigInt& BigInt::mulImpl(const BigInt &b)
         return *this;
     }
 
-    m_module = moduleMul(m_module, b.m_module);
+    // a*a (в том числе x*=x) - квадрат
+    if (this==&b || m_module==b.m_module)
+        m_module = moduleSqr(m_module, ctx);
+    else
+        m_module = moduleMul(m_module, b.m_module, ctx);
+
+    return *this;
+}
+
+//----------------------------------------------------------------------------
+inline
+BigInt& BigInt::sqrImpl(const arithmetic_context &ctx)
+{
+    m_sign = m_sign*m_sign;
+    if (m_sign==0)
+    {
+        m_module.clear();
+        return *this;
+    }
+
+    m_module = moduleSqr(m_module, ctx);
+
+    return *this;
+}
+
+//----------------------------------------------------------------------------
+inline
+BigInt& BigInt::powImpl(unsigned exp, const arithmetic_context &ctx)
+{
+    if (exp==0)
+    {
+        *this = BigInt(1); // в том числе 0^0
+        return *this;
+    }
+
+    if (m_sign==0)
+        return *this;
+
+    if (!(exp&1u))
+        m_sign = 1;
+
+    // base = odd*2^tz, base^exp = odd^exp * 2^(tz*exp) - степень считается только у нечётной части
+    std::size_t zc = 0;
+    while(!m_module[zc])
+        ++zc;
+
+    int zb = 0;
+    while(!((m_module[zc]>>zb)&1u))
+        ++zb;
+
+    const std::size_t tz    = zc*chunkSizeBits + std::size_t(zb);
+    const std::size_t shift = tz*exp;
+    if (tz && (shift/tz!=exp || shift>std::size_t(INT_MAX)))
+        throw std::overflow_error("BigInt::pow: result is too large");
+
+    const number_holder_t odd = tz ? moduleShiftRightCopy(m_module, int(tz)) : m_module;
+    const std::size_t     on  = odd.size();
+
+    // Промежуточные значения не больше результата, а произведение занимает не больше чем на
+    // чанк больше своего значения - оба буфера сразу такого размера. Без переаллокаций - только
+    // шаги, которые пишут прямо в буферы (см. inplace ниже); moduleSqr/moduleMul возвращают
+    // новый модуль, и он заменяет собой буфер
+    const std::size_t oddBits = on*chunkSizeBits - std::size_t(bigint_limbs::countLeadingZeros(odd[on-1u]));
+    const std::size_t resSize = (oddBits*exp + chunkSizeBits-1u)/chunkSizeBits + 1u + shift/chunkSizeBits + 1u;
+
+    number_holder_t a;
+    a.reserve(resSize);
+
+    if (on==1u && odd[0]==1u)
+    {
+        // Степень двойки - одним сдвигом
+        a.push_back(unsigned_t(1));
+        moduleShiftLeft(a, int(shift));
+        m_module = std::move(a);
+        return *this;
+    }
+
+    number_holder_t b;
+    b.reserve(resSize);
+    a.assign(odd.data(), odd.data()+on);
+
+    // Пока не нужны FFT/NTT и пул потоков - квадраты и умножения прямо в чанки буферов,
+    // иначе - выбранным методом, с новым модулем
+    const mul_thresholds th       = ctx.getMulThresholds();
+    const bool           autoMeth = ctx.getMultiplicationMethod()==MultiplicationMethod::auto_;
+    auto inplace = [&](std::size_t size)
+    {
+        return autoMeth && size<th.fft && size<th.ntt && !moduleThreadPool(ctx, size);
+    };
+
+    bigint_details::scratch_holder s(ctx.getWorkspace());
+
+    int hb = int(sizeof(unsigned)*CHAR_BIT) - 1;
+    while(!((exp>>hb)&1u))
+        --hb;
+
+    for(int i=hb-1; i>=0; --i)
+    {
+        std::size_t n = a.size();
+        if (inplace(n))
+        {
+            b.resize(2u*n);
+            s->resize(std::max(s->size(), bigint_limbs::sqrScratchSize(n, th)));
+            bigint_limbs::sqr(b.data(), a.data(), n, s->data(), th);
+            shrinkLeadingZeros(b);
+        }
+        else
+        {
+            b = moduleSqr(a, ctx);
+        }
+        std::swap(a, b);
+
+        if (!((exp>>i)&1u))
+            continue;
+
+        n = a.size();
+        if (inplace(std::min(n, on)))
+        {
+            b.resize(n+on);
+            s->resize(std::max(s->size(), bigint_limbs::mulScratchSize(n, on, th)));
+            bigint_limbs::mul(b.data(), a.data(), n, odd.data(), on, s->data(), th);
+            shrinkLeadingZeros(b);
+        }
+        else
+        {
+            b = moduleMul(a, odd, ctx);
+        }
+        std::swap(a, b);
+    }
+
+    if (shift)
+        moduleShiftLeft(a, int(shift));
+
+    m_module = std::move(a);
+    return *this;
+}
+
+//----------------------------------------------------------------------------
+inline
+BigInt& BigInt::addInplaceImpl(int signOther, const number_holder_t &moduleOther)
+{
+    const std::size_t n2 = bigint_limbs::normalizedSize(moduleOther.data(), moduleOther.size());
+    if (signOther==0 || !n2)
+        return *this;
+
+    if (m_sign==0)
+        m_sign = signOther; // дальше - сложение с нулевым модулем
+
+    if (m_sign==signOther)
+    {
+        moduleAddInplace(m_module, moduleOther, 0);
+        return *this;
+    }
+
+    // Знаки разные - вычитаем в дополнительном коде, заём из старшего чанка значит, что
+    // вычитаемое больше, тогда берём модуль и меняем знак
+    if (m_module.size()<n2)
+        m_module.resize(n2, 0u);
+
+    if (bigint_limbs::sub(m_module.data(), m_module.data(), m_module.size(), moduleOther.data(), n2))
+    {
+        bigint_limbs::neg(m_module.data(), m_module.size());
+        m_sign = -m_sign;
+    }
+
+    shrinkLeadingZeros();
+    return *this;
+}
+
+//----------------------------------------------------------------------------
+inline
+BigInt& BigInt::addmulImpl(int signMul, const BigInt &a, const BigInt &b, const arithmetic_context &ctx)
+{
+    const int signProd = a.m_sign*b.m_sign*signMul;
+    if (signProd==0)
+        return *this;
+
+    // Множитель - сам аккумулятор (acc.addmul(acc, x)): писать в его чанки нельзя
+    if (this==&a || this==&b)
+    {
+        BigInt p = a;
+        p.mulImpl(b, ctx);
+        return addInplaceImpl(signProd, p.m_module);
+    }
+
+    const number_holder_t &m1 = !(a.m_module.size()<b.m_module.size()) ? a.m_module : b.m_module; // длинный
+    const number_holder_t &m2 =  (a.m_module.size()<b.m_module.size()) ? a.m_module : b.m_module;
+
+    const std::size_t n1 = bigint_limbs::normalizedSize(m1.data(), m1.size());
+    const std::size_t n2 = bigint_limbs::normalizedSize(m2.data(), m2.size());
+
+    if (n2>=ctx.getMulThresholds().karatsuba)
+    {
+        // Дальше произведение дешевле считать быстрым алгоритмом целиком, а складывать -
+        // уже на месте
+        const number_holder_t p = (&a==&b || a.m_module==b.m_module) ? moduleSqr(m1, ctx) : moduleMul(m1, m2, ctx);
+        return addInplaceImpl(signProd, p);
+    }
+
+    // Короткий множитель - строки addmul_1/submul_1 прямо в чанки аккумулятора
+    const std::size_t rn = std::max(m_module.size(), n1+n2);
+    m_module.resize(rn, 0u);
+
+    if (m_sign==0 || m_sign==signProd)
+    {
+        m_sign = signProd;
+        const unsigned_t carry = bigint_limbs::addmul_basecase(m_module.data(), rn, m1.data(), n1, m2.data(), n2);
+        if (carry)
+            m_module.push_back(carry);
+    }
+    else if (bigint_limbs::submul_basecase(m_module.data(), rn, m1.data(), n1, m2.data(), n2))
+    {
+        bigint_limbs::neg(m_module.data(), rn);
+        m_sign = -m_sign;
+    }
 
+    shrinkLeadingZeros();
     return *this;
 }
 
@@ -896,8 +1100,20 @@ const char* BigInt::getMultiplicationMethodName(MultiplicationMethod mm)
         case MultiplicationMethod::karatsuba:
              return "karatsuba";
 
-        case MultiplicationMethod::furer:
-             return "furer";
+        case MultiplicationMethod::comba: // aka furer
+             return "comba";
+
+        case MultiplicationMethod::toom3:
+             return "toom3";
+
+        case MultiplicationMethod::toom4:
+             return "toom4";
+
+        case MultiplicationMethod::ntt:
+             return "ntt";
+
+        case MultiplicationMethod::fft:
+             return "fft";
 
         case MultiplicationMethod::auto_: [[fallthrough]];
         default:
@@ -910,22 +1126,31 @@ const char* BigInt::getMultiplicationMethodName(MultiplicationMethod mm)
 inline
 const char* BigInt::getMultiplicationMethodName()
 {
-    return getMultiplicationMethodName(s_multiplicationMethod);
+    return getMultiplicationMethodName(getMultiplicationMethod());
 }
 
 //----------------------------------------------------------------------------
-// Делит m1 на m2, остаток от деления остаётся в m1
-// static number_holder_t moduleSchoolDiv(number_holder_t &m1, const number_holder_t &m2);
-// static bool moduleIsZero(const number_holder_t &m);
-// static int moduleCompare(const number_holder_t &m1, number_holder_t m2, std::size_t beginIdxM1=std::size_t(-1), std::size_t endIdxM1=std::size_t(-1));
+// Делит m1 на m2: частное - в q (в его буфере, если ёмкости хватает), остаток остаётся в m1.
+// q, m1 и m2 - разные объекты
 inline
-BigInt::number_holder_t BigInt::moduleSchoolDiv(number_holder_t &m1, number_holder_t m2)
+void BigInt::moduleSchoolDivTo(number_holder_t &q, number_holder_t &m1, const number_holder_t &m2, scratch_workspace &ws)
 {
     shrinkLeadingZeros(m1);
     if (m1.empty())
-        return m1;
+    {
+        q.clear();
+        return;
+    }
 
-    shrinkLeadingZeros(m2);
+    if (!m2.empty() && m2.back()==0)
+    {
+        // Делитель с ведущими нулями бывает редко, обрезаем копию
+        scratch_holder m2Shrinked(ws);
+        *m2Shrinked = m2;
+        shrinkLeadingZeros(*m2Shrinked);
+        moduleSchoolDivTo(q, m1, *m2Shrinked, ws);
+        return;
+    }
 
     if (moduleIsZero(m2))
         throw std::overflow_error("BigInt: division by zero");
@@ -933,94 +1158,140 @@ BigInt::number_holder_t BigInt::moduleSchoolDiv(number_holder_t &m1, number_hold
     // Проверяем, что m1 < m2. Если да, результат 0, остаток m1.
     if (moduleCompare(m1, m2) < 0)
     {
-        return number_holder_t(); // Возвращаем 0
+        q.clear();
+        return;
     }
 
-    std::size_t nShift = m1.size() - m2.size() + 1u;
-
-    // reverse result
-    number_holder_t rRes; rRes.reserve(nShift);
-
-    while(nShift-->0)
+    if (m2.size()==1u)
     {
-        const std::size_t idxM1 = m2.size()+nShift-1u;
-        unsigned2_t h1 = unsigned2_t(m1[idxM1]);
-        if ((idxM1+1)<m1.size())
-        {
-            unsigned_t h1_2 = m1[idxM1+1];
-            h1 += unsigned2_t(unsigned2_t(h1_2)<<((sizeof(unsigned2_t)/2)*CHAR_BIT));
-        }
-        const unsigned2_t h2 = unsigned2_t(m2.back());
-        unsigned_t qHat = unsigned_t(h1/h2); // back - m2[m2.size()-1] - старшая часть
-        if (qHat)
-        {
-            number_holder_t sub = moduleAutoMul(m2, number_holder_t(1, qHat));
-            std::size_t nShiftEnd = nShift+m2.size()+1;
-            int cmpRes = moduleCompare(m1, sub, nShiftEnd, nShift);
-            while(qHat && cmpRes<0)
-            {
-                --qHat;
-                moduleSubInplace(sub, m2);
-                cmpRes = moduleCompare(m1, sub, nShiftEnd, nShift);
-            }
-
-            rRes.push_back(qHat);
+        // Делитель из одного чанка - делим сразу, без оценок цифр частного
+        q.resize(m1.size());
+        const unsigned_t r = bigint_limbs::divrem_1(q.data(), m1.data(), m1.size(), m2[0]);
+        m1.assign(1u, r);
+        shrinkLeadingZeros(m1);
+        shrinkLeadingZeros(q);
+        return;
+    }
 
-            moduleSubInplace(m1, sub, nShift, nShiftEnd);
-        }
-        else
-        {
-            rRes.push_back(0);
-        }
+    // Алгоритм D Кнута: нормализация сдвигом, цифра частного по двум чанкам, вычитание на месте.
+    // Нормализованные копии делимого и делителя - в рабочей области
+    q.resize(m1.size()-m2.size()+1u);
 
-    }
+    scratch_holder s(ws, bigint_limbs::divremScratchSize(m1.size(), m2.size()));
+    s->resize(bigint_limbs::divremScratchSize(m1.size(), m2.size()));
 
-    std::reverse(rRes.begin(), rRes.end());
-    shrinkLeadingZeros(rRes);
+    bigint_limbs::divrem(q.data(), m1.data(), m1.size(), m2.data(), m2.size(), s->data());
 
-    return rRes;
+    shrinkLeadingZeros(m1);
+    shrinkLeadingZeros(q);
+}
 
+//----------------------------------------------------------------------------
+inline
+BigInt::number_holder_t BigInt::moduleSchoolDiv(number_holder_t &m1, const number_holder_t &m2, scratch_workspace &ws)
+{
+    number_holder_t q;
+    moduleSchoolDivTo(q, m1, m2, ws);
+    return q;
 }
+
 //----------------------------------------------------------------------------
 inline
-BigInt& BigInt::divImpl(const BigInt &b) // Делит текущий объект на b
+BigInt& BigInt::divImpl(const BigInt &b, const arithmetic_context &ctx) // Делит текущий объект на b
 {
     if (b.m_sign==0)
         throw std::overflow_error("BigInt: division by zero");
 
-    m_sign = m_sign*b.m_sign;
-    if (m_sign==0)
+    const int sign = m_sign*b.m_sign;
+    if (sign==0)
     {
+        m_sign = 0;
         m_module.clear();
         return *this;
     }
 
-    m_module = moduleDiv(m_module, b.m_module);
+    if (this==&b)
+    {
+        *this = BigInt(1);
+        return *this;
+    }
+
+    // Делимое - в рабочую область (там же останется остаток), частное - прямо в свой буфер
+    scratch_holder rem(ctx.getWorkspace());
+    *rem = m_module;
+    moduleDivTo(m_module, *rem, b.m_module, ctx);
+
+    m_sign = sign;
     shrinkLeadingZeros();
 
     return *this;
 }
+
 //----------------------------------------------------------------------------
 inline
-BigInt& BigInt::remImpl(const BigInt &b)
+BigInt& BigInt::remImpl(const BigInt &b, const arithmetic_context &ctx)
 {
     if (b.m_sign==0)
         throw std::overflow_error("BigInt: division by zero");
 
-    // m_sign = m_sign*b.m_sign;
-    if (m_sign==0)
+    if (m_sign==0 || this==&b)
     {
+        m_sign = 0;
         m_module.clear();
         return *this;
     }
 
-    // m_sign = 1; // Для остатка - всегда + (или нет?)
-    moduleDiv(m_module, b.m_module);
+    // Остаток - со знаком делимого. Частное не нужно, под него - рабочая область
+    scratch_holder q(ctx.getWorkspace());
+    moduleDivTo(*q, m_module, b.m_module, ctx);
     shrinkLeadingZeros();
 
     return *this;
 }
 
+//----------------------------------------------------------------------------
+inline
+void BigInt::divMod(const BigInt &a, const BigInt &b, BigInt &q, BigInt &r, const arithmetic_context &ctx)
+{
+    if (&q==&r)
+        throw std::invalid_argument("BigInt::divMod: quotient and remainder must be different objects");
+
+    if (b.m_sign==0)
+        throw std::overflow_error("BigInt: division by zero");
+
+    const int signQ = a.m_sign*b.m_sign;
+    const int signR = a.m_sign;
+
+    // Делитель может быть одним из выходов - тогда его копия в рабочей области
+    scratch_holder         bCopy(ctx.getWorkspace());
+    const number_holder_t *pDivisor = &b.m_module;
+    if (&b==&q || &b==&r)
+    {
+        *bCopy   = b.m_module;
+        pDivisor = &bCopy.get();
+    }
+
+    // Делимое копируется в r (там и останется остаток) до того, как q перезаписан
+    if (&r!=&a)
+        r.m_module = a.m_module;
+
+    if (signQ==0)
+    {
+        q.m_module.clear();
+        r.m_module.clear();
+    }
+    else
+    {
+        moduleDivTo(q.m_module, r.m_module, *pDivisor, ctx);
+    }
+
+    q.m_sign = signQ;
+    q.shrinkLeadingZeros();
+    r.m_sign = signR;
+    r.shrinkLeadingZeros();
+}
+
+//----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
 inline
 std::string BigInt::moduleToStringReversed(int base, bool upperCase) const
@@ -1040,7 +1311,7 @@ std::string BigInt::moduleToStringReversed(int base, bool upperCase) const
         {
             for(std::size_t i=0; i!=chunkSizeBits; ++i, chunk>>=1)
             {
-                resStr.append(1, bigint_utils::digitToChar(chunk&1, upperCase));
+                resStr.append(1, bigint_utils::digitToChar(int(chunk&1u), upperCase));
             }
         }
     }
@@ -1052,7 +1323,7 @@ std::string BigInt::moduleToStringReversed(int base, bool upperCase) const
         {
             for(std::size_t i=0; i!=chunkSizeHexDigits; ++i, chunk>>=4)
             {
-                resStr.append(1, bigint_utils::digitToChar(chunk&0xF, upperCase));
+                resStr.append(1, bigint_utils::digitToChar(int(chunk&0xFu), upperCase));
             }
         }
     }
@@ -1061,27 +1332,15 @@ std::string BigInt::moduleToStringReversed(int base, bool upperCase) const
         number_holder_t module10; module10.reserve(m_module.size());
     
         constexpr const int chunkPwr10 = bigint_utils::getTypeDecimalDigits<unsigned_t>();
-        const BigInt biDividerMod10 = bigint_utils::getPower10(chunkPwr10);
+        const unsigned_t divider10 = bigint_utils::getPower10<unsigned_t>(chunkPwr10);
     
+        // Делим на месте на один чанк, остатки - очередные 10-ричные цифры
         number_holder_t rem = m_module;
-        while(true)
+        shrinkLeadingZeros(rem);
+        while(!rem.empty())
         {
-            auto nextModule = moduleDiv(rem, biDividerMod10.m_module);
-            shrinkLeadingZeros(nextModule);
+            module10.push_back(bigint_limbs::divrem_1(rem.data(), rem.data(), rem.size(), divider10));
             shrinkLeadingZeros(rem);
-    
-            if (rem.size()>1)
-                throw std::runtime_error("BigInt::moduleToStringReversed(): something goes wrong");
-    
-            if (rem.empty())
-                module10.push_back(0u);
-            else
-                module10.push_back(rem.front());
-    
-            if (nextModule.empty())
-                break;
-    
-            rem = nextModule;
         }
     
         // 2718121812459045
@@ -1113,27 +1372,15 @@ std::string BigInt::moduleToStringReversed(int base, bool upperCase) const
         number_holder_t module8; module8.reserve(m_module.size());
     
         constexpr const int chunkPwr8 = bigint_utils::getTypeOctalDigits<unsigned_t>();
-        const BigInt biDividerMod8 = bigint_utils::getPower8(chunkPwr8);
+        const unsigned_t divider8 = bigint_utils::getPower8<unsigned_t>(chunkPwr8);
     
+        // Делим на месте на один чанк, остатки - очередные 8-ричные цифры
         number_holder_t rem = m_module;
-        while(true)
+        shrinkLeadingZeros(rem);
+        while(!rem.empty())
         {
-            auto nextModule = moduleDiv(rem, biDividerMod8.m_module);
-            shrinkLeadingZeros(nextModule);
+            module8.push_back(bigint_limbs::divrem_1(rem.data(), rem.data(), rem.size(), divider8));
             shrinkLeadingZeros(rem);
-    
-            if (rem.size()>1)
-                throw std::runtime_error("BigInt::moduleToStringReversed(): something goes wrong (8)");
-    
-            if (rem.empty())
-                module8.push_back(0u);
-            else
-                module8.push_back(rem.front());
-    
-            if (nextModule.empty())
-                break;
-    
-            rem = nextModule;
         }
     
         //std::string resStr; 
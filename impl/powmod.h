@@ -0,0 +1,302 @@
+// Без #pragma once: файл подключается из marty_bigint.h, montgomery.h и barrett.h, а
+// разворачивается один раз - когда уже определены и MontgomeryContext, и BarrettReducer
+#if defined(MARTY_BIGINT_MONTGOMERY_H) && defined(MARTY_BIGINT_BARRETT_H) && !defined(MARTY_BIGINT_IMPL_POWMOD_H)
+#define MARTY_BIGINT_IMPL_POWMOD_H
+
+
+//----------------------------------------------------------------------------
+namespace marty {
+namespace bigint_details {
+
+
+//----------------------------------------------------------------------------
+// Движки возведения в степень по модулю: значения во внутреннем представлении
+// (enter/leave), единица, произведение и квадрат по модулю
+
+struct powmod_montgomery
+{
+    const MontgomeryContext &ctx;
+
+    std::size_t size() const                                      { return ctx.size(); }
+    BigInt enter(const BigInt &a) const                           { return ctx.toMont(a); }
+    BigInt leave(const BigInt &a) const                           { return ctx.fromMont(a); }
+    const BigInt& one() const                                     { return ctx.one(); }
+    void mul(BigInt &r, const BigInt &a, const BigInt &b) const   { ctx.mul(r, a, b); }
+    void sqr(BigInt &r, const BigInt &a) const                    { ctx.sqr(r, a); }
+};
+
+struct powmod_barrett
+{
+    const BarrettReducer &br;
+    BigInt                oneValue;
+
+    std::size_t size() const                                      { return br.size(); }
+    BigInt enter(const BigInt &a) const                           { return br.reduce(a); }
+    BigInt leave(const BigInt &a) const                           { return a; }
+    const BigInt& one() const                                     { return oneValue; }
+    void mul(BigInt &r, const BigInt &a, const BigInt &b) const   { br.mul(r, a, b); }
+    void sqr(BigInt &r, const BigInt &a) const                    { br.sqr(r, a); }
+};
+
+//----------------------------------------------------------------------------
+inline
+std::size_t powModBitLength(const BigInt &a)
+{
+    if (a.sign()==0)
+        return 0u;
+
+    const std::size_t n = a.chunksSize();
+    return n*std::size_t(bigint_limbs::limbBits<BigInt::chunk_type>()) - std::size_t(bigint_limbs::countLeadingZeros(a.chunksData()[n-1u]));
+}
+
+inline
+bool powModTestBit(const BigInt &a, std::size_t i)
+{
+    const std::size_t bits = std::size_t(bigint_limbs::limbBits<BigInt::chunk_type>());
+    const std::size_t idx  = i/bits;
+    return idx<a.chunksSize() && ((a.chunksData()[idx]>>(i%bits))&1u)!=0;
+}
+
+// Биты [b, e) степени как число, e-b - не больше размера окна
+inline
+unsigned powModBits(const BigInt &a, std::size_t b, std::size_t e)
+{
+    unsigned v = 0;
+    for(std::size_t i=e; i!=b; --i)
+        v = (v<<1) | (powModTestBit(a, i-1u) ? 1u : 0u);
+    return v;
+}
+
+//----------------------------------------------------------------------------
+//! Размер окна по длине степени в битах: окно k стоит 2^(k-1) умножений на таблицу и экономит
+//! примерно bits/(k+1) умножений на проход, пороги - как у OpenSSL (BN_window_bits_for_exponent_size)
+inline
+unsigned powModWindowBits(std::size_t expBits)
+{
+    if (expBits>671) return 6;
+    if (expBits>239) return 5;
+    if (expBits>79 ) return 4;
+    if (expBits>23 ) return 3;
+    return 1;
+}
+
+//----------------------------------------------------------------------------
+//! Скользящее окно: окна начинаются и кончаются единичным битом, нули между ними - только
+//! квадраты. Таблица - нечётные степени g, g^3, ..., g^(2^k-1)
+template<typename Engine>
+BigInt powModSliding(const Engine &e, const BigInt &base, const BigInt &exp)
+{
+    const std::size_t expBits = powModBitLength(exp);
+    const unsigned    k       = powModWindowBits(expBits);
+
+    std::vector<BigInt> tbl(std::size_t(1)<<(k-1u));
+    tbl[0] = e.enter(base);
+    if (tbl.size()>1u)
+    {
+        BigInt g2;
+        e.sqr(g2, tbl[0]);
+        for(std::size_t i=1; i!=tbl.size(); ++i)
+            e.mul(tbl[i], tbl[i-1u], g2);
+    }
+
+    BigInt r;
+    bool   first = true; // старший бит степени - единица, первое окно просто берётся из таблицы
+
+    std::size_t i = expBits; // обработаны биты от i и выше
+    while(i!=0)
+    {
+        if (!powModTestBit(exp, i-1u))
+        {
+            e.sqr(r, r);
+            --i;
+            continue;
+        }
+
+        std::size_t j = i>k ? i-k : 0u;
+        while(!powModTestBit(exp, j))
+            ++j;
+
+        const unsigned v = powModBits(exp, j, i);
+        if (first)
+        {
+            r     = tbl[v>>1];
+            first = false;
+        }
+        else
+        {
+            for(std::size_t s=j; s!=i; ++s)
+                e.sqr(r, r);
+            e.mul(r, r, tbl[v>>1]);
+        }
+
+        i = j;
+    }
+
+    return e.leave(r);
+}
+
+//----------------------------------------------------------------------------
+//! Фиксированное окно: степень (дополненная нулями до длины модуля) - цифрами по k бит, на
+//! цифру - k квадратов и одно умножение, в том числе на единицу для нулевой цифры. Элемент
+//! таблицы выбирается проходом по всей таблице с маской, а не индексом. Число и порядок
+//! операций не зависят от битов степени, но сами ядра умножения (финальное вычитание модуля,
+//! нормализация длины BigInt) не константного времени - так считается только чётный модуль
+//! (Barrett), для нечётного есть перегрузка ниже
+template<typename Engine>
+BigInt powModFixed(const Engine &e, const BigInt &base, const BigInt &exp, std::size_t modBits)
+{
+    using chunk_type = BigInt::chunk_type;
+
+    const std::size_t expBits = std::max(powModBitLength(exp), modBits);
+    const unsigned    k       = std::max(powModWindowBits(expBits), 2u);
+    const std::size_t n       = e.size();
+    const std::size_t tn      = std::size_t(1)<<k;
+
+    // Все степени g^0..g^(2^k-1), по n чанков каждая
+    bigint_details::number_holder_t tbl(tn*n, chunk_type(0));
+    {
+        const BigInt g = e.enter(base);
+        BigInt       p = e.one();
+        for(std::size_t t=0; t!=tn; ++t)
+        {
+            std::copy(p.chunksData(), p.chunksData()+p.chunksSize(), tbl.begin()+std::ptrdiff_t(t*n));
+            e.mul(p, p, g);
+        }
+    }
+
+    bigint_details::number_holder_t sel(n, chunk_type(0));
+    BigInt                          selected;
+    BigInt                          r = e.one();
+
+    const std::size_t digits = (expBits+k-1u)/k;
+    for(std::size_t d=digits; d!=0; --d)
+    {
+        for(unsigned s=0; s!=k; ++s)
+            e.sqr(r, r);
+
+        const std::size_t b = (d-1u)*k;
+        const unsigned    v = powModBits(exp, b, b+k);
+
+        std::fill(sel.begin(), sel.end(), chunk_type(0));
+        for(std::size_t t=0; t!=tn; ++t)
+        {
+            const chunk_type mask = chunk_type(chunk_type(0) - chunk_type(t==v));
+            for(std::size_t i=0; i!=n; ++i)
+                sel[i] = chunk_type(sel[i] | (tbl[t*n+i] & mask));
+        }
+
+        selected.assignChunks(1, sel.data(), n);
+        e.mul(r, r, selected);
+    }
+
+    return e.leave(r);
+}
+
+//----------------------------------------------------------------------------
+//! Фиксированное окно по нечётному модулю: та же схема, но все промежуточные значения - в
+//! буферах ровно по n чанков, а умножение - mont_mul_fixed (без ветвлений, с маскированным
+//! финальным вычитанием). BigInt собирается только из результата, уже выведенного из формы
+//! Монтгомери умножением на 1. Время не зависит от битов степени, если умножение чанков
+//! в процессоре постоянного времени
+inline
+BigInt powModFixed(const powmod_montgomery &e, const BigInt &base, const BigInt &exp, std::size_t modBits)
+{
+    using chunk_type = BigInt::chunk_type;
+
+    const std::size_t expBits = std::max(powModBitLength(exp), modBits);
+    const unsigned    k       = std::max(powModWindowBits(expBits), 2u);
+    const std::size_t n       = e.size();
+    const std::size_t tn      = std::size_t(1)<<k;
+
+    // Таблица g^0..g^(2^k-1), результат, выбранный элемент, g и рабочая область mont_mul_fixed
+    bigint_details::number_holder_t buf((tn+3u)*n + 2u*n+1u, chunk_type(0));
+    chunk_type *tbl = buf.data();
+    chunk_type *r   = tbl+tn*n;
+    chunk_type *sel = r+n;
+    chunk_type *g   = sel+n;
+    chunk_type *t   = g+n;
+
+    {
+        const BigInt gm = e.enter(base);
+        std::copy(gm.chunksData(), gm.chunksData()+gm.chunksSize(), g);
+
+        const BigInt &one = e.one();
+        std::copy(one.chunksData(), one.chunksData()+one.chunksSize(), tbl);
+
+        for(std::size_t i=1; i!=tn; ++i)
+            e.ctx.mulFixed(tbl+i*n, tbl+(i-1u)*n, g, t);
+    }
+
+    std::copy(tbl, tbl+n, r);
+
+    const std::size_t digits = (expBits+k-1u)/k;
+    for(std::size_t d=digits; d!=0; --d)
+    {
+        for(unsigned s=0; s!=k; ++s)
+            e.ctx.mulFixed(r, r, r, t);
+
+        const std::size_t b = (d-1u)*k;
+        const unsigned    v = powModBits(exp, b, b+k);
+
+        std::fill(sel, sel+n, chunk_type(0));
+        for(std::size_t i=0; i!=tn; ++i)
+        {
+            const chunk_type mask = chunk_type(chunk_type(0) - chunk_type(i==v));
+            for(std::size_t j=0; j!=n; ++j)
+                sel[j] = chunk_type(sel[j] | (tbl[i*n+j] & mask));
+        }
+
+        e.ctx.mulFixed(r, r, sel, t);
+    }
+
+    // r*1/R - выход из формы Монтгомери тем же ядром
+    std::fill(sel, sel+n, chunk_type(0));
+    sel[0] = 1;
+    e.ctx.mulFixed(r, r, sel, t);
+
+    return BigInt::fromChunks(1, r, n);
+}
+
+//----------------------------------------------------------------------------
+template<typename Engine>
+BigInt powModRun(const Engine &e, const BigInt &base, const BigInt &exp, const BigInt &mod, BigInt::PowModMethod pm)
+{
+    return pm==BigInt::PowModMethod::fixedWindow
+         ? powModFixed(e, base, exp, powModBitLength(mod))
+         : powModSliding(e, base, exp);
+}
+
+} // namespace bigint_details
+
+//----------------------------------------------------------------------------
+inline
+BigInt BigInt::powMod(const BigInt &base, const BigInt &exp, const BigInt &mod, PowModMethod pm)
+{
+    if (mod.sign()<=0)
+        throw std::invalid_argument("BigInt::powMod: modulus must be positive");
+
+    if (exp.sign()<0)
+        throw std::invalid_argument("BigInt::powMod: exponent must be non-negative");
+
+    if (mod==BigInt(1))
+        return BigInt(0);
+
+    if (exp.sign()==0 && pm!=PowModMethod::fixedWindow)
+        return BigInt(1);
+
+    if (mod.getLowChunk()&1u)
+    {
+        const MontgomeryContext ctx(mod);
+        return bigint_details::powModRun(bigint_details::powmod_montgomery{ctx}, base, exp, mod, pm);
+    }
+
+    const BarrettReducer br(mod);
+    return bigint_details::powModRun(bigint_details::powmod_barrett{br, BigInt(1)}, base, exp, mod, pm);
+}
+
+//----------------------------------------------------------------------------
+
+} // namespace marty
+
+
+#endif // MARTY_BIGINT_IMPL_POWMOD_H
@@ -0,0 +1,2650 @@
+/*!
+    \file
+    \brief Низкоуровневые операции над чанками (limbs) marty::BigInt
+ */
+#pragma once
+
+#include "types.h"
+
+//
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64))
+    #include <intrin.h>
+    #define MARTY_BIGINT_LIMBS_X86_64_INTRINSICS
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+    #include <x86intrin.h>
+    #include <cpuid.h>
+    #define MARTY_BIGINT_LIMBS_X86_64_INTRINSICS
+    // Определение возможностей процессора во время выполнения (details::cpuHasXxx) - общее
+    // для ядер на ассемблере, FFT и пачек BigIntBatch
+    #define MARTY_BIGINT_X86_64_CPU_FEATURES
+    #if defined(MARTY_BIGINT_USE_ASM) && MARTY_BIGINT_USE_ASM!=0
+        #define MARTY_BIGINT_LIMBS_X86_64_ASM
+    #endif
+#endif
+
+// Полная развёртка циклов с известным на этапе компиляции числом итераций
+#if defined(__clang__)
+    #define MARTY_BIGINT_LIMBS_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__) && (__GNUC__ >= 8)
+    #define MARTY_BIGINT_LIMBS_UNROLL _Pragma("GCC unroll 8")
+#else
+    #define MARTY_BIGINT_LIMBS_UNROLL
+#endif
+
+#if defined(__has_builtin)
+    #if __has_builtin(__builtin_addcll) && __has_builtin(__builtin_subcll)
+        #define MARTY_BIGINT_LIMBS_HAS_BUILTIN_ADDC
+    #endif
+#endif
+
+//
+#include "undef_min_max.h"
+
+
+// #include "marty_bigint/limbs.h"
+// marty::bigint_limbs::
+namespace marty {
+namespace bigint_limbs {
+
+
+//----------------------------------------------------------------------------
+// Все функции шаблонные по типу чанка - BigInt использует bigint_details::unsigned_t,
+// но тестировать и сравнивать удобно на разных размерах.
+
+template<typename T>
+constexpr int limbBits() { return int(sizeof(T)*CHAR_BIT); }
+
+template<typename T>
+constexpr bool hasDoubleLimb()
+{
+    return sizeof(T)<8 || bigint_details::detail::has_uint128;
+}
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace details {
+
+// Умножение 64x64->128 через половинки, для платформ без 128ми битного типа
+inline
+std::uint64_t mulWidePortable(std::uint64_t a, std::uint64_t b, std::uint64_t &hi)
+{
+    const std::uint64_t aLo = a & 0xFFFFFFFFu, aHi = a>>32;
+    const std::uint64_t bLo = b & 0xFFFFFFFFu, bHi = b>>32;
+
+    const std::uint64_t ll = aLo*bLo;
+    const std::uint64_t lh = aLo*bHi;
+    const std::uint64_t hl = aHi*bLo;
+    const std::uint64_t hh = aHi*bHi;
+
+    const std::uint64_t mid = (ll>>32) + (lh&0xFFFFFFFFu) + (hl&0xFFFFFFFFu);
+
+    hi = hh + (lh>>32) + (hl>>32) + (mid>>32);
+    return (mid<<32) | (ll&0xFFFFFFFFu);
+}
+
+// Деление 128/64 через половинки (Кнут, алгоритм D для двух цифр по 32 бита), требуется hi<d
+inline
+std::uint64_t divWidePortable(std::uint64_t hi, std::uint64_t lo, std::uint64_t d, std::uint64_t &r)
+{
+    const std::uint64_t b = std::uint64_t(1)<<32;
+
+    // Нормализуем делитель, чтобы старший бит был установлен
+    int s = 0;
+    while(!(d & (std::uint64_t(1)<<63)))
+    {
+        d <<= 1;
+        ++s;
+    }
+
+    if (s)
+    {
+        hi = (hi<<s) | (lo>>(64-s));
+        lo <<= s;
+    }
+
+    const std::uint64_t dHi = d>>32, dLo = d&0xFFFFFFFFu;
+    const std::uint64_t lo1 = lo>>32, lo0 = lo&0xFFFFFFFFu;
+
+    std::uint64_t q1 = hi/dHi;
+    std::uint64_t rHat = hi - q1*dHi;
+    while(q1>=b || q1*dLo>((rHat<<32)|lo1))
+    {
+        --q1;
+        rHat += dHi;
+        if (rHat>=b)
+            break;
+    }
+
+    const std::uint64_t u21 = (hi<<32) + lo1 - q1*d;
+
+    std::uint64_t q0 = u21/dHi;
+    rHat = u21 - q0*dHi;
+    while(q0>=b || q0*dLo>((rHat<<32)|lo0))
+    {
+        --q0;
+        rHat += dHi;
+        if (rHat>=b)
+            break;
+    }
+
+    r = ((u21<<32) + lo0 - q0*d) >> s;
+    return (q1<<32) | q0;
+}
+
+} // namespace details
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+//! Полное произведение двух чанков: возвращает младшую половину, старшую кладёт в hi
+template<typename T>
+inline
+T mulWide(T a, T b, T &hi)
+{
+    static_assert(std::is_unsigned_v<T>, "bigint_limbs::mulWide: T must be unsigned");
+
+    if constexpr (hasDoubleLimb<T>())
+    {
+        using T2 = bigint_details::detail::double_size_t<T>;
+        const T2 r = T2(T2(a)*T2(b));
+        hi = T(r>>limbBits<T>());
+        return T(r);
+    }
+    else
+    {
+        #if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64))
+            unsigned __int64 h = 0;
+            const unsigned __int64 l = _umul128(a, b, &h);
+            hi = T(h);
+            return T(l);
+        #else
+            std::uint64_t h = 0;
+            const std::uint64_t l = details::mulWidePortable(a, b, h);
+            hi = T(h);
+            return T(l);
+        #endif
+    }
+}
+
+//----------------------------------------------------------------------------
+//! Деление двойного чанка (hi:lo) на чанк d, требуется hi<d, чтобы частное влезло в чанк
+template<typename T>
+inline
+T divWide(T hi, T lo, T d, T &r)
+{
+    static_assert(std::is_unsigned_v<T>, "bigint_limbs::divWide: T must be unsigned");
+
+    if constexpr (hasDoubleLimb<T>())
+    {
+        using T2 = bigint_details::detail::double_size_t<T>;
+        const T2 n = T2(T2(T2(hi)<<limbBits<T>()) | T2(lo));
+        r = T(n%d);
+        return T(n/d);
+    }
+    else
+    {
+        #if defined(_MSC_VER) && _MSC_VER>=1920 && (defined(_M_X64) || defined(_M_AMD64))
+            unsigned __int64 rr = 0;
+            const unsigned __int64 q = _udiv128(hi, lo, d, &rr);
+            r = T(rr);
+            return T(q);
+        #else
+            std::uint64_t rr = 0;
+            const std::uint64_t q = details::divWidePortable(hi, lo, d, rr);
+            r = T(rr);
+            return T(q);
+        #endif
+    }
+}
+
+//----------------------------------------------------------------------------
+//! Сложение с переносом, carry - входной и выходной перенос (0 или 1)
+template<typename T>
+inline
+T addCarry(T a, T b, T &carry)
+{
+    // Через интринсики компилятор держит перенос во флаге CF и строит цепочку adc,
+    // а не вычисляет его сравнениями
+#if defined(MARTY_BIGINT_LIMBS_X86_64_INTRINSICS)
+    if constexpr (sizeof(T)==8)
+    {
+        unsigned long long r = 0;
+        carry = T(_addcarry_u64((unsigned char)carry, a, b, &r));
+        return T(r);
+    }
+    else if constexpr (sizeof(T)==4)
+    {
+        unsigned int r = 0;
+        carry = T(_addcarry_u32((unsigned char)carry, a, b, &r));
+        return T(r);
+    }
+    else
+#elif defined(MARTY_BIGINT_LIMBS_HAS_BUILTIN_ADDC)
+    if constexpr (sizeof(T)==sizeof(unsigned long long))
+    {
+        unsigned long long c = 0;
+        const unsigned long long r = __builtin_addcll(a, b, carry, &c);
+        carry = T(c);
+        return T(r);
+    }
+    else
+#endif
+    {
+        const T s  = T(a+b);
+        const T c1 = T(s<a);
+        const T r  = T(s+carry);
+        carry      = T(c1 | T(r<s));
+        return r;
+    }
+}
+
+//----------------------------------------------------------------------------
+//! Вычитание с заёмом, borrow - входной и выходной заём (0 или 1)
+template<typename T>
+inline
+T subBorrow(T a, T b, T &borrow)
+{
+#if defined(MARTY_BIGINT_LIMBS_X86_64_INTRINSICS)
+    if constexpr (sizeof(T)==8)
+    {
+        unsigned long long r = 0;
+        borrow = T(_subborrow_u64((unsigned char)borrow, a, b, &r));
+        return T(r);
+    }
+    else if constexpr (sizeof(T)==4)
+    {
+        unsigned int r = 0;
+        borrow = T(_subborrow_u32((unsigned char)borrow, a, b, &r));
+        return T(r);
+    }
+    else
+#elif defined(MARTY_BIGINT_LIMBS_HAS_BUILTIN_ADDC)
+    if constexpr (sizeof(T)==sizeof(unsigned long long))
+    {
+        unsigned long long c = 0;
+        const unsigned long long r = __builtin_subcll(a, b, borrow, &c);
+        borrow = T(c);
+        return T(r);
+    }
+    else
+#endif
+    {
+        const T d  = T(a-b);
+        const T b1 = T(a<b);
+        const T r  = T(d-borrow);
+        borrow     = T(b1 | T(d<borrow));
+        return r;
+    }
+}
+
+//----------------------------------------------------------------------------
+//! Количество ведущих нулевых бит, для нуля - размер чанка в битах
+template<typename T>
+inline
+int countLeadingZeros(T v)
+{
+    if (!v)
+        return limbBits<T>();
+
+    int n = 0;
+    for(int step=limbBits<T>()/2; step>0; step/=2)
+    {
+        const T hiPart = T(v>>(limbBits<T>()-step));
+        if (!hiPart)
+        {
+            n += step;
+            v  = T(v<<step);
+        }
+    }
+
+    return n;
+}
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace details {
+
+#if defined(MARTY_BIGINT_X86_64_CPU_FEATURES)
+
+// EBX листа 7 cpuid (расширенные возможности), 0 - если листа нет
+inline
+unsigned cpuidLeaf7Ebx()
+{
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        return 0u;
+    return ebx;
+}
+
+// Какие регистры ОС сохраняет при переключении задач (XCR0), 0 - если xgetbv нет (OSXSAVE)
+inline
+unsigned cpuXcr0()
+{
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || (ecx & (1u<<27))==0) // OSXSAVE
+        return 0u;
+
+    unsigned xcr0Lo = 0, xcr0Hi = 0;
+    __asm__ ("xgetbv" : "=a"(xcr0Lo), "=d"(xcr0Hi) : "c"(0u));
+    return xcr0Lo;
+}
+
+// Процессор умеет mulx (BMI2) и adcx/adox (ADX)? Проверяем один раз
+inline
+bool cpuHasAdxBmi2()
+{
+    static const bool res = (cpuidLeaf7Ebx() & ((1u<<8) | (1u<<19)))==((1u<<8) | (1u<<19)); // BMI2 && ADX
+    return res;
+}
+
+// AVX2 и его поддержка ОС (сохранение xmm и ymm)? Проверяем один раз
+inline
+bool cpuHasAvx2()
+{
+    static const bool res = (cpuXcr0() & 6u)==6u && (cpuidLeaf7Ebx() & (1u<<5))!=0;
+    return res;
+}
+
+// AVX-512F и его поддержка ОС (ещё opmask и zmm)? Проверяем один раз
+inline
+bool cpuHasAvx512f()
+{
+    static const bool res = (cpuXcr0() & 0xE6u)==0xE6u && (cpuidLeaf7Ebx() & (1u<<16))!=0;
+    return res;
+}
+
+#endif
+
+#if defined(MARTY_BIGINT_LIMBS_X86_64_ASM)
+
+// Цепочка adc по четыре чанка за итерацию. lea и jrcxz не трогают флаги,
+// поэтому перенос живёт в CF через весь цикл
+template<typename T>
+inline
+T add_n_asm(T *r, const T *a, const T *b, std::size_t n)
+{
+    static_assert(sizeof(T)==8, "bigint_limbs::details::add_n_asm: 64-bit limbs only");
+
+    std::size_t blocks = n/4u;
+    std::size_t rest   = n%4u;
+    T c = 0, t0, t1, t2, t3;
+
+    __asm__ volatile(
+        "xor %%ecx, %%ecx\n\t"            // CF=0
+        "mov %[blocks], %%rcx\n\t"
+        "jrcxz 2f\n\t"
+        "1:\n\t"
+        "mov   (%[a]), %[t0]\n\t"
+        "mov  8(%[a]), %[t1]\n\t"
+        "mov 16(%[a]), %[t2]\n\t"
+        "mov 24(%[a]), %[t3]\n\t"
+        "adc   (%[b]), %[t0]\n\t"
+        "adc  8(%[b]), %[t1]\n\t"
+        "adc 16(%[b]), %[t2]\n\t"
+        "adc 24(%[b]), %[t3]\n\t"
+        "mov %[t0],   (%[r])\n\t"
+        "mov %[t1],  8(%[r])\n\t"
+        "mov %[t2], 16(%[r])\n\t"
+        "mov %[t3], 24(%[r])\n\t"
+        "lea 32(%[a]), %[a]\n\t"
+        "lea 32(%[b]), %[b]\n\t"
+        "lea 32(%[r]), %[r]\n\t"
+        "lea -1(%%rcx), %%rcx\n\t"
+        "jrcxz 2f\n\t"
+        "jmp 1b\n\t"
+        "2:\n\t"
+        "mov %[rest], %%rcx\n\t"
+        "jrcxz 4f\n\t"
+        "3:\n\t"
+        "mov (%[a]), %[t0]\n\t"
+        "adc (%[b]), %[t0]\n\t"
+        "mov %[t0], (%[r])\n\t"
+        "lea 8(%[a]), %[a]\n\t"
+        "lea 8(%[b]), %[b]\n\t"
+        "lea 8(%[r]), %[r]\n\t"
+        "lea -1(%%rcx), %%rcx\n\t"
+        "jrcxz 4f\n\t"
+        "jmp 3b\n\t"
+        "4:\n\t"
+        "adc $0, %[c]\n\t"
+        : [a]"+&r"(a), [b]"+&r"(b), [r]"+&r"(r), [c]"+&r"(c)
+        , [blocks]"+&r"(blocks), [rest]"+&r"(rest) // не просто входы - иначе могут попасть в один регистр с выходами
+        , [t0]"=&r"(t0), [t1]"=&r"(t1), [t2]"=&r"(t2), [t3]"=&r"(t3)
+        :
+        : "rcx", "cc", "memory"
+    );
+
+    return c;
+}
+
+// То же самое для вычитания - цепочка sbb
+template<typename T>
+inline
+T sub_n_asm(T *r, const T *a, const T *b, std::size_t n)
+{
+    static_assert(sizeof(T)==8, "bigint_limbs::details::sub_n_asm: 64-bit limbs only");
+
+    std::size_t blocks = n/4u;
+    std::size_t rest   = n%4u;
+    T c = 0, t0, t1, t2, t3;
+
+    __asm__ volatile(
+        "xor %%ecx, %%ecx\n\t"            // CF=0
+        "mov %[blocks], %%rcx\n\t"
+        "jrcxz 2f\n\t"
+        "1:\n\t"
+        "mov   (%[a]), %[t0]\n\t"
+        "mov  8(%[a]), %[t1]\n\t"
+        "mov 16(%[a]), %[t2]\n\t"
+        "mov 24(%[a]), %[t3]\n\t"
+        "sbb   (%[b]), %[t0]\n\t"
+        "sbb  8(%[b]), %[t1]\n\t"
+        "sbb 16(%[b]), %[t2]\n\t"
+        "sbb 24(%[b]), %[t3]\n\t"
+        "mov %[t0],   (%[r])\n\t"
+        "mov %[t1],  8(%[r])\n\t"
+        "mov %[t2], 16(%[r])\n\t"
+        "mov %[t3], 24(%[r])\n\t"
+        "lea 32(%[a]), %[a]\n\t"
+        "lea 32(%[b]), %[b]\n\t"
+        "lea 32(%[r]), %[r]\n\t"
+        "lea -1(%%rcx), %%rcx\n\t"
+        "jrcxz 2f\n\t"
+        "jmp 1b\n\t"
+        "2:\n\t"
+        "mov %[rest], %%rcx\n\t"
+        "jrcxz 4f\n\t"
+        "3:\n\t"
+        "mov (%[a]), %[t0]\n\t"
+        "sbb (%[b]), %[t0]\n\t"
+        "mov %[t0], (%[r])\n\t"
+        "lea 8(%[a]), %[a]\n\t"
+        "lea 8(%[b]), %[b]\n\t"
+        "lea 8(%[r]), %[r]\n\t"
+        "lea -1(%%rcx), %%rcx\n\t"
+        "jrcxz 4f\n\t"
+        "jmp 3b\n\t"
+        "4:\n\t"
+        "adc $0, %[c]\n\t"
+        : [a]"+&r"(a), [b]"+&r"(b), [r]"+&r"(r), [c]"+&r"(c)
+        , [blocks]"+&r"(blocks), [rest]"+&r"(rest) // не просто входы - иначе могут попасть в один регистр с выходами
+        , [t0]"=&r"(t0), [t1]"=&r"(t1), [t2]"=&r"(t2), [t3]"=&r"(t3)
+        :
+        : "rcx", "cc", "memory"
+    );
+
+    return c;
+}
+
+// r += a*v через mulx (не трогает флаги) и две независимые цепочки переносов:
+// adox - старшие половины предыдущих произведений, adcx - чанки r.
+// Вызывать только если cpuHasAdxBmi2()
+template<typename T>
+inline
+T addmul_1_adx(T *r, const T *a, std::size_t n, T v)
+{
+    static_assert(sizeof(T)==8, "bigint_limbs::details::addmul_1_adx: 64-bit limbs only");
+
+    std::size_t blocks = n/4u;
+    std::size_t rest   = n%4u;
+    T prev = 0, lo, hi;
+
+    __asm__ volatile(
+        "xor %%ecx, %%ecx\n\t"            // CF=0, OF=0
+        "mov %[blocks], %%rcx\n\t"
+        "jrcxz 2f\n\t"
+        "1:\n\t"
+        "mulx   (%[a]), %[lo], %[hi]\n\t"
+        "adox %[prev], %[lo]\n\t"
+        "adcx   (%[r]), %[lo]\n\t"
+        "mov %[lo],   (%[r])\n\t"
+        "mulx  8(%[a]), %[lo], %[prev]\n\t"
+        "adox %[hi], %[lo]\n\t"
+        "adcx  8(%[r]), %[lo]\n\t"
+        "mov %[lo],  8(%[r])\n\t"
+        "mulx 16(%[a]), %[lo], %[hi]\n\t"
+        "adox %[prev], %[lo]\n\t"
+        "adcx 16(%[r]), %[lo]\n\t"
+        "mov %[lo], 16(%[r])\n\t"
+        "mulx 24(%[a]), %[lo], %[prev]\n\t"
+        "adox %[hi], %[lo]\n\t"
+        "adcx 24(%[r]), %[lo]\n\t"
+        "mov %[lo], 24(%[r])\n\t"
+        "lea 32(%[a]), %[a]\n\t"
+        "lea 32(%[r]), %[r]\n\t"
+        "lea -1(%%rcx), %%rcx\n\t"
+        "jrcxz 2f\n\t"
+        "jmp 1b\n\t"
+        "2:\n\t"
+        "mov %[rest], %%rcx\n\t"
+        "jrcxz 4f\n\t"
+        "3:\n\t"
+        "mulx (%[a]), %[lo], %[hi]\n\t"
+        "adox %[prev], %[lo]\n\t"
+        "adcx (%[r]), %[lo]\n\t"
+        "mov %[lo], (%[r])\n\t"
+        "mov %[hi], %[prev]\n\t"
+        "lea 8(%[a]), %[a]\n\t"
+        "lea 8(%[r]), %[r]\n\t"
+        "lea -1(%%rcx), %%rcx\n\t"
+        "jrcxz 4f\n\t"
+        "jmp 3b\n\t"
+        "4:\n\t"
+        "mov $0, %%ecx\n\t"              // mov не трогает флаги
+        "adox %%rcx, %[prev]\n\t"
+        "adcx %%rcx, %[prev]\n\t"
+        : [a]"+&r"(a), [r]"+&r"(r), [prev]"+&r"(prev), [lo]"=&r"(lo), [hi]"=&r"(hi)
+        , [blocks]"+&r"(blocks), [rest]"+&r"(rest) // не просто входы - иначе могут попасть в один регистр с выходами
+        : "d"(v)
+        : "rcx", "cc", "memory"
+    );
+
+    return prev;
+}
+
+// r -= a*v так же через mulx и две цепочки: adox собирает чанки t = a*v, а вычитание -
+// сложение r + ~t + 1 в цепочке adcx (sub/sbb нельзя - они портят OF). CF=1 в конце -
+// заёма нет. Вызывать только если cpuHasAdxBmi2()
+template<typename T>
+inline
+T submul_1_adx(T *r, const T *a, std::size_t n, T v)
+{
+    static_assert(sizeof(T)==8, "bigint_limbs::details::submul_1_adx: 64-bit limbs only");
+
+    std::size_t blocks = n/4u;
+    std::size_t rest   = n%4u;
+    T prev = 0, lo, hi;
+
+    __asm__ volatile(
+        "xor %%ecx, %%ecx\n\t"            // CF=0, OF=0
+        "stc\n\t"                         // +1 дополнительного кода
+        "mov %[blocks], %%rcx\n\t"
+        "jrcxz 2f\n\t"
+        "1:\n\t"
+        "mulx   (%[a]), %[lo], %[hi]\n\t"
+        "adox %[prev], %[lo]\n\t"
+        "not %[lo]\n\t"
+        "adcx   (%[r]), %[lo]\n\t"
+        "mov %[lo],   (%[r])\n\t"
+        "mulx  8(%[a]), %[lo], %[prev]\n\t"
+        "adox %[hi], %[lo]\n\t"
+        "not %[lo]\n\t"
+        "adcx  8(%[r]), %[lo]\n\t"
+        "mov %[lo],  8(%[r])\n\t"
+        "mulx 16(%[a]), %[lo], %[hi]\n\t"
+        "adox %[prev], %[lo]\n\t"
+        "not %[lo]\n\t"
+        "adcx 16(%[r]), %[lo]\n\t"
+        "mov %[lo], 16(%[r])\n\t"
+        "mulx 24(%[a]), %[lo], %[prev]\n\t"
+        "adox %[hi], %[lo]\n\t"
+        "not %[lo]\n\t"
+        "adcx 24(%[r]), %[lo]\n\t"
+        "mov %[lo], 24(%[r])\n\t"
+        "lea 32(%[a]), %[a]\n\t"
+        "lea 32(%[r]), %[r]\n\t"
+        "lea -1(%%rcx), %%rcx\n\t"
+        "jrcxz 2f\n\t"
+        "jmp 1b\n\t"
+        "2:\n\t"
+        "mov %[rest], %%rcx\n\t"
+        "jrcxz 4f\n\t"
+        "3:\n\t"
+        "mulx (%[a]), %[lo], %[hi]\n\t"
+        "adox %[prev], %[lo]\n\t"
+        "not %[lo]\n\t"
+        "adcx (%[r]), %[lo]\n\t"
+        "mov %[lo], (%[r])\n\t"
+        "mov %[hi], %[prev]\n\t"
+        "lea 8(%[a]), %[a]\n\t"
+        "lea 8(%[r]), %[r]\n\t"
+        "lea -1(%%rcx), %%rcx\n\t"
+        "jrcxz 4f\n\t"
+        "jmp 3b\n\t"
+        "4:\n\t"
+        "mov $0, %%ecx\n\t"              // mov не трогает флаги
+        "adox %%rcx, %[prev]\n\t"
+        "cmc\n\t"                         // заём - это CF==0
+        "adcx %%rcx, %[prev]\n\t"
+        : [a]"+&r"(a), [r]"+&r"(r), [prev]"+&r"(prev), [lo]"=&r"(lo), [hi]"=&r"(hi)
+        , [blocks]"+&r"(blocks), [rest]"+&r"(rest) // не просто входы - иначе могут попасть в один регистр с выходами
+        : "d"(v)
+        : "rcx", "cc", "memory"
+    );
+
+    return prev;
+}
+
+#endif
+
+} // namespace details
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// Операции над массивами чанков (в стиле mpn_* из GMP).
+// Числа задаются указателем и длиной, младшие чанки - первые. Память не выделяется,
+// результат пишется в r, который должен вмещать указанное количество чанков.
+// r может совпадать с a (и b) - операции "на месте".
+//----------------------------------------------------------------------------
+
+//! Длина без ведущих нулевых чанков
+template<typename T>
+inline
+std::size_t normalizedSize(const T *a, std::size_t n)
+{
+    while(n && !a[n-1])
+        --n;
+    return n;
+}
+
+//----------------------------------------------------------------------------
+//! r = a + b, все по n чанков. Возвращает перенос (0 или 1)
+template<typename T>
+inline
+T add_n(T *r, const T *a, const T *b, std::size_t n)
+{
+#if defined(MARTY_BIGINT_LIMBS_X86_64_ASM)
+    if constexpr (sizeof(T)==8)
+    {
+        return details::add_n_asm(r, a, b, n);
+    }
+    else
+#endif
+    {
+        T carry = 0;
+        std::size_t i = 0;
+        for(; i+4u<=n; i+=4u)
+        {
+            r[i  ] = addCarry(a[i  ], b[i  ], carry);
+            r[i+1] = addCarry(a[i+1], b[i+1], carry);
+            r[i+2] = addCarry(a[i+2], b[i+2], carry);
+            r[i+3] = addCarry(a[i+3], b[i+3], carry);
+        }
+        for(; i!=n; ++i)
+            r[i] = addCarry(a[i], b[i], carry);
+        return carry;
+    }
+}
+
+//----------------------------------------------------------------------------
+//! r = a + v, a и r - по n чанков. Возвращает перенос (0 или 1)
+template<typename T>
+inline
+T add_1(T *r, const T *a, std::size_t n, T v)
+{
+    std::size_t i = 0;
+    for(; i!=n && v; ++i)
+    {
+        const T s = T(a[i]+v);
+        v    = T(s<v);
+        r[i] = s;
+    }
+
+    if (r!=a)
+    {
+        for(; i!=n; ++i)
+            r[i] = a[i];
+    }
+
+    return v;
+}
+
+//----------------------------------------------------------------------------
+//! r = a + b, an>=bn, r - an чанков. Возвращает перенос (0 или 1)
+template<typename T>
+inline
+T add(T *r, const T *a, std::size_t an, const T *b, std::size_t bn)
+{
+    const T carry = add_n(r, a, b, bn);
+    return add_1(r+bn, a+bn, an-bn, carry);
+}
+
+//----------------------------------------------------------------------------
+//! r = a - b, все по n чанков. Возвращает заём (0 или 1)
+template<typename T>
+inline
+T sub_n(T *r, const T *a, const T *b, std::size_t n)
+{
+#if defined(MARTY_BIGINT_LIMBS_X86_64_ASM)
+    if constexpr (sizeof(T)==8)
+    {
+        return details::sub_n_asm(r, a, b, n);
+    }
+    else
+#endif
+    {
+        T borrow = 0;
+        std::size_t i = 0;
+        for(; i+4u<=n; i+=4u)
+        {
+            r[i  ] = subBorrow(a[i  ], b[i  ], borrow);
+            r[i+1] = subBorrow(a[i+1], b[i+1], borrow);
+            r[i+2] = subBorrow(a[i+2], b[i+2], borrow);
+            r[i+3] = subBorrow(a[i+3], b[i+3], borrow);
+        }
+        for(; i!=n; ++i)
+            r[i] = subBorrow(a[i], b[i], borrow);
+        return borrow;
+    }
+}
+
+//----------------------------------------------------------------------------
+//! r = a - v, a и r - по n чанков. Возвращает заём (0 или 1)
+template<typename T>
+inline
+T sub_1(T *r, const T *a, std::size_t n, T v)
+{
+    std::size_t i = 0;
+    for(; i!=n && v; ++i)
+    {
+        const T x = a[i];
+        r[i] = T(x-v);
+        v    = T(x<v);
+    }
+
+    if (r!=a)
+    {
+        for(; i!=n; ++i)
+            r[i] = a[i];
+    }
+
+    return v;
+}
+
+//----------------------------------------------------------------------------
+//! r = a - b, an>=bn, r - an чанков. Возвращает заём (0 или 1)
+template<typename T>
+inline
+T sub(T *r, const T *a, std::size_t an, const T *b, std::size_t bn)
+{
+    const T borrow = sub_n(r, a, b, bn);
+    return sub_1(r+bn, a+bn, an-bn, borrow);
+}
+
+//----------------------------------------------------------------------------
+//! r = a * v, a и r - по n чанков. Возвращает старший чанк произведения
+template<typename T>
+inline
+T mul_1(T *r, const T *a, std::size_t n, T v)
+{
+    T carry = 0;
+    for(std::size_t i=0; i!=n; ++i)
+    {
+        T hi = 0;
+        T lo = mulWide(a[i], v, hi);
+        lo    = T(lo+carry);
+        carry = T(hi + T(lo<carry)); // hi не больше B-2, переполнения нет
+        r[i]  = lo;
+    }
+    return carry;
+}
+
+//----------------------------------------------------------------------------
+//! r += a * v, a и r - по n чанков. Возвращает чанк переноса
+template<typename T>
+inline
+T addmul_1(T *r, const T *a, std::size_t n, T v)
+{
+#if defined(MARTY_BIGINT_LIMBS_X86_64_ASM)
+    if constexpr (sizeof(T)==8)
+    {
+        if (details::cpuHasAdxBmi2())
+            return details::addmul_1_adx(r, a, n, v);
+    }
+#endif
+
+    T carry = 0;
+    for(std::size_t i=0; i!=n; ++i)
+    {
+        T hi = 0;
+        T lo = mulWide(a[i], v, hi);
+        lo   = T(lo+carry);
+        hi   = T(hi + T(lo<carry));
+        const T x = T(r[i]+lo);
+        hi   = T(hi + T(x<lo));
+        r[i] = x;
+        carry = hi;
+    }
+    return carry;
+}
+
+//----------------------------------------------------------------------------
+//! r -= a * v, a и r - по n чанков. Возвращает чанк заёма
+template<typename T>
+inline
+T submul_1(T *r, const T *a, std::size_t n, T v)
+{
+#if defined(MARTY_BIGINT_LIMBS_X86_64_ASM)
+    if constexpr (sizeof(T)==8)
+    {
+        if (details::cpuHasAdxBmi2())
+            return details::submul_1_adx(r, a, n, v);
+    }
+#endif
+
+    if constexpr (hasDoubleLimb<T>())
+    {
+        // Произведение с заёмом - в двойном чанке: (B-1)^2 + (B-1) < B^2
+        using T2 = bigint_details::detail::double_size_t<T>;
+
+        T2 borrow = 0;
+        for(std::size_t i=0; i!=n; ++i)
+        {
+            const T2 p  = T2(T2(a[i])*v + borrow);
+            const T  lo = T(p);
+            const T  x  = r[i];
+            r[i]   = T(x-lo);
+            borrow = T2((p>>limbBits<T>()) + T2(x<lo));
+        }
+        return T(borrow);
+    }
+
+    T borrow = 0;
+    for(std::size_t i=0; i!=n; ++i)
+    {
+        T hi = 0;
+        T lo = mulWide(a[i], v, hi);
+        lo   = T(lo+borrow);
+        hi   = T(hi + T(lo<borrow));
+        const T x = r[i];
+        hi   = T(hi + T(x<lo));
+        r[i] = T(x-lo);
+        borrow = hi;
+    }
+    return borrow;
+}
+
+//----------------------------------------------------------------------------
+namespace details {
+
+// Один шаг умножения с накоплением: возвращает младший чанк a*b+add+carry, старший кладёт в carry.
+// (B-1)*(B-1) + 2*(B-1) = B*B-1, так что всё влезает в два чанка
+template<typename T>
+inline
+T mulAddStep(T a, T b, T add, T &carry)
+{
+    if constexpr (hasDoubleLimb<T>())
+    {
+        using T2 = bigint_details::detail::double_size_t<T>;
+        const T2 t = T2(T2(T2(a)*T2(b)) + T2(add) + T2(carry));
+        carry = T(t>>limbBits<T>());
+        return T(t);
+    }
+
+    T hi = 0;
+    T lo = mulWide(a, b, hi);
+    lo    = T(lo+add);
+    hi    = T(hi + T(lo<add));
+    lo    = T(lo+carry);
+    carry = T(hi + T(lo<carry));
+    return lo;
+}
+
+// Умножение фиксированных размеров - циклы с constexpr границами компилятор разворачивает полностью,
+// перенос живёт в регистре
+template<std::size_t AN, std::size_t BN, typename T>
+inline
+void mul_fixed(T *r, const T *a, const T *b)
+{
+    T carry = 0;
+    MARTY_BIGINT_LIMBS_UNROLL
+    for(std::size_t i=0; i!=AN; ++i)
+        r[i] = mulAddStep(a[i], b[0], T(0), carry);
+    r[AN] = carry;
+
+    MARTY_BIGINT_LIMBS_UNROLL
+    for(std::size_t j=1; j!=BN; ++j)
+    {
+        carry = 0;
+        MARTY_BIGINT_LIMBS_UNROLL
+        for(std::size_t i=0; i!=AN; ++i)
+            r[i+j] = mulAddStep(a[i], b[j], r[i+j], carry);
+        r[AN+j] = carry;
+    }
+}
+
+// Максимальный размер множителей, для которого есть развёрнутые варианты
+constexpr const std::size_t mulFixedMaxSize = 8;
+
+template<typename T>
+using mul_fixed_fn_t = void (*)(T*, const T*, const T*);
+
+template<typename T, std::size_t... I>
+constexpr auto makeMulFixedTable(std::index_sequence<I...>)
+{
+    // Индекс = (AN-1)*mulFixedMaxSize + (BN-1)
+    return std::array<mul_fixed_fn_t<T>, sizeof...(I)>{ &mul_fixed<I/mulFixedMaxSize+1u, I%mulFixedMaxSize+1u, T>... };
+}
+
+template<typename T>
+inline
+mul_fixed_fn_t<T> getMulFixed(std::size_t an, std::size_t bn)
+{
+    static constexpr const auto table = makeMulFixedTable<T>(std::make_index_sequence<mulFixedMaxSize*mulFixedMaxSize>{});
+    return table[(an-1u)*mulFixedMaxSize + (bn-1u)];
+}
+
+} // namespace details
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//! r = a << cnt, 0<=cnt<limbBits. Возвращает выдвинутые биты (в младших разрядах).
+//! Идём от старших чанков, поэтому r может совпадать с a или быть выше по адресу
+template<typename T>
+inline
+T lshift(T *r, const T *a, std::size_t n, int cnt)
+{
+    if (!n)
+        return 0;
+
+    if (!cnt)
+    {
+        for(std::size_t i=n; i-->0;)
+            r[i] = a[i];
+        return 0;
+    }
+
+    const int tnc = limbBits<T>()-cnt;
+    const T   out = T(a[n-1]>>tnc);
+
+    for(std::size_t i=n-1; i>0; --i)
+        r[i] = T(T(a[i]<<cnt) | T(a[i-1]>>tnc));
+
+    r[0] = T(a[0]<<cnt);
+    return out;
+}
+
+//----------------------------------------------------------------------------
+//! r = a >> cnt, 0<=cnt<limbBits. Возвращает выдвинутые биты (в старших разрядах).
+//! Идём от младших чанков, поэтому r может совпадать с a или быть ниже по адресу
+template<typename T>
+inline
+T rshift(T *r, const T *a, std::size_t n, int cnt)
+{
+    if (!n)
+        return 0;
+
+    if (!cnt)
+    {
+        for(std::size_t i=0; i!=n; ++i)
+            r[i] = a[i];
+        return 0;
+    }
+
+    const int tnc = limbBits<T>()-cnt;
+    const T   out = T(a[0]<<tnc);
+
+    for(std::size_t i=0; i!=n-1; ++i)
+        r[i] = T(T(a[i]>>cnt) | T(a[i+1]<<tnc));
+
+    r[n-1] = T(a[n-1]>>cnt);
+    return out;
+}
+
+//----------------------------------------------------------------------------
+//! Есть ли быстрый (ADX/BMI2) addmul_1 для чанков типа T. Тогда умножение по строкам
+//! (mul_basecase) быстрее, чем по столбцам (mul_comba), на любых размерах
+template<typename T>
+inline
+bool hasFastAddmul()
+{
+#if defined(MARTY_BIGINT_LIMBS_X86_64_ASM)
+    if constexpr (sizeof(T)==8)
+        return details::cpuHasAdxBmi2();
+#endif
+    return false;
+}
+
+//----------------------------------------------------------------------------
+//! r = a * b, an>=bn>=1, r - an+bn чанков и не должен пересекаться с a и b.
+//! Умножение "столбиком" по строкам: на каждый чанк b - один проход addmul_1 по a.
+//! Маленькие размеры (до 8x8 чанков) - развёрнутые варианты
+template<typename T>
+inline
+void mul_basecase(T *r, const T *a, std::size_t an, const T *b, std::size_t bn)
+{
+    if (an<=details::mulFixedMaxSize)
+    {
+        details::getMulFixed<T>(an, bn)(r, a, b);
+        return;
+    }
+
+    r[an] = mul_1(r, a, an, b[0]);
+    for(std::size_t j=1; j!=bn; ++j)
+        r[an+j] = addmul_1(r+j, a, an, b[j]);
+}
+
+//----------------------------------------------------------------------------
+//! r += a * b "столбиком" прямо в r, без временного произведения. r - rn чанков, rn>=an+bn,
+//! a и b не пересекаются с r. Возвращает перенос из старшего чанка r (0 или 1).
+//! Для коротких b (в том числе один чанк - это просто addmul_1) - накопление сумм произведений
+template<typename T>
+inline
+T addmul_basecase(T *r, std::size_t rn, const T *a, std::size_t an, const T *b, std::size_t bn)
+{
+    T carry = 0;
+    for(std::size_t j=0; j!=bn; ++j)
+    {
+        const T c = addmul_1(r+j, a, an, b[j]);
+        carry = T(carry + add_1(r+j+an, r+j+an, rn-j-an, c));
+    }
+    return carry;
+}
+
+//----------------------------------------------------------------------------
+//! r -= a * b, как addmul_basecase. Возвращает заём из старшего чанка r (0 или 1): если 1 -
+//! результат отрицательный и лежит в r в дополнительном коде (модуль - через neg)
+template<typename T>
+inline
+T submul_basecase(T *r, std::size_t rn, const T *a, std::size_t an, const T *b, std::size_t bn)
+{
+    T borrow = 0;
+    for(std::size_t j=0; j!=bn; ++j)
+    {
+        const T c = submul_1(r+j, a, an, b[j]);
+        borrow = T(borrow + sub_1(r+j+an, r+j+an, rn-j-an, c));
+    }
+    return borrow;
+}
+
+//----------------------------------------------------------------------------
+//! r = -r по модулю B^n (дополнительный код), на месте
+template<typename T>
+inline
+void neg(T *r, std::size_t n)
+{
+    std::size_t i = 0;
+    while(i!=n && !r[i])
+        ++i;
+    if (i==n)
+        return;
+
+    r[i] = T(T(0u)-r[i]);
+    for(++i; i!=n; ++i)
+        r[i] = T(~r[i]);
+}
+
+//----------------------------------------------------------------------------
+//! r = a * b, an>=1, bn>=1, r - an+bn чанков и не должен пересекаться с a и b.
+//! Умножение по столбцам (Comba, product scanning): для каждого чанка результата
+//! суммируем все произведения a[i]*b[k-i] в аккумуляторе из трёх чанков (c0, c1, c2),
+//! выдаём c0 в результат и сдвигаем аккумулятор. Каждый чанк результата пишется один раз.
+template<typename T>
+inline
+void mul_comba(T *r, const T *a, std::size_t an, const T *b, std::size_t bn)
+{
+    const std::size_t nCols = an+bn-1u;
+
+    if constexpr (sizeof(T)<=2)
+    {
+        // Для 8-16ти битных чанков трёх чанков на столбец мало - сумма может переполниться
+        // уже на 256 (65536) слагаемых. Зато влезает в 64 бита при любом разумном размере
+        std::uint64_t acc = 0;
+        for(std::size_t k=0; k!=nCols; ++k)
+        {
+            const std::size_t iBegin = k<bn ? 0u : k-bn+1u;
+            const std::size_t iEnd   = k<an ? k+1u : an;
+            for(std::size_t i=iBegin; i!=iEnd; ++i)
+                acc += std::uint64_t(a[i])*std::uint64_t(b[k-i]);
+
+            r[k] = T(acc);
+            acc >>= limbBits<T>();
+        }
+        r[nCols] = T(acc);
+    }
+    else
+    {
+        // Для 32х и 64х битных чанков переполнение c2 возможно только на 2^32 слагаемых и более
+        if constexpr (hasDoubleLimb<T>())
+        {
+            // (c1:c0) держим одним двойным чанком - компилятор делает mul/add/adc/adc
+            using T2 = bigint_details::detail::double_size_t<T>;
+            T2 c01 = 0;
+            T  c2  = 0;
+            for(std::size_t k=0; k!=nCols; ++k)
+            {
+                const std::size_t iBegin = k<bn ? 0u : k-bn+1u;
+                const std::size_t iEnd   = k<an ? k+1u : an;
+                for(std::size_t i=iBegin; i!=iEnd; ++i)
+                {
+                    const T2 p = T2(T2(a[i])*T2(b[k-i]));
+                    c01 = T2(c01+p);
+                    c2  = T(c2 + T(c01<p));
+                }
+
+                r[k] = T(c01);
+                c01  = T2(T2(c01>>limbBits<T>()) | T2(T2(c2)<<limbBits<T>()));
+                c2   = 0;
+            }
+            r[nCols] = T(c01);
+        }
+        else
+        {
+            T c0 = 0, c1 = 0, c2 = 0;
+            for(std::size_t k=0; k!=nCols; ++k)
+            {
+                const std::size_t iBegin = k<bn ? 0u : k-bn+1u;
+                const std::size_t iEnd   = k<an ? k+1u : an;
+                for(std::size_t i=iBegin; i!=iEnd; ++i)
+                {
+                    T hi = 0;
+                    const T lo = mulWide(a[i], b[k-i], hi);
+                    T carry = 0;
+                    c0 = addCarry(c0, lo, carry);
+                    c1 = addCarry(c1, hi, carry);
+                    c2 = T(c2+carry);
+                }
+
+                r[k] = c0;
+                c0 = c1;
+                c1 = c2;
+                c2 = 0;
+            }
+            r[nCols] = c0;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+//! r = a^2, n>=1, r - 2n чанков и не должен пересекаться с a.
+//! Произведения a[i]*a[j] при i<j одинаковы попарно, поэтому сначала считаем только
+//! треугольник над диагональю (строками через addmul_1, строки укорачиваются), потом
+//! одним проходом удваиваем его и добавляем квадраты a[i]^2 - почти вдвое меньше умножений
+template<typename T>
+inline
+void sqr_basecase(T *r, const T *a, std::size_t n)
+{
+    if (n<=details::mulFixedMaxSize)
+    {
+        // Развёрнутые варианты на таких размерах быстрее, чем экономия на умножениях
+        details::getMulFixed<T>(n, n)(r, a, a);
+        return;
+    }
+
+    r[0] = 0;
+    r[n] = mul_1(r+1, a+1, n-1u, a[0]);
+    for(std::size_t i=1; i!=n-1u; ++i)
+        r[n+i] = addmul_1(r+2u*i+1u, a+i+1u, n-1u-i, a[i]);
+    r[2u*n-1u] = 0;
+
+    constexpr int topShift = limbBits<T>()-1;
+
+    T carry = 0;
+    T out   = 0; // старший бит, выдвинутый из предыдущего чанка при удвоении
+    for(std::size_t i=0; i!=n; ++i)
+    {
+        T hi = 0;
+        const T lo = mulWide(a[i], a[i], hi);
+
+        const T r0 = r[2u*i];
+        const T r1 = r[2u*i+1u];
+        const T d0 = T(T(r0<<1) | out);
+        const T d1 = T(T(r1<<1) | T(r0>>topShift));
+        out = T(r1>>topShift);
+
+        r[2u*i]    = addCarry(d0, lo, carry);
+        r[2u*i+1u] = addCarry(d1, hi, carry);
+    }
+}
+
+//----------------------------------------------------------------------------
+//! Сравнение a и b, по n чанков: -1, 0, 1
+template<typename T>
+inline
+int cmp(const T *a, const T *b, std::size_t n)
+{
+    for(std::size_t i=n; i-->0;)
+    {
+        if (a[i]!=b[i])
+            return a[i]<b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+//! Сравнение чисел разной длины (ведущие нули допускаются): -1, 0, 1
+template<typename T>
+inline
+int cmp(const T *a, std::size_t an, const T *b, std::size_t bn)
+{
+    an = normalizedSize(a, an);
+    bn = normalizedSize(b, bn);
+    if (an!=bn)
+        return an<bn ? -1 : 1;
+    return cmp(a, b, an);
+}
+
+//----------------------------------------------------------------------------
+//! q = a / d, a и q - по n чанков, d!=0. Возвращает остаток. q может совпадать с a
+template<typename T>
+inline
+T divrem_1(T *q, const T *a, std::size_t n, T d)
+{
+    // Нормализуем делитель, тогда divWide получает старший бит делителя установленным,
+    // а остаток всегда меньше делителя, и частное влезает в чанк
+    const int s  = countLeadingZeros(d);
+    const T   dn = T(d<<s);
+
+    T r = 0;
+    if (s)
+    {
+        // Старшие биты a, выдвинутые нормализацией
+        r = n ? T(a[n-1]>>(limbBits<T>()-s)) : T(0);
+        for(std::size_t i=n; i-->0;)
+        {
+            const T lo = T(T(a[i]<<s) | (i ? T(a[i-1]>>(limbBits<T>()-s)) : T(0)));
+            q[i] = divWide(r, lo, dn, r);
+        }
+    }
+    else
+    {
+        for(std::size_t i=n; i-->0;)
+            q[i] = divWide(r, a[i], dn, r);
+    }
+
+    return T(r>>s);
+}
+
+//----------------------------------------------------------------------------
+//! Размер scratch (в чанках) для divrem
+inline
+std::size_t divremScratchSize(std::size_t un, std::size_t dn)
+{
+    return un+1u + dn;
+}
+
+//----------------------------------------------------------------------------
+//! Деление "столбиком" (Кнут, т.2, 4.3.1, алгоритм D): q = u / d, остаток - в младших dn
+//! чанках u, старшие обнуляются. un>=dn>=2, старший чанк d ненулевой. q - un-dn+1 чанков,
+//! не пересекается с u и d. scratch - не меньше divremScratchSize(un, dn) чанков.
+//! Делитель и делимое нормализуются сдвигом (старший бит делителя - единица), цифра частного
+//! оценивается по двум старшим чанкам делимого и проверяется по двум старшим чанкам
+//! делителя - после этого она больше настоящей не более чем на единицу, и это редкое
+//! превышение исправляется одним обратным сложением. Вычитание - submul_1 на месте
+template<typename T>
+inline
+void divrem(T *q, T *u, std::size_t un, const T *d, std::size_t dn, T *scratch)
+{
+    const int s = countLeadingZeros(d[dn-1u]);
+
+    T *v = scratch;        // нормализованный делитель, dn чанков
+    T *w = scratch + dn;   // нормализованное делимое, un+1 чанков
+
+    if (s)
+    {
+        lshift(v, d, dn, s);
+        w[un] = lshift(w, u, un, s);
+    }
+    else
+    {
+        for(std::size_t i=0; i!=dn; ++i)
+            v[i] = d[i];
+        for(std::size_t i=0; i!=un; ++i)
+            w[i] = u[i];
+        w[un] = 0;
+    }
+
+    const T v1 = v[dn-1u];
+    const T v2 = v[dn-2u];
+
+    for(std::size_t j=un-dn+1u; j-->0;)
+    {
+        const T hi = w[j+dn];
+        const T lo = w[j+dn-1u];
+
+        T    qHat = 0;
+        T    rHat = 0;
+        bool rBig = false; // rHat не влезает в чанк - проверка по второму чанку делителя не нужна
+
+        if (hi>=v1)
+        {
+            // Здесь hi==v1, цифра частного - не больше B-1
+            qHat = T(~T(0));
+            T c  = 0;
+            rHat = addCarry(lo, v1, c);
+            rBig = c!=0;
+        }
+        else
+        {
+            qHat = divWide(hi, lo, v1, rHat);
+        }
+
+        // qHat*v2 > rHat:w[j+dn-2] - оценка завышена, не больше двух раз
+        while(!rBig)
+        {
+            T pHi = 0;
+            const T pLo = mulWide(qHat, v2, pHi);
+            if (pHi<rHat || (pHi==rHat && pLo<=w[j+dn-2u]))
+                break;
+
+            --qHat;
+            T c  = 0;
+            rHat = addCarry(rHat, v1, c);
+            rBig = c!=0;
+        }
+
+        const T borrow = submul_1(w+j, v, dn, qHat);
+        const T top    = w[j+dn];
+        w[j+dn] = T(top-borrow);
+
+        if (top<borrow)
+        {
+            // Вычли лишний делитель - возвращаем
+            --qHat;
+            w[j+dn] = T(w[j+dn] + add_n(w+j, w+j, v, dn));
+        }
+
+        q[j] = qHat;
+    }
+
+    if (s)
+        rshift(u, w, dn, s);
+    else
+    {
+        for(std::size_t i=0; i!=dn; ++i)
+            u[i] = w[i];
+    }
+
+    for(std::size_t i=dn; i<un; ++i)
+        u[i] = 0;
+}
+
+//----------------------------------------------------------------------------
+//! Обратный к нечётному d по модулю B: d*binvert_1(d) == 1 (mod B)
+template<typename T>
+inline
+T binvert_1(T d)
+{
+    using U = std::common_type_t<T, unsigned>;
+
+    // d*d == 1 (mod 8), каждая итерация Ньютона удваивает число верных бит
+    T inv = d;
+    for(int bits=3; bits<limbBits<T>(); bits*=2)
+        inv = T(U(inv)*U(T(2u - T(U(d)*U(inv)))));
+    return inv;
+}
+
+//----------------------------------------------------------------------------
+//! r = a / d для a, которое делится на нечётное d нацело. Вместо деления - умножение
+//! на обратный к d по модулю B (как divexact_1 в GMP). r может совпадать с a
+template<typename T>
+inline
+void divexact_1(T *r, const T *a, std::size_t n, T d)
+{
+    using U = std::common_type_t<T, unsigned>;
+
+    const T inv = binvert_1(d);
+
+    T c = 0;
+    for(std::size_t i=0; i!=n; ++i)
+    {
+        const T s      = a[i];
+        const T borrow = T(s<c);
+        const T q      = T(U(T(s-c))*U(inv));
+        r[i] = q;
+
+        T hi = 0;
+        mulWide(q, d, hi);
+        c = T(hi + borrow);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Умножение Монтгомери по нечётному модулю m из n чанков, R = B^n.
+// Числа хранятся в виде x*R mod m, произведение таких чисел - a*b/R mod m, и деление на R
+// делается без деления: к произведению добавляется u*m, обнуляющее младший чанк, и чанк
+// отбрасывается, n раз. mInv = -m^-1 mod B (montInverse). Результаты полностью
+// приведены (меньше m), если меньше m были аргументы.
+
+//! mInv для mont_mul/redc: -m0^-1 mod B, m0 - младший чанк нечётного модуля
+template<typename T>
+inline
+T montInverse(T m0)
+{
+    return T(T(0u)-binvert_1(m0));
+}
+
+//----------------------------------------------------------------------------
+//! r = t / R mod m (REDC), t - 2n чанков, t<m*R, t портится. r - n чанков, может совпадать с t+n
+template<typename T>
+inline
+void redc(T *r, T *t, const T *m, std::size_t n, T mInv)
+{
+    using U = std::common_type_t<T, unsigned>;
+
+    // После каждого шага t делится на B нацело: младший чанк обнулён и дальше не нужен
+    T top = 0;
+    for(std::size_t i=0; i!=n; ++i)
+    {
+        const T u = T(U(t[i])*U(mInv));
+        const T c = addmul_1(t+i, m, n, u);
+        top = T(top + add_1(t+i+n, t+i+n, n-i, c));
+    }
+
+    // top:t[n..2n) < 2m
+    if (top || cmp(t+n, m, n)>=0)
+        sub_n(r, t+n, m, n);
+    else if (r!=t+n)
+    {
+        for(std::size_t i=0; i!=n; ++i)
+            r[i] = t[n+i];
+    }
+}
+
+//----------------------------------------------------------------------------
+//! r = a * b / R mod m, a, b < m - по n чанков. Умножение и приведение чередуются по
+//! чанкам b (CIOS): за шаг - addmul_1 по a и addmul_1 по m в одном и том же окне t,
+//! без промежуточного произведения в 2n чанков и без сдвигов окна.
+//! t - рабочая область из 2n+1 чанков, r может совпадать с a или b
+template<typename T>
+inline
+void mont_mul(T *r, const T *a, const T *b, const T *m, std::size_t n, T mInv, T *t)
+{
+    using U = std::common_type_t<T, unsigned>;
+
+    for(std::size_t i=0; i!=2u*n+1u; ++i)
+        t[i] = 0;
+
+    // Перед шагом i в t[i..i+n] - не больше n+1 значащих чанков (сумма меньше 2m*B^i),
+    // поэтому переносы не выходят за t[2n]
+    for(std::size_t i=0; i!=n; ++i)
+    {
+        const T c1 = addmul_1(t+i, a, n, b[i]);
+        const T u  = T(U(t[i])*U(mInv));
+        const T c2 = addmul_1(t+i, m, n, u);
+        add_1(t+i+n, t+i+n, n+1u-i, c1);
+        add_1(t+i+n, t+i+n, n+1u-i, c2);
+    }
+
+    if (t[2u*n] || cmp(t+n, m, n)>=0)
+        sub_n(r, t+n, m, n);
+    else
+    {
+        for(std::size_t i=0; i!=n; ++i)
+            r[i] = t[n+i];
+    }
+}
+
+//----------------------------------------------------------------------------
+//! r = a^2 / R mod m: квадрат "столбиком" (почти вдвое меньше умножений) и REDC.
+//! t - рабочая область из 2n чанков, r может совпадать с a
+template<typename T>
+inline
+void mont_sqr(T *r, const T *a, const T *m, std::size_t n, T mInv, T *t)
+{
+    sqr_basecase(t, a, n);
+    redc(r, t, m, n, mInv);
+}
+
+//----------------------------------------------------------------------------
+//! r = a * b / R mod m, как mont_mul, но без ветвлений и циклов, длина которых зависит от
+//! значений: переносы шага идут ровно в два чанка окна t[i+n], t[i+n+1] (сумма в окне меньше
+//! 2m*B, дальше они не уходят), модуль вычитается всегда, а нужный из двух результатов
+//! выбирается маской. Время зависит только от n, если постоянного времени addmul_1, sub_n и
+//! само умножение чанков. t - рабочая область из 2n+1 чанков, r может совпадать с a или b
+template<typename T>
+inline
+void mont_mul_fixed(T *r, const T *a, const T *b, const T *m, std::size_t n, T mInv, T *t)
+{
+    using U = std::common_type_t<T, unsigned>;
+
+    for(std::size_t i=0; i!=2u*n+1u; ++i)
+        t[i] = 0;
+
+    for(std::size_t i=0; i!=n; ++i)
+    {
+        T c = 0;
+        const T c1 = addmul_1(t+i, a, n, b[i]);
+        t[i+n]    = addCarry(t[i+n], c1, c);
+        t[i+n+1u] = T(t[i+n+1u] + c);
+
+        const T u  = T(U(t[i])*U(mInv));
+        const T c2 = addmul_1(t+i, m, n, u);
+        c = 0;
+        t[i+n]    = addCarry(t[i+n], c2, c);
+        t[i+n+1u] = T(t[i+n+1u] + c);
+    }
+
+    // t[2n]:t[n..2n) < 2m. Вычитаем m, если был перенос в t[2n] или не было заёма
+    const T borrow = sub_n(r, t+n, m, n);
+    const T mask   = T(T(0) - T(t[2u*n] | T(borrow^1u)));
+    for(std::size_t i=0; i!=n; ++i)
+        r[i] = T((r[i] & mask) | (t[n+i] & T(~mask)));
+}
+
+//----------------------------------------------------------------------------
+//! r = a * b mod B^n - только младшие n чанков произведения (примерно вдвое меньше
+//! умножений, чем полное). a и b - по n чанков, r не пересекается с a и b
+template<typename T>
+inline
+void mullo_basecase(T *r, const T *a, const T *b, std::size_t n)
+{
+    for(std::size_t i=0; i!=n; ++i)
+        r[i] = 0;
+
+    for(std::size_t i=0; i!=n; ++i)
+        addmul_1(r+i, b, n-i, a[i]);
+}
+
+//----------------------------------------------------------------------------
+//! r = a * b без столбцов младше k: произведения a[i]*b[j] с i+j<k не считаются, так что
+//! старшие чанки r меньше точных не больше чем на k*B^(k+1) (в единицах младшего чанка),
+//! а чанки младше k - мусор. Для приближённого частного в редукции Барретта.
+//! r - an+bn чанков и не пересекается с a и b
+template<typename T>
+inline
+void mulhi_basecase(T *r, const T *a, std::size_t an, const T *b, std::size_t bn, std::size_t k)
+{
+    for(std::size_t i=0; i!=an+bn; ++i)
+        r[i] = 0;
+
+    for(std::size_t i=0; i!=an; ++i)
+    {
+        const std::size_t j0 = k>i ? k-i : 0u;
+        if (j0<bn)
+            r[i+bn] = addmul_1(r+i+j0, b+j0, bn-j0, a[i]);
+    }
+}
+
+//----------------------------------------------------------------------------
+//! Исполнитель для алгоритмов, которые умеют раскидывать независимые куски работы по потокам:
+//! invoke(f1, f2, ...) выполняет все функции и возвращается, когда все отработали,
+//! parallel() - есть ли смысл вообще дробить работу. serial_invoke - всё по очереди
+//! в текущем потоке, параллельный вариант - bigint_details::pool_invoke (thread_pool.h)
+struct serial_invoke
+{
+    static constexpr bool parallel() { return false; }
+
+    template<typename... Fn>
+    void operator()(Fn&&... fns) const
+    {
+        (fns(), ...);
+    }
+};
+
+//----------------------------------------------------------------------------
+//! Пороги переключения алгоритмов умножения, в чанках меньшего множителя.
+//! По умолчанию - из defs.h (а там - из marty_bigint_tuning.h, если он есть и подобран для этого
+//! же размера чанка).
+//! Одни и те же пороги надо передавать и в xxxScratchSize, и в само умножение
+struct mul_thresholds
+{
+    std::size_t karatsuba    = std::size_t(MARTY_BIGINT_KARATSUBA_THRESHOLD);
+    std::size_t sqrKaratsuba = std::size_t(MARTY_BIGINT_SQR_KARATSUBA_THRESHOLD);
+    std::size_t toom3        = std::size_t(MARTY_BIGINT_TOOM3_THRESHOLD);
+    std::size_t toom4        = std::size_t(MARTY_BIGINT_TOOM4_THRESHOLD);
+    std::size_t toom32       = std::size_t(MARTY_BIGINT_TOOM32_THRESHOLD); // Тоом-2.5/3.5 для несбалансированных
+    std::size_t fft          = std::size_t(MARTY_BIGINT_FFT_THRESHOLD);  // используется в BigInt
+    std::size_t ntt          = std::size_t(MARTY_BIGINT_NTT_THRESHOLD);  // используется в BigInt
+    std::size_t parallel     = std::size_t(MARTY_BIGINT_PARALLEL_THRESHOLD); // mul_parallel и пул потоков в BigInt
+
+    //! Карацуба - не меньше чем с 2х чанков. Порог квадратов не ниже порога произведений -
+    //! тогда рабочей области квадрата всегда хватает mulScratchSize(n, n). Параллелить
+    //! умножение "столбиком" смысла нет, так что и порог параллельности не ниже Карацубы
+    mul_thresholds normalized() const
+    {
+        mul_thresholds res = *this;
+        res.karatsuba    = std::max<std::size_t>(res.karatsuba, 2u);
+        res.sqrKaratsuba = std::max(res.sqrKaratsuba, res.karatsuba);
+        res.parallel     = std::max(res.parallel, res.karatsuba);
+        return res;
+    }
+};
+
+//----------------------------------------------------------------------------
+//! r = a * b с выбором алгоритма по размеру, r - an+bn чанков и не пересекается с a и b.
+//! scratch - не меньше mulScratchSize(an, bn, th) чанков. th - нормализованные (normalized())
+template<typename T>
+inline
+void mul(T *r, const T *a, std::size_t an, const T *b, std::size_t bn, T *scratch, const mul_thresholds &th = mul_thresholds().normalized());
+
+inline
+std::size_t mulScratchSize(std::size_t an, std::size_t bn, const mul_thresholds &th = mul_thresholds().normalized());
+
+template<typename T>
+inline
+void sqr(T *r, const T *a, std::size_t n, T *scratch, const mul_thresholds &th = mul_thresholds().normalized());
+
+inline
+std::size_t sqrScratchSize(std::size_t n, const mul_thresholds &th = mul_thresholds().normalized());
+
+//----------------------------------------------------------------------------
+namespace details {
+
+// Лучшее "простое" умножение для данного размера, an>=bn
+template<typename T>
+inline
+void mul_small(T *r, const T *a, std::size_t an, const T *b, std::size_t bn)
+{
+    if (an<=mulFixedMaxSize || hasFastAddmul<T>())
+        mul_basecase(r, a, an, b, bn);
+    else
+        mul_comba(r, a, an, b, bn);
+}
+
+// d = |x-y|, xn>=yn, d - xn чанков, может совпадать с x или y. Возвращает true, если x<y
+template<typename T>
+inline
+bool abs_sub(T *d, const T *x, std::size_t xn, const T *y, std::size_t yn)
+{
+    if (cmp(x, xn, y, yn)>=0)
+    {
+        sub(d, x, xn, y, yn);
+        return false;
+    }
+
+    // x<y, значит x влезает в yn чанков
+    sub_n(d, y, x, yn);
+    for(std::size_t i=yn; i!=xn; ++i)
+        d[i] = 0;
+    return true;
+}
+
+// r += c*B^off, r - rn чанков. Сумма обязана влезть в r
+template<typename T>
+inline
+void addAt(T *r, std::size_t rn, std::size_t off, const T *c, std::size_t cn)
+{
+    cn = normalizedSize(c, cn);
+    add(r+off, r+off, rn-off, c, cn);
+}
+
+// Сильно несбалансированные множители (an>=bn) - режем длинный на куски по bn чанков,
+// каждый кусок умножается через mulFn(r, a, an, b, bn, scratch)
+template<typename T, typename MulFn>
+inline
+void mulChunked(T *r, const T *a, std::size_t an, const T *b, std::size_t bn, T *scratch, MulFn mulFn)
+{
+    mulFn(r, a, bn, b, bn, scratch);
+    for(std::size_t i=bn; i<an; i+=bn)
+    {
+        const std::size_t len = std::min(bn, an-i);
+        T *p = scratch;
+        mulFn(p, a+i, len, b, bn, scratch+len+bn);
+
+        // В r уже готовы чанки [0, i+bn), новый кусок перекрывается с ними на bn чанков
+        for(std::size_t k=0; k!=len; ++k)
+            r[i+bn+k] = p[bn+k];
+        const T carry = add_n(r+i, r+i, p, bn);
+        add_1(r+i+bn, r+i+bn, len, carry);
+    }
+}
+
+template<typename SizeFn>
+inline
+std::size_t mulChunkedScratchSize(std::size_t an, std::size_t bn, SizeFn sizeFn)
+{
+    std::size_t res = 2u*bn + sizeFn(bn, bn);
+    const std::size_t tail = an%bn;
+    if (tail)
+        res = std::max(res, tail+bn + sizeFn(tail, bn));
+    return res;
+}
+
+// Один шаг Карацубы, an>=bn>(an+1)/2: a = a1*B^h + a0, b = b1*B^h + b0,
+// a*b = z2*B^2h + (z0 + z2 - (a0-a1)*(b0-b1))*B^h + z0, где z0 = a0*b0, z2 = a1*b1.
+// (a0-a1)*(b0-b1) считаем как |a0-a1|*|b0-b1| со знаком отдельно, так что все
+// промежуточные значения неотрицательны и не длиннее h (2h для произведений).
+// z0 и z2 пишутся сразу на место в r, произведения половинок - через mulFn
+template<typename T, typename MulFn>
+inline
+void karatsubaStep(T *r, const T *a, std::size_t an, const T *b, std::size_t bn, T *scratch, MulFn mulFn)
+{
+    const std::size_t h   = (an+1u)/2u;
+    const std::size_t n1a = an-h; // 1..h
+    const std::size_t n1b = bn-h; // 1..h
+
+    T *da   = scratch;
+    T *db   = scratch + h;
+    T *zm   = scratch + 2u*h;
+    T *t    = scratch + 4u*h;       // 2h+1
+    T *next = scratch + 6u*h + 1u;
+
+    // da = |a0-a1|, db = |b0-b1|
+    const bool negA = abs_sub(da, a, h, a+h, n1a);
+    const bool negB = abs_sub(db, b, h, b+h, n1b);
+
+    mulFn(zm    , da , h  , db , h  , next); // |a0-a1|*|b0-b1|, 2h
+    mulFn(r     , a  , h  , b  , h  , next); // z0, 2h
+    mulFn(r+2u*h, a+h, n1a, b+h, n1b, next); // z2, n1a+n1b
+
+    // t = z0 + z2 -+ zm = a0*b1 + a1*b0, не отрицательно
+    t[2u*h] = add(t, r, 2u*h, r+2u*h, n1a+n1b);
+    if (negA==negB)
+        sub(t, t, 2u*h+1u, zm, 2u*h);
+    else
+        add(t, t, 2u*h+1u, zm, 2u*h);
+
+    // r += t*B^h. Всё произведение влезает в an+bn чанков, значит и t - в an+bn-h
+    addAt(r, an+bn, h, t, 2u*h+1u);
+}
+
+template<typename SizeFn>
+inline
+std::size_t karatsubaStepScratchSize(std::size_t an, std::size_t bn, SizeFn sizeFn)
+{
+    const std::size_t h = (an+1u)/2u;
+    return 6u*h + 1u + std::max(sizeFn(h, h), sizeFn(an-h, bn-h));
+}
+
+// Шаг Карацубы для квадрата, n>=2: a^2 = z2*B^2h + (z0 + z2 - (a0-a1)^2)*B^h + z0.
+// Средний член всегда неотрицателен, знак разности не нужен; вместо двух разностей - одна
+template<typename T, typename SqrFn>
+inline
+void sqrKaratsubaStep(T *r, const T *a, std::size_t n, T *scratch, SqrFn sqrFn)
+{
+    const std::size_t h  = (n+1u)/2u;
+    const std::size_t n1 = n-h; // 1..h
+
+    T *d    = scratch;
+    T *zm   = scratch + h;
+    T *t    = scratch + 3u*h;       // 2h+1
+    T *next = scratch + 5u*h + 1u;
+
+    abs_sub(d, a, h, a+h, n1);
+
+    sqrFn(zm    , d  , h , next); // (a0-a1)^2, 2h
+    sqrFn(r     , a  , h , next); // z0, 2h
+    sqrFn(r+2u*h, a+h, n1, next); // z2, 2*n1
+
+    // t = z0 + z2 - zm = 2*a0*a1
+    t[2u*h] = add(t, r, 2u*h, r+2u*h, 2u*n1);
+    sub(t, t, 2u*h+1u, zm, 2u*h);
+
+    addAt(r, 2u*n, h, t, 2u*h+1u);
+}
+
+template<typename SizeFn>
+inline
+std::size_t sqrKaratsubaStepScratchSize(std::size_t n, SizeFn sizeFn)
+{
+    const std::size_t h = (n+1u)/2u;
+    return 5u*h + 1u + std::max(sizeFn(h), sizeFn(n-h));
+}
+
+// Точки Тоома: p = v(x), m = |v(-x)|, neg - знак v(-x), n - длина обоих.
+// На выходе p - нечётная часть (v(x)-v(-x))/2, делённая ещё на 2^(oddShift-1),
+// m - чётная часть (v(x)+v(-x))/2. Обе неотрицательны, вычитания только из большего
+template<typename T>
+inline
+void toomPair(T *p, T *m, bool neg, std::size_t n, int oddShift)
+{
+    if (!neg)
+    {
+        sub_n(p, p, m, n); // v(x) - |v(-x)|
+        lshift(m, m, n, 1);
+        add_n(m, m, p, n); // v(x) + |v(-x)|
+    }
+    else
+    {
+        add_n(p, p, m, n); // v(x) + |v(-x)|
+        lshift(m, m, n, 1);
+        sub_n(m, p, m, n); // v(x) - |v(-x)|
+    }
+
+    rshift(p, p, n, oddShift);
+    rshift(m, m, n, 1);
+}
+
+// Интерполяция произведения степени 4 (Тоом-3 и Тоом-3.5) по точкам 0, 1, -1, 2, inf.
+// c0 (2k чанков) и c4 (n4 чанков) уже лежат на своих местах в r (rn чанков),
+// v1 = v(1), vm1 = |v(-1)|, v2 = v(2) - по L чанков, портятся; neg - знак v(-1).
+// c1..c3 добавляются в r со смещением
+template<typename T>
+inline
+void toomInterpolate5(T *r, std::size_t rn, std::size_t k, T *v1, T *vm1, T *v2, bool neg, std::size_t L, std::size_t n4)
+{
+    const T *c0 = r;
+    const T *c4 = r + 4u*k;
+
+    toomPair(v1, vm1, neg, L, 1); // v1 = c1+c3, vm1 = c0+c2+c4
+
+    sub(vm1, vm1, L, c0, 2u*k);
+    sub(vm1, vm1, L, c4, n4);     // c2
+
+    // v(2) = c0 + 2c1 + 4c2 + 8c3 + 16c4
+    sub(v2, v2, L, c0, 2u*k);
+    const T bw = submul_1(v2, c4, n4, T(16));
+    sub_1(v2+n4, v2+n4, L-n4, bw);
+    submul_1(v2, vm1, L, T(4));   // 2c1 + 8c3
+    rshift(v2, v2, L, 1);
+    sub_n(v2, v2, v1, L);         // 3c3
+    divexact_1(v2, v2, L, T(3));  // c3
+    sub_n(v1, v1, v2, L);         // c1
+
+    // c0 и c4 уже на месте, остальное - сложениями со смещением
+    for(std::size_t i=2u*k; i!=4u*k; ++i)
+        r[i] = 0;
+    addAt(r, rn,    k, v1 , L);
+    addAt(r, rn, 2u*k, vm1, L);
+    addAt(r, rn, 3u*k, v2 , L);
+}
+
+// Значения x = x2*X^2 + x1*X + x0 (X = B^k, x2 - n2 чанков) для Тоома-3: x(1), |x(-1)|, x(2),
+// по k+1 чанков. Возвращает знак x(-1)
+template<typename T>
+inline
+bool toom3Eval(T *p1, T *m1, T *p2, const T *x, std::size_t k, std::size_t n2)
+{
+    const std::size_t k1 = k+1u;
+    const T *x0 = x;
+    const T *x1 = x + k;
+    const T *x2 = x + 2u*k;
+
+    // p2 пока под x0+x2
+    p2[k] = add(p2, x0, k, x2, n2);
+    add(p1, p2, k1, x1, k);
+    const bool neg = abs_sub(m1, p2, k1, x1, k);
+
+    // x0 + 2*x1 + 4*x2
+    for(std::size_t i=0; i!=k; ++i)
+        p2[i] = x0[i];
+    p2[k] = addmul_1(p2, x1, k, T(2));
+    const T c = addmul_1(p2, x2, n2, T(4));
+    add_1(p2+n2, p2+n2, k1-n2, c);
+
+    return neg;
+}
+
+inline
+bool toom3Fits(std::size_t an, std::size_t bn)
+{
+    // an>=bn, у b должна быть непустая старшая треть
+    return bn>2u*((an+2u)/3u);
+}
+
+inline
+bool toom4Fits(std::size_t an, std::size_t bn)
+{
+    return bn>3u*((an+3u)/4u);
+}
+
+// Тоом-2.5: a - три части по k, b - две, у b непустая старшая часть не длиннее k
+inline
+bool toom32Fits(std::size_t an, std::size_t bn)
+{
+    const std::size_t k = (an+2u)/3u;
+    return bn>k && bn<=2u*k;
+}
+
+// Тоом-3.5: a - четыре части по k, b - две
+inline
+bool toom42Fits(std::size_t an, std::size_t bn)
+{
+    const std::size_t k = (an+3u)/4u;
+    return bn>k && bn<=2u*k;
+}
+
+// Несбалансированные множители, an>=bn: an от 1.5 до 2 bn - Тоом-2.5, от 2 до 2.5 bn - Тоом-3.5.
+// Шаг Карацубы для них дал бы старшую половину b в разы короче младшей, а нарезка
+// по bn - лишнее целое умножение bn*bn. Дальше 2.5 bn Тоом-3.5 по замерам уже не быстрее
+// нарезки длинного множителя на куски по bn (mulChunked)
+inline
+bool useToom32(std::size_t an, std::size_t bn, const mul_thresholds &th)
+{
+    return bn>=th.toom32 && 2u*an>=3u*bn && an<2u*bn && toom32Fits(an, bn);
+}
+
+inline
+bool useToom42(std::size_t an, std::size_t bn, const mul_thresholds &th)
+{
+    return bn>=th.toom32 && an>=2u*bn && 2u*an<5u*bn && toom42Fits(an, bn);
+}
+
+} // namespace details
+
+//----------------------------------------------------------------------------
+//! Размер scratch (в чанках) для sqr_karatsuba
+inline
+std::size_t sqrKaratsubaScratchSize(std::size_t n, std::size_t threshold)
+{
+    if (threshold<2u)
+        threshold = 2u;
+
+    if (n<threshold)
+        return 0;
+
+    return details::sqrKaratsubaStepScratchSize(n, [threshold](std::size_t xn) { return sqrKaratsubaScratchSize(xn, threshold); });
+}
+
+//----------------------------------------------------------------------------
+//! r = a^2 по Карацубе, n>=1, r - 2n чанков и не пересекается с a. Ниже порога - sqr_basecase.
+//! scratch - не меньше sqrKaratsubaScratchSize(n, threshold) чанков
+template<typename T>
+inline
+void sqr_karatsuba(T *r, const T *a, std::size_t n, T *scratch, std::size_t threshold)
+{
+    if (threshold<2u)
+        threshold = 2u;
+
+    if (n<threshold)
+    {
+        sqr_basecase(r, a, n);
+        return;
+    }
+
+    details::sqrKaratsubaStep(r, a, n, scratch, [threshold](T *r_, const T *a_, std::size_t n_, T *scratch_)
+                                                {
+                                                    sqr_karatsuba(r_, a_, n_, scratch_, threshold);
+                                                });
+}
+
+//----------------------------------------------------------------------------
+//! Размер scratch (в чанках) для mul_karatsuba. Повторяет ветвление mul_karatsuba
+inline
+std::size_t karatsubaScratchSize(std::size_t an, std::size_t bn, std::size_t threshold)
+{
+    if (an<bn)
+        std::swap(an, bn);
+
+    if (threshold<2u)
+        threshold = 2u;
+
+    if (bn<threshold)
+        return 0;
+
+    auto sizeFn = [threshold](std::size_t xn, std::size_t yn) { return karatsubaScratchSize(xn, yn, threshold); };
+
+    if (bn<=(an+1u)/2u)
+        return details::mulChunkedScratchSize(an, bn, sizeFn);
+
+    return details::karatsubaStepScratchSize(an, bn, sizeFn);
+}
+
+//----------------------------------------------------------------------------
+//! r = a * b по Карацубе, an>=1, bn>=1, r - an+bn чанков и не должен пересекаться с a и b.
+//! Рекурсия - только Карацуба, до порога threshold, ниже - обычное умножение.
+//! Все временные значения - в scratch (не меньше karatsubaScratchSize(an, bn, threshold) чанков),
+//! аллокаций нет
+template<typename T>
+inline
+void mul_karatsuba(T *r, const T *a, std::size_t an, const T *b, std::size_t bn, T *scratch, std::size_t threshold)
+{
+    if (an<bn)
+    {
+        std::swap(a , b );
+        std::swap(an, bn);
+    }
+
+    if (threshold<2u)
+        threshold = 2u;
+
+    if (bn<threshold)
+    {
+        details::mul_small(r, a, an, b, bn);
+        return;
+    }
+
+    if (a==b && an==bn)
+    {
+        // scratch квадрата не больше, чем у произведения
+        sqr_karatsuba(r, a, an, scratch, threshold);
+        return;
+    }
+
+    auto mulFn = [threshold](T *r_, const T *a_, std::size_t an_, const T *b_, std::size_t bn_, T *scratch_)
+    {
+        mul_karatsuba(r_, a_, an_, b_, bn_, scratch_, threshold);
+    };
+
+    if (bn<=(an+1u)/2u)
+        details::mulChunked(r, a, an, b, bn, scratch, mulFn);
+    else
+        details::karatsubaStep(r, a, an, b, bn, scratch, mulFn);
+}
+
+//----------------------------------------------------------------------------
+//! Размер scratch (в чанках) для mul_toom3
+inline
+std::size_t toom3ScratchSize(std::size_t an, std::size_t bn, const mul_thresholds &th = mul_thresholds().normalized())
+{
+    if (an<bn)
+        std::swap(an, bn);
+
+    if (!details::toom3Fits(an, bn))
+        return karatsubaScratchSize(an, bn, th.karatsuba);
+
+    const std::size_t k = (an+2u)/3u;
+    const std::size_t s = std::max({ mulScratchSize(k+1u, k+1u, th), mulScratchSize(k, k, th), mulScratchSize(an-2u*k, bn-2u*k, th) });
+    return 3u*(2u*k+2u) + 6u*(k+1u) + s;
+}
+
+//----------------------------------------------------------------------------
+//! r = a * b по Тоому-Куку 3, r - an+bn чанков и не пересекается с a и b.
+//! a = a2*X^2 + a1*X + a0, X = B^k, то же для b; произведение c(X) = c4*X^4 + ... + c0
+//! восстанавливается по значениям в точках 0, 1, -1, 2, inf. Интерполяция идёт только
+//! через неотрицательные значения (знак есть только у v(-1)) и точные деления на 2 и 3.
+//! Произведения в точках - через mul (выбор алгоритма по размеру).
+//! Если у b нет старшей трети (сильно несбалансированные множители) - Карацуба.
+//! scratch - не меньше toom3ScratchSize(an, bn, th) чанков
+template<typename T>
+inline
+void mul_toom3(T *r, const T *a, std::size_t an, const T *b, std::size_t bn, T *scratch, const mul_thresholds &th = mul_thresholds().normalized())
+{
+    if (an<bn)
+    {
+        std::swap(a , b );
+        std::swap(an, bn);
+    }
+
+    if (!details::toom3Fits(an, bn))
+    {
+        mul_karatsuba(r, a, an, b, bn, scratch, th.karatsuba);
+        return;
+    }
+
+    const std::size_t k   = (an+2u)/3u;
+    const std::size_t k1  = k+1u;
+    const std::size_t n2a = an-2u*k;   // 1..k
+    const std::size_t n2b = bn-2u*k;   // 1..k
+    const std::size_t n4  = n2a+n2b;
+    const std::size_t L   = 2u*k+2u;   // произведения значений в точках
+
+    T *v1   = scratch;
+    T *vm1  = v1  + L;
+    T *v2   = vm1 + L;
+    T *ap1  = v2  + L;
+    T *am1  = ap1 + k1;
+    T *ap2  = am1 + k1;
+    T *bp1  = ap2 + k1;
+    T *bm1  = bp1 + k1;
+    T *bp2  = bm1 + k1;
+    T *next = bp2 + k1;
+
+    // Для квадрата значения в точках одни и те же - считаем один раз, а mul сам
+    // увидит одинаковые множители и возведёт в квадрат
+    const bool square = (a==b && an==bn);
+    const bool negA   = details::toom3Eval(ap1, am1, ap2, a, k, n2a);
+    const bool negB   = square ? negA : details::toom3Eval(bp1, bm1, bp2, b, k, n2b);
+    if (square)
+    {
+        bp1 = ap1;
+        bm1 = am1;
+        bp2 = ap2;
+    }
+
+    mul(v1    , ap1   , k1 , bp1   , k1 , next, th);
+    mul(vm1   , am1   , k1 , bm1   , k1 , next, th);
+    mul(v2    , ap2   , k1 , bp2   , k1 , next, th);
+    mul(r     , a     , k  , b     , k  , next, th); // c0
+    mul(r+4u*k, a+2u*k, n2a, b+2u*k, n2b, next, th); // c4
+
+    details::toomInterpolate5(r, an+bn, k, v1, vm1, v2, negA!=negB, L, n4);
+}
+
+//----------------------------------------------------------------------------
+//! Размер scratch (в чанках) для mul_toom4
+inline
+std::size_t toom4ScratchSize(std::size_t an, std::size_t bn, const mul_thresholds &th = mul_thresholds().normalized())
+{
+    if (an<bn)
+        std::swap(an, bn);
+
+    if (!details::toom4Fits(an, bn))
+        return toom3ScratchSize(an, bn, th);
+
+    const std::size_t k = (an+3u)/4u;
+    const std::size_t s = std::max({ mulScratchSize(k+1u, k+1u, th), mulScratchSize(k, k, th), mulScratchSize(an-3u*k, bn-3u*k, th) });
+    return 5u*(2u*k+2u) + 10u*(k+1u) + s;
+}
+
+//----------------------------------------------------------------------------
+//! r = a * b по Тоому-Куку 4, r - an+bn чанков и не пересекается с a и b.
+//! Точки 0, 1, -1, 2, -2, 1/2, inf. В точке 1/2 считаем 8*a(1/2) = 8a0 + 4a1 + 2a2 + a3,
+//! тогда произведение - это 64*c(1/2), всё целое. Как и в mul_toom3, интерполяция только
+//! через неотрицательные значения, деления - точные на 2, 4, 3 и 5.
+//! Если у b нет старшей четверти - Тоом-3 (а там, если надо, Карацуба).
+//! scratch - не меньше toom4ScratchSize(an, bn, th) чанков
+template<typename T>
+inline
+void mul_toom4(T *r, const T *a, std::size_t an, const T *b, std::size_t bn, T *scratch, const mul_thresholds &th = mul_thresholds().normalized())
+{
+    if (an<bn)
+    {
+        std::swap(a , b );
+        std::swap(an, bn);
+    }
+
+    if (!details::toom4Fits(an, bn))
+    {
+        mul_toom3(r, a, an, b, bn, scratch, th);
+        return;
+    }
+
+    const std::size_t k   = (an+3u)/4u;
+    const std::size_t k1  = k+1u;
+    const std::size_t n3a = an-3u*k;   // 1..k
+    const std::size_t n3b = bn-3u*k;   // 1..k
+    const std::size_t n6  = n3a+n3b;
+    const std::size_t L   = 2u*k+2u;
+
+    T *v1   = scratch;
+    T *vm1  = v1  + L;
+    T *v2   = vm1 + L;
+    T *vm2  = v2  + L;
+    T *vh   = vm2 + L;
+    T *ap1  = vh  + L;
+    T *am1  = ap1 + k1;
+    T *ap2  = am1 + k1;
+    T *am2  = ap2 + k1;
+    T *ah   = am2 + k1;
+    T *bp1  = ah  + k1;
+    T *bm1  = bp1 + k1;
+    T *bp2  = bm1 + k1;
+    T *bm2  = bp2 + k1;
+    T *bh   = bm2 + k1;
+    T *next = bh  + k1;
+
+    // x(1), |x(-1)|, x(2), |x(-2)|, 8*x(1/2), по k+1 чанков. neg1/neg2 - знаки x(-1)/x(-2)
+    auto eval = [k, k1](T *p1, T *m1, T *p2, T *m2, T *h, const T *x, std::size_t n3, bool &neg1, bool &neg2)
+    {
+        const T *x0 = x;
+        const T *x1 = x + k;
+        const T *x2 = x + 2u*k;
+        const T *x3 = x + 3u*k;
+
+        // Чётная и нечётная части в точке 1: p2 = x0+x2, m2 = x1+x3
+        p2[k] = add_n(p2, x0, x2, k);
+        for(std::size_t i=0; i!=k; ++i)
+            m2[i] = x1[i];
+        m2[k] = 0;
+        add(m2, m2, k1, x3, n3);
+
+        add_n(p1, p2, m2, k1);
+        neg1 = details::abs_sub(m1, p2, k1, m2, k1);
+
+        // То же в точке 2: p2 = x0 + 4*x2, m2 = 2*x1 + 8*x3
+        for(std::size_t i=0; i!=k; ++i)
+            p2[i] = x0[i];
+        p2[k] = addmul_1(p2, x2, k, T(4));
+        m2[k] = mul_1(m2, x1, k, T(2));
+        const T c = addmul_1(m2, x3, n3, T(8));
+        add_1(m2+n3, m2+n3, k1-n3, c);
+
+        // h пока под x(2)
+        add_n(h, p2, m2, k1);
+        neg2 = details::abs_sub(m2, p2, k1, m2, k1);
+        for(std::size_t i=0; i!=k1; ++i)
+            p2[i] = h[i];
+
+        // 8*x(1/2)
+        h[k] = mul_1(h, x0, k, T(8));
+        h[k] = T(h[k] + addmul_1(h, x1, k, T(4)));
+        h[k] = T(h[k] + addmul_1(h, x2, k, T(2)));
+        add(h, h, k1, x3, n3);
+    };
+
+    bool neg1A = false, neg2A = false, neg1B = false, neg2B = false;
+    eval(ap1, am1, ap2, am2, ah, a, n3a, neg1A, neg2A);
+    if (a==b && an==bn)
+    {
+        // Квадрат - см. mul_toom3
+        bp1 = ap1;  bm1 = am1;  bp2 = ap2;  bm2 = am2;  bh = ah;
+        neg1B = neg1A;
+        neg2B = neg2A;
+    }
+    else
+    {
+        eval(bp1, bm1, bp2, bm2, bh, b, n3b, neg1B, neg2B);
+    }
+
+    mul(v1    , ap1   , k1 , bp1   , k1 , next, th);
+    mul(vm1   , am1   , k1 , bm1   , k1 , next, th);
+    mul(v2    , ap2   , k1 , bp2   , k1 , next, th);
+    mul(vm2   , am2   , k1 , bm2   , k1 , next, th);
+    mul(vh    , ah    , k1 , bh    , k1 , next, th);
+    mul(r     , a     , k  , b     , k  , next, th); // c0
+    mul(r+6u*k, a+3u*k, n3a, b+3u*k, n3b, next, th); // c6
+
+    const T *c0 = r;
+    const T *c6 = r + 6u*k;
+
+    details::toomPair(v1, vm1, neg1A!=neg1B, L, 1); // v1 = c1+c3+c5   , vm1 = c0+c2+c4+c6
+    details::toomPair(v2, vm2, neg2A!=neg2B, L, 2); // v2 = c1+4c3+16c5, vm2 = c0+4c2+16c4+64c6
+
+    // Чётные коэффициенты
+    sub(vm1, vm1, L, c0, 2u*k);
+    sub(vm1, vm1, L, c6, n6);                       // c2 + c4
+    sub(vm2, vm2, L, c0, 2u*k);
+    T bw = submul_1(vm2, c6, n6, T(64));
+    sub_1(vm2+n6, vm2+n6, L-n6, bw);
+    rshift(vm2, vm2, L, 2);                         // c2 + 4c4
+    sub_n(vm2, vm2, vm1, L);
+    divexact_1(vm2, vm2, L, T(3));                  // c4
+    sub_n(vm1, vm1, vm2, L);                        // c2
+
+    // Нечётные: vh = 64c0 + 32c1 + 16c2 + 8c3 + 4c4 + 2c5 + c6
+    bw = submul_1(vh, c0, 2u*k, T(64));
+    sub_1(vh+2u*k, vh+2u*k, L-2u*k, bw);
+    submul_1(vh, vm1, L, T(16));
+    submul_1(vh, vm2, L, T(4));
+    sub(vh, vh, L, c6, n6);
+    rshift(vh, vh, L, 1);                           // 16c1 + 4c3 + c5
+    sub_n(vh, vh, v1, L);
+    divexact_1(vh, vh, L, T(3));                    // 5c1 + c3
+    sub_n(v2, v2, v1, L);
+    divexact_1(v2, v2, L, T(3));                    // c3 + 5c5
+    mul_1(v1, v1, L, T(5));
+    sub_n(v1, v1, v2, L);
+    sub_n(v1, v1, vh, L);
+    divexact_1(v1, v1, L, T(3));                    // c3
+    sub_n(v2, v2, v1, L);
+    divexact_1(v2, v2, L, T(5));                    // c5
+    sub_n(vh, vh, v1, L);
+    divexact_1(vh, vh, L, T(5));                    // c1
+
+    for(std::size_t i=2u*k; i!=6u*k; ++i)
+        r[i] = 0;
+    details::addAt(r, an+bn,    k, vh , L);
+    details::addAt(r, an+bn, 2u*k, vm1, L);
+    details::addAt(r, an+bn, 3u*k, v1 , L);
+    details::addAt(r, an+bn, 4u*k, vm2, L);
+    details::addAt(r, an+bn, 5u*k, v2 , L);
+}
+
+//----------------------------------------------------------------------------
+//! Размер scratch (в чанках) для mul_toom32
+inline
+std::size_t toom32ScratchSize(std::size_t an, std::size_t bn, const mul_thresholds &th = mul_thresholds().normalized())
+{
+    if (an<bn)
+        std::swap(an, bn);
+
+    if (!details::toom32Fits(an, bn))
+        return mulScratchSize(an, bn, th);
+
+    const std::size_t k = (an+2u)/3u;
+    const std::size_t s = std::max({ mulScratchSize(k+1u, k+1u, th), mulScratchSize(k, k, th), mulScratchSize(an-2u*k, bn-k, th) });
+    return 2u*(2u*k+2u) + 4u*(k+1u) + s;
+}
+
+//----------------------------------------------------------------------------
+//! r = a * b по Тоому-2.5 (toom32), для an примерно от 1.5 до 2 bn. r - an+bn чанков
+//! и не пересекается с a и b. a = a2*X^2 + a1*X + a0, b = b1*X + b0, X = B^k;
+//! произведение c3*X^3 + ... + c0 восстанавливается по точкам 0, 1, -1, inf -
+//! четыре умножения по k чанков. Если разбиение не подходит - обычный mul.
+//! scratch - не меньше toom32ScratchSize(an, bn, th) чанков
+template<typename T>
+inline
+void mul_toom32(T *r, const T *a, std::size_t an, const T *b, std::size_t bn, T *scratch, const mul_thresholds &th = mul_thresholds().normalized())
+{
+    if (an<bn)
+    {
+        std::swap(a , b );
+        std::swap(an, bn);
+    }
+
+    if (!details::toom32Fits(an, bn))
+    {
+        mul(r, a, an, b, bn, scratch, th);
+        return;
+    }
+
+    const std::size_t k   = (an+2u)/3u;
+    const std::size_t k1  = k+1u;
+    const std::size_t n2a = an-2u*k;   // 1..k
+    const std::size_t n1b = bn-k;      // 1..k
+    const std::size_t n3  = n2a+n1b;
+    const std::size_t L   = 2u*k+2u;
+
+    T *v1   = scratch;
+    T *vm1  = v1  + L;
+    T *ap1  = vm1 + L;
+    T *am1  = ap1 + k1;
+    T *bp1  = am1 + k1;
+    T *bm1  = bp1 + k1;
+    T *next = bm1 + k1;
+
+    // a(1), |a(-1)|; am1 пока под a0+a2
+    am1[k] = add(am1, a, k, a+2u*k, n2a);
+    add(ap1, am1, k1, a+k, k);
+    const bool negA = details::abs_sub(am1, am1, k1, a+k, k);
+
+    // b(1), |b(-1)|
+    bp1[k] = add(bp1, b, k, b+k, n1b);
+    const bool negB = details::abs_sub(bm1, b, k, b+k, n1b);
+    bm1[k] = 0;
+
+    mul(v1    , ap1   , k1 , bp1, k1 , next, th);
+    mul(vm1   , am1   , k1 , bm1, k1 , next, th);
+    mul(r     , a     , k  , b  , k  , next, th); // c0
+    mul(r+3u*k, a+2u*k, n2a, b+k, n1b, next, th); // c3
+
+    details::toomPair(v1, vm1, negA!=negB, L, 1); // v1 = c1+c3, vm1 = c0+c2
+    sub(v1 , v1 , L, r+3u*k, n3);                 // c1
+    sub(vm1, vm1, L, r     , 2u*k);               // c2
+
+    for(std::size_t i=2u*k; i!=3u*k; ++i)
+        r[i] = 0;
+    details::addAt(r, an+bn,    k, v1 , L);
+    details::addAt(r, an+bn, 2u*k, vm1, L);
+}
+
+//----------------------------------------------------------------------------
+//! Размер scratch (в чанках) для mul_toom42
+inline
+std::size_t toom42ScratchSize(std::size_t an, std::size_t bn, const mul_thresholds &th = mul_thresholds().normalized())
+{
+    if (an<bn)
+        std::swap(an, bn);
+
+    if (!details::toom42Fits(an, bn))
+        return mulScratchSize(an, bn, th);
+
+    const std::size_t k = (an+3u)/4u;
+    const std::size_t s = std::max({ mulScratchSize(k+1u, k+1u, th), mulScratchSize(k, k, th), mulScratchSize(an-3u*k, bn-k, th) });
+    return 3u*(2u*k+2u) + 6u*(k+1u) + s;
+}
+
+//----------------------------------------------------------------------------
+//! r = a * b по Тоому-3.5 (toom42), для an примерно от 2 до 4 bn. r - an+bn чанков
+//! и не пересекается с a и b. a = a3*X^3 + ... + a0, b = b1*X + b0, X = B^k;
+//! произведение степени 4 - по тем же точкам 0, 1, -1, 2, inf, что и в Тооме-3,
+//! пять умножений по k чанков. Если разбиение не подходит - обычный mul.
+//! scratch - не меньше toom42ScratchSize(an, bn, th) чанков
+template<typename T>
+inline
+void mul_toom42(T *r, const T *a, std::size_t an, const T *b, std::size_t bn, T *scratch, const mul_thresholds &th = mul_thresholds().normalized())
+{
+    if (an<bn)
+    {
+        std::swap(a , b );
+        std::swap(an, bn);
+    }
+
+    if (!details::toom42Fits(an, bn))
+    {
+        mul(r, a, an, b, bn, scratch, th);
+        return;
+    }
+
+    const std::size_t k   = (an+3u)/4u;
+    const std::size_t k1  = k+1u;
+    const std::size_t n3a = an-3u*k;   // 1..k
+    const std::size_t n1b = bn-k;      // 1..k
+    const std::size_t n4  = n3a+n1b;
+    const std::size_t L   = 2u*k+2u;
+
+    T *v1   = scratch;
+    T *vm1  = v1  + L;
+    T *v2   = vm1 + L;
+    T *ap1  = v2  + L;
+    T *am1  = ap1 + k1;
+    T *ap2  = am1 + k1;
+    T *bp1  = ap2 + k1;
+    T *bm1  = bp1 + k1;
+    T *bp2  = bm1 + k1;
+    T *next = bp2 + k1;
+
+    // a(1), |a(-1)|; ap2 пока под a0+a2, am1 - под a1+a3
+    ap2[k] = add(ap2, a  , k, a+2u*k, k);
+    am1[k] = add(am1, a+k, k, a+3u*k, n3a);
+    add_n(ap1, ap2, am1, k1);
+    const bool negA = details::abs_sub(am1, ap2, k1, am1, k1);
+
+    // a(2) = a0 + 2*a1 + 4*a2 + 8*a3
+    for(std::size_t i=0; i!=k; ++i)
+        ap2[i] = a[i];
+    ap2[k]  = addmul_1(ap2, a+k   , k, T(2));
+    ap2[k] += addmul_1(ap2, a+2u*k, k, T(4));
+    const T ca = addmul_1(ap2, a+3u*k, n3a, T(8));
+    add_1(ap2+n3a, ap2+n3a, k1-n3a, ca);
+
+    // b(1), |b(-1)|, b(2) = b0 + 2*b1
+    bp1[k] = add(bp1, b, k, b+k, n1b);
+    const bool negB = details::abs_sub(bm1, b, k, b+k, n1b);
+    bm1[k] = 0;
+
+    for(std::size_t i=0; i!=k; ++i)
+        bp2[i] = b[i];
+    bp2[k] = 0;
+    const T cb = addmul_1(bp2, b+k, n1b, T(2));
+    add_1(bp2+n1b, bp2+n1b, k1-n1b, cb);
+
+    mul(v1    , ap1   , k1 , bp1, k1 , next, th);
+    mul(vm1   , am1   , k1 , bm1, k1 , next, th);
+    mul(v2    , ap2   , k1 , bp2, k1 , next, th);
+    mul(r     , a     , k  , b  , k  , next, th); // c0
+    mul(r+4u*k, a+3u*k, n3a, b+k, n1b, next, th); // c4
+
+    details::toomInterpolate5(r, an+bn, k, v1, vm1, v2, negA!=negB, L, n4);
+}
+
+//----------------------------------------------------------------------------
+inline
+std::size_t mulScratchSize(std::size_t an, std::size_t bn, const mul_thresholds &th)
+{
+    if (an<bn)
+        std::swap(an, bn);
+
+    if (bn<th.karatsuba)
+        return 0;
+
+    auto sizeFn = [&th](std::size_t xn, std::size_t yn) { return mulScratchSize(xn, yn, th); };
+
+    if (details::useToom42(an, bn, th))
+        return toom42ScratchSize(an, bn, th);
+
+    if (details::useToom32(an, bn, th))
+        return toom32ScratchSize(an, bn, th);
+
+    if (bn<=(an+1u)/2u)
+        return details::mulChunkedScratchSize(an, bn, sizeFn);
+
+    if (bn>=th.toom4 && details::toom4Fits(an, bn))
+        return toom4ScratchSize(an, bn, th);
+
+    if (bn>=th.toom3 && details::toom3Fits(an, bn))
+        return toom3ScratchSize(an, bn, th);
+
+    return details::karatsubaStepScratchSize(an, bn, sizeFn);
+}
+
+//----------------------------------------------------------------------------
+template<typename T>
+inline
+void mul(T *r, const T *a, std::size_t an, const T *b, std::size_t bn, T *scratch, const mul_thresholds &th)
+{
+    if (an<bn)
+    {
+        std::swap(a , b );
+        std::swap(an, bn);
+    }
+
+    if (a==b && an==bn)
+    {
+        sqr(r, a, an, scratch, th);
+        return;
+    }
+
+    if (bn<th.karatsuba)
+    {
+        details::mul_small(r, a, an, b, bn);
+        return;
+    }
+
+    auto mulFn = [&th](T *r_, const T *a_, std::size_t an_, const T *b_, std::size_t bn_, T *scratch_)
+    {
+        mul(r_, a_, an_, b_, bn_, scratch_, th);
+    };
+
+    if (details::useToom42(an, bn, th))
+        mul_toom42(r, a, an, b, bn, scratch, th);
+    else if (details::useToom32(an, bn, th))
+        mul_toom32(r, a, an, b, bn, scratch, th);
+    else if (bn<=(an+1u)/2u)
+        details::mulChunked(r, a, an, b, bn, scratch, mulFn);
+    else if (bn>=th.toom4 && details::toom4Fits(an, bn))
+        mul_toom4(r, a, an, b, bn, scratch, th);
+    else if (bn>=th.toom3 && details::toom3Fits(an, bn))
+        mul_toom3(r, a, an, b, bn, scratch, th);
+    else
+        details::karatsubaStep(r, a, an, b, bn, scratch, mulFn);
+}
+
+//----------------------------------------------------------------------------
+//! Размер scratch (в чанках) для sqr, не больше mulScratchSize(n, n, th)
+inline
+std::size_t sqrScratchSize(std::size_t n, const mul_thresholds &th)
+{
+    if (n<th.sqrKaratsuba)
+        return 0;
+
+    if (n>=th.toom4 && details::toom4Fits(n, n))
+        return toom4ScratchSize(n, n, th);
+
+    if (n>=th.toom3 && details::toom3Fits(n, n))
+        return toom3ScratchSize(n, n, th);
+
+    return details::sqrKaratsubaStepScratchSize(n, [&th](std::size_t xn) { return sqrScratchSize(xn, th); });
+}
+
+//----------------------------------------------------------------------------
+//! r = a^2, n>=1, r - 2n чанков и не пересекается с a. Алгоритм - по размеру, как в mul,
+//! но на всех уровнях рекурсии - квадраты. scratch - не меньше sqrScratchSize(n, th) чанков
+template<typename T>
+inline
+void sqr(T *r, const T *a, std::size_t n, T *scratch, const mul_thresholds &th)
+{
+    if (n<th.sqrKaratsuba)
+        sqr_basecase(r, a, n);
+    else if (n>=th.toom4 && details::toom4Fits(n, n))
+        mul_toom4(r, a, n, a, n, scratch, th);
+    else if (n>=th.toom3 && details::toom3Fits(n, n))
+        mul_toom3(r, a, n, a, n, scratch, th);
+    else
+        details::sqrKaratsubaStep(r, a, n, scratch, [&th](T *r_, const T *a_, std::size_t n_, T *scratch_) { sqr(r_, a_, n_, scratch_, th); });
+}
+
+//----------------------------------------------------------------------------
+//! Размер scratch (в чанках) для mul_parallel. У каждой параллельной ветки своя область,
+//! так что больше, чем mulScratchSize
+inline
+std::size_t parallelMulScratchSize(std::size_t an, std::size_t bn, const mul_thresholds &th = mul_thresholds().normalized())
+{
+    if (an<bn)
+        std::swap(an, bn);
+
+    if (bn<th.parallel)
+        return mulScratchSize(an, bn, th);
+
+    if (!details::toom3Fits(an, bn))
+    {
+        const std::size_t h = (an+1u)/2u;
+        return (an-h+bn) + parallelMulScratchSize(h, bn, th) + parallelMulScratchSize(an-h, bn, th);
+    }
+
+    const std::size_t k  = (an+2u)/3u;
+    const std::size_t k1 = k+1u;
+    return 3u*(2u*k1) + 6u*k1 + 4u*parallelMulScratchSize(k1, k1, th) + parallelMulScratchSize(an-2u*k, bn-2u*k, th);
+}
+
+//----------------------------------------------------------------------------
+//! r = a * b, как mul, но верхние уровни рекурсии (пока меньший множитель не короче th.parallel)
+//! идут через invoke: пять произведений шага Тоома-3 или, для сильно несбалансированных
+//! множителей, две половины длинного - независимые задачи. Ниже порога - обычный mul.
+//! Если a и b - один и тот же массив, на всех уровнях - квадраты.
+//! scratch - не меньше parallelMulScratchSize(an, bn, th) чанков, других аллокаций нет
+template<typename T, typename Invoke>
+inline
+void mul_parallel(T *r, const T *a, std::size_t an, const T *b, std::size_t bn, T *scratch, const mul_thresholds &th, const Invoke &invoke)
+{
+    if (an<bn)
+    {
+        std::swap(a , b );
+        std::swap(an, bn);
+    }
+
+    if (bn<th.parallel || !invoke.parallel())
+    {
+        mul(r, a, an, b, bn, scratch, th);
+        return;
+    }
+
+    if (!details::toom3Fits(an, bn))
+    {
+        // a = a1*B^h + a0: a0*b - сразу в r, a1*b - рядом, потом складываем
+        const std::size_t h  = (an+1u)/2u;
+        const std::size_t tn = an-h+bn;
+
+        T *t  = scratch;
+        T *s0 = t  + tn;
+        T *s1 = s0 + parallelMulScratchSize(h, bn, th);
+
+        invoke( [&]() { mul_parallel(r, a  , h   , b, bn, s0, th, invoke); }
+              , [&]() { mul_parallel(t, a+h, an-h, b, bn, s1, th, invoke); }
+              );
+
+        for(std::size_t i=h+bn; i!=an+bn; ++i)
+            r[i] = 0;
+        details::addAt(r, an+bn, h, t, tn);
+        return;
+    }
+
+    // Шаг Тоома-3, как в mul_toom3
+    const std::size_t k   = (an+2u)/3u;
+    const std::size_t k1  = k+1u;
+    const std::size_t n2a = an-2u*k;
+    const std::size_t n2b = bn-2u*k;
+    const std::size_t L   = 2u*k1;
+
+    T *v1   = scratch;
+    T *vm1  = v1  + L;
+    T *v2   = vm1 + L;
+    T *ap1  = v2  + L;
+    T *am1  = ap1 + k1;
+    T *ap2  = am1 + k1;
+    T *bp1  = ap2 + k1;
+    T *bm1  = bp1 + k1;
+    T *bp2  = bm1 + k1;
+    T *next = bp2 + k1;
+
+    const std::size_t sk = parallelMulScratchSize(k1, k1, th);
+
+    const bool square = (a==b && an==bn);
+    const bool negA   = details::toom3Eval(ap1, am1, ap2, a, k, n2a);
+    const bool negB   = square ? negA : details::toom3Eval(bp1, bm1, bp2, b, k, n2b);
+    if (square)
+    {
+        bp1 = ap1;
+        bm1 = am1;
+        bp2 = ap2;
+    }
+
+    invoke( [&]() { mul_parallel(v1    , ap1   , k1 , bp1   , k1 , next     , th, invoke); }
+          , [&]() { mul_parallel(vm1   , am1   , k1 , bm1   , k1 , next+   sk, th, invoke); }
+          , [&]() { mul_parallel(v2    , ap2   , k1 , bp2   , k1 , next+2u*sk, th, invoke); }
+          , [&]() { mul_parallel(r     , a     , k  , b     , k  , next+3u*sk, th, invoke); } // c0
+          , [&]() { mul_parallel(r+4u*k, a+2u*k, n2a, b+2u*k, n2b, next+4u*sk, th, invoke); } // c4
+          );
+
+    details::toomInterpolate5(r, an+bn, k, v1, vm1, v2, negA!=negB, L, n2a+n2b);
+}
+
+//----------------------------------------------------------------------------
+
+} // namespace bigint_limbs
+} // namespace marty
+
+// marty::bigint_limbs::
+// #include "marty_bigint/limbs.h"
+
@@ -7,6 +7,11 @@
 
 #include "types.h"
 #include "utils.h"
+#include "limbs.h"
+#include "ntt.h"
+#include "fft.h"
+#include "scratch.h"
+#include "thread_pool.h"
 
 #if defined(__GNUC__) && (__GNUC__ < 11)
 
@@ -60,16 +65,132 @@ public: // types
         auto_ = 0,
         school,
         karatsuba,
-        furer
+        comba,          // умножение по столбцам (product scanning)
+        furer = comba,  // старое название того же метода, оставлено для совместимости
+        toom3,          // Тоом-Кук 3, точки 0, 1, -1, 2, inf
+        toom4,          // Тоом-Кук 4, точки 0, 1, -1, 2, -2, 1/2, inf
+        ntt,            // NTT по трём простым модулям + КТО, для огромных чисел
+        fft             // комплексное FFT в double; где точность не гарантирована - NTT
+    };
+
+    enum PowModMethod
+    {
+        slidingWindow = 0, // скользящее окно, размер - по длине степени
+        fixedWindow        // фиксированное окно: одна и та же последовательность операций для любой степени, для нечётного модуля - ещё и ядра без ветвлений по значениям
     };
 
     using chunk_type      = marty::bigint_details::unsigned_t;
+    using allocator_type  = marty::bigint_details::number_allocator_t;
+
+    // Рабочая область для временных значений умножения/деления, по умолчанию - своя у каждого потока
+    using scratch_workspace = marty::bigint_details::scratch_workspace;
+
+#if defined(MARTY_BIGINT_USE_PMR) && MARTY_BIGINT_USE_PMR!=0
+
+    // Пока жив объект, все новые BigInt в текущем потоке аллоцируются через заданный memory_resource
+    using memory_resource_scope = marty::bigint_details::memory_resource_scope;
+
+#endif
+
+    //! Пороги переключения алгоритмов (в чанках меньшего множителя), см. defs.h и tests/tune-thresholds
+    using mul_thresholds = marty::bigint_limbs::mul_thresholds;
+
+    //! Пул потоков для многопоточного умножения очень больших чисел (arithmetic_context::setThreadPool)
+    using thread_pool = marty::bigint_details::thread_pool;
+
+    //! Настройки арифметики: метод умножения, пороги алгоритмов и рабочая область
+    //! для временных значений. У каждого потока свой контекст (threadContext()), так что
+    //! потоки настраиваются независимо и не мешают друг другу. Свой контекст можно сделать
+    //! текущим для потока через arithmetic_context_scope или передать в операцию явно
+    //! (mul(b, ctx), sqr(ctx), div(b, ctx), rem(b, ctx)).
+    //! Контекст со своей рабочей областью (setWorkspace) можно использовать только из одного
+    //! потока за раз; без неё каждый поток берёт свою scratch_workspace::threadLocal().
+    //! Если задан пул потоков (setThreadPool), умножения от mul_thresholds::parallel чанков
+    //! раскидываются по его потокам
+    class arithmetic_context
+    {
+        MultiplicationMethod  m_multiplicationMethod = MultiplicationMethod::auto_;
+        mul_thresholds        m_mulThresholds        = mul_thresholds().normalized();
+        scratch_workspace    *m_pWorkspace           = nullptr;
+        thread_pool          *m_pThreadPool          = nullptr;
+
+    public:
+
+        arithmetic_context() {}
+
+        explicit arithmetic_context(MultiplicationMethod mm, const mul_thresholds &th = mul_thresholds(), scratch_workspace *pWorkspace = nullptr)
+        : m_multiplicationMethod(mm)
+        , m_mulThresholds(th.normalized())
+        , m_pWorkspace(pWorkspace)
+        {}
+
+        MultiplicationMethod getMultiplicationMethod() const { return m_multiplicationMethod; }
+
+        //! Возвращает прежний метод
+        MultiplicationMethod setMultiplicationMethod(MultiplicationMethod mm)
+        {
+            std::swap(mm, m_multiplicationMethod);
+            return mm;
+        }
+
+        const mul_thresholds& getMulThresholds() const { return m_mulThresholds; }
+
+        //! Возвращает прежние пороги
+        mul_thresholds setMulThresholds(const mul_thresholds &th)
+        {
+            mul_thresholds tmp = th.normalized();
+            std::swap(tmp, m_mulThresholds);
+            return tmp;
+        }
+
+        //! Рабочая область контекста, если не задана - рабочая область текущего потока
+        scratch_workspace& getWorkspace() const
+        {
+            return m_pWorkspace ? *m_pWorkspace : scratch_workspace::threadLocal();
+        }
+
+        //! nullptr - рабочая область текущего потока. Рабочая область не копируется и не
+        //! принадлежит контексту, должна жить дольше него
+        void setWorkspace(scratch_workspace *pWorkspace) { m_pWorkspace = pWorkspace; }
+
+        //! nullptr - всё в вызывающем потоке
+        thread_pool* getThreadPool() const { return m_pThreadPool; }
+
+        //! nullptr - многопоточного умножения нет. Пул не принадлежит контексту, должен жить
+        //! дольше него. Один пул можно отдавать нескольким контекстам и потокам
+        void setThreadPool(thread_pool *pPool) { m_pThreadPool = pPool; }
+
+    }; // class arithmetic_context
+
+    //! Пока жив объект, текущий контекст потока - заданный (см. currentContext())
+    class arithmetic_context_scope
+    {
+        arithmetic_context *m_pPrev = nullptr;
+
+    public:
+
+        explicit arithmetic_context_scope(arithmetic_context &ctx)
+        : m_pPrev(currentContextRef())
+        {
+            currentContextRef() = &ctx;
+        }
+
+        ~arithmetic_context_scope()
+        {
+            currentContextRef() = m_pPrev;
+        }
+
+        arithmetic_context_scope(const arithmetic_context_scope&) = delete;
+        arithmetic_context_scope& operator=(const arithmetic_context_scope&) = delete;
+
+    }; // class arithmetic_context_scope
 
 protected: // member fields
 
     using unsigned_t      = marty::bigint_details::unsigned_t;
     using unsigned2_t     = marty::bigint_details::unsigned2_t;
     using number_holder_t = marty::bigint_details::number_holder_t;
+    using scratch_holder  = marty::bigint_details::scratch_holder;
 
     constexpr const static inline std::size_t chunkSize  = sizeof(unsigned_t);
     constexpr const static inline int         iChunkSize = int(chunkSize);
@@ -80,28 +201,56 @@ protected: // member fields
     number_holder_t       m_module;
     int                   m_sign = 0;
 
-    static inline MultiplicationMethod s_multiplicationMethod = MultiplicationMethod::auto_;
-    // static inline MultiplicationMethod s_multiplicationMethod = MultiplicationMethod::school;
-    // static inline MultiplicationMethod s_multiplicationMethod = MultiplicationMethod::karatsuba;
-    // static inline MultiplicationMethod s_multiplicationMethod = MultiplicationMethod::furer;
+    // Контекст, заданный через arithmetic_context_scope, nullptr - контекст потока
+    static arithmetic_context*& currentContextRef()
+    {
+        static thread_local arithmetic_context *pCtx = nullptr;
+        return pCtx;
+    }
 
 
 public: // static methods
 
+    //! Собственный контекст текущего потока
+    static arithmetic_context& threadContext()
+    {
+        static thread_local arithmetic_context ctx;
+        return ctx;
+    }
+
+    //! Текущий контекст потока - заданный через arithmetic_context_scope, или threadContext()
+    static arithmetic_context& currentContext()
+    {
+        arithmetic_context *pCtx = currentContextRef();
+        return pCtx ? *pCtx : threadContext();
+    }
+
+    //! Метод умножения текущего контекста потока (см. arithmetic_context), возвращает прежний.
+    //! Другие потоки не затрагивает
     static MultiplicationMethod setMultiplicationMethod(MultiplicationMethod mm)
     {
-        std::swap(mm, s_multiplicationMethod);
-        return mm;
+        return currentContext().setMultiplicationMethod(mm);
     }
 
     static MultiplicationMethod getMultiplicationMethod()
     {
-        return s_multiplicationMethod;
+        return currentContext().getMultiplicationMethod();
     }
 
     static const char* getMultiplicationMethodName();
     static const char* getMultiplicationMethodName(MultiplicationMethod);
 
+    //! Переопределяет пороги текущего контекста потока, возвращает прежние
+    static mul_thresholds setMulThresholds(const mul_thresholds &th)
+    {
+        return currentContext().setMulThresholds(th);
+    }
+
+    static const mul_thresholds& getMulThresholds()
+    {
+        return currentContext().getMulThresholds();
+    }
+
 
 public: // basic ctors & operators
 
@@ -111,6 +260,13 @@ public: // basic ctors & operators
     BigInt(BigInt &&) = default;
     BigInt& operator=(BigInt &&) = default;
 
+    // allocator-extended конструкторы - для stateful аллокаторов (MARTY_BIGINT_USE_PMR)
+    explicit BigInt(const allocator_type &a) : m_module(a) {}
+    BigInt(const BigInt &other, const allocator_type &a) : m_module(other.m_module, a), m_sign(other.m_sign) {}
+    BigInt(BigInt &&other, const allocator_type &a) : m_module(std::move(other.m_module), a), m_sign(other.m_sign) { other.m_sign = 0; }
+
+    allocator_type get_allocator() const { return m_module.get_allocator(); }
+
 
 protected: // from int type construction helpers
 
@@ -318,8 +474,6 @@ protected: // from int type construction helpers
         if (base==0)
             base = 10;
 
-        auto moduleBase = moduleFromUnsigned(unsigned(base));
-
         // Тут мы уже определели базу, если не была задана
         // Осталось только считать число
 
@@ -355,8 +509,13 @@ protected: // from int type construction helpers
             }
 
             // Тут цифру докидываем в число
-            be.m_module = moduleMul(be.m_module, moduleBase);
-            moduleAddInplace(be.m_module, moduleFromUnsigned(unsigned(d)));
+            // module = module*base + d, на месте
+            unsigned_t carry = bigint_limbs::mul_1(be.m_module.data(), be.m_module.data(), be.m_module.size(), unsigned_t(base));
+            if (carry)
+                be.m_module.push_back(carry);
+            carry = bigint_limbs::add_1(be.m_module.data(), be.m_module.data(), be.m_module.size(), unsigned_t(d));
+            if (carry)
+                be.m_module.push_back(carry);
         }
 
         shrinkLeadingZeros(be.m_module);
@@ -473,84 +632,65 @@ protected: // operations implementation helpers
 
     // в данном случае - реверсивные значения, сравнение идёт со старших разрядов, от хвоста,
     // beginIdxM1 >= endIdxM1
-    static int moduleCompare(const number_holder_t &m1, number_holder_t m2, std::size_t beginIdxM1=std::size_t(-1), std::size_t endIdxM1=std::size_t(-1));
+    static int moduleCompare(const number_holder_t &m1, const number_holder_t &m2, std::size_t beginIdxM1=std::size_t(-1), std::size_t endIdxM1=std::size_t(-1));
     static bool moduleIsZero(const number_holder_t &m);
 
     static number_holder_t moduleAdd(const number_holder_t &m1, const number_holder_t &m2);
-    static void moduleAddInplace(number_holder_t &m1, const number_holder_t &m2, std::size_t b=std::size_t(-1), std::size_t e=std::size_t(-1)); // adds m2 to m1
+    static void moduleAddInplace(number_holder_t &m1, const number_holder_t &m2, std::size_t b=std::size_t(-1)); // adds m2 to m1 (starting from chunk b)
     static void moduleExpandTo(number_holder_t &m, std::size_t size, unsigned_t v); // aka resize, with v
     static void moduleFill(number_holder_t &m, unsigned_t v, std::size_t b=std::size_t(-1), std::size_t e=std::size_t(-1)); // fill vector with v
 
     // m1 - уменьшаемое
     // m2 - вычитаемое
     // уменьшаемое должно быть больше или равно вычитаемому
-    static number_holder_t moduleSub(const number_holder_t& m1, number_holder_t m2);
+    static number_holder_t moduleSub(const number_holder_t& m1, const number_holder_t &m2);
     // Вычитаем m2 только из части разрядов модуля m1 - требуется для деления
-    static void moduleSubInplace(number_holder_t& m1, number_holder_t m2, std::size_t beginIdxM1=std::size_t(-1), std::size_t endIdxM1=std::size_t(-1));
-
+    static void moduleSubInplace(number_holder_t& m1, const number_holder_t &m2, std::size_t beginIdxM1=std::size_t(-1), std::size_t endIdxM1=std::size_t(-1));
 
-    // Сдвиг влево увеличивает число
-    // Для сдвига влево нам надо вставить нулевой элемент в начало
-    // Выдвигаемый бит(биты) надо взять со старших позиций
-    // и переместить их на младшие разряды
-
-    template<std::size_t size>
-    static void moduleShiftLeftHelper(number_holder_t &m)
-    {
-        unsigned_t tmp = 0;
-        for(auto &v : m)
-        {
-            unsigned_t newTmp = unsigned_t(bigint_utils::shiftBitsToLow<size, unsigned_t>(v) & bigint_utils::makeLowBitsMask<size, unsigned_t>());
-            v <<= size;
-            v |= tmp;
-            tmp = newTmp;
-        }
-
-        if (tmp)
-            m.push_back(tmp);
-
-        // shrinkLeadingZeros(); // так как мы не отбрасываем биты, 
-        // а расширяем размер числа (если появился сдвиг в новые разряды), 
-        // то нет нужды проверять наличие ведущих нулей
-    }
-
-    // Сдвиг вправо уменьшает число
-    template<std::size_t size>
-    static void moduleShiftRightHelper(number_holder_t &m)
-    {
-        unsigned_t tmp = 0;
-
-        for (std::size_t i=m.size(); i-->0;)
-        {
-            auto &v = m[i];
-            // Сначала применяем маску к младшим разрядам, потом перемещаем биты на старшие позиции
-            unsigned_t newTmp = bigint_utils::shiftBitsToHigh<size, unsigned_t>(unsigned_t(v & bigint_utils::makeLowBitsMask<size, unsigned_t>()));
-            v >>= size;
-            v |= tmp;
-            tmp = newTmp;
-        }
-
-        // а вот тут мы ничего не делаем, биты выдвигаемые с младших разрядов, просто теряются
-        shrinkLeadingZeros(m);
-
-    }
 
+    // Сдвиги - через bigint_limbs::lshift/rshift, сразу на любое число бит
     static void moduleShiftLeft(number_holder_t &m, int v);
     static void moduleShiftRight(number_holder_t &m, int v);
     static number_holder_t moduleShiftLeftCopy(const number_holder_t &m, int v);
     static number_holder_t moduleShiftRightCopy(const number_holder_t &m, int v);
 
-    static number_holder_t moduleFurerMul(const number_holder_t &m1, const number_holder_t &m2);
-    static number_holder_t moduleKaratsubaMul(const number_holder_t &m1, const number_holder_t &m2);
+    // Умножение модуля на один чанк, результат в res (ёмкость res переиспользуется)
+    static void moduleMulChunkTo(number_holder_t &res, const number_holder_t &m, unsigned_t v);
+
+    // Временные значения алгоритмов берутся из рабочей области ws (или рабочей области контекста),
+    // пороги и метод - из контекста ctx
+    // Пул потоков контекста, если он есть и умножение (size - чанков меньшего множителя)
+    // достаточно большое, чтобы его дробить. Иначе nullptr
+    static thread_pool* moduleThreadPool(const arithmetic_context &ctx, std::size_t size);
+    static number_holder_t moduleCombaMul(const number_holder_t &m1, const number_holder_t &m2);
+    static number_holder_t moduleKaratsubaMul(const number_holder_t &m1, const number_holder_t &m2, const arithmetic_context &ctx=currentContext());
+    static void moduleKaratsubaMulTo(number_holder_t &res, const number_holder_t &m1, const number_holder_t &m2, const arithmetic_context &ctx);
+    static number_holder_t moduleToom3Mul(const number_holder_t &m1, const number_holder_t &m2, const arithmetic_context &ctx=currentContext());
+    static number_holder_t moduleToom4Mul(const number_holder_t &m1, const number_holder_t &m2, const arithmetic_context &ctx=currentContext());
+    static number_holder_t moduleNttMul(const number_holder_t &m1, const number_holder_t &m2, const arithmetic_context &ctx=currentContext());
+    static number_holder_t moduleFftMul(const number_holder_t &m1, const number_holder_t &m2, const arithmetic_context &ctx=currentContext());
+    static number_holder_t moduleChunkedFftMul(const number_holder_t &m1, const number_holder_t &m2, const arithmetic_context &ctx=currentContext());
+    // Квадраты. Ядра Карацубы, Тоома, NTT и FFT сами видят одинаковые множители (один и тот же
+    // массив) и считают квадрат, так что moduleMul(m, m) - тоже квадрат
+    static number_holder_t moduleBasecaseSqr(const number_holder_t &m);
+    static number_holder_t moduleAutoSqr(const number_holder_t &m, const arithmetic_context &ctx=currentContext());
+    static number_holder_t moduleSqr(const number_holder_t &m, const arithmetic_context &ctx=currentContext());
+    // Умножение ядром bigint_limbs, которому нужна непрерывная рабочая область:
+    // mulFn(r, a, an, b, bn, scratch), scratchSizeFn(an, bn) - её размер в чанках
+    template<typename MulFn, typename ScratchSizeFn>
+    static void moduleScratchMulTo(number_holder_t &res, const number_holder_t &m1, const number_holder_t &m2, scratch_workspace &ws, MulFn mulFn, ScratchSizeFn scratchSizeFn);
     static number_holder_t moduleSchoolMul(const number_holder_t &m1, const number_holder_t &m2);
-    static number_holder_t moduleAutoMul(const number_holder_t &m1, const number_holder_t &m2);
-    static number_holder_t moduleMul(const number_holder_t &m1, const number_holder_t &m2);
-
-    // Делит m1 на m2, остаток от деления остаётся в m1
-    static number_holder_t moduleSchoolDiv(number_holder_t &m1, number_holder_t m2);
-    static number_holder_t moduleDiv(number_holder_t &m1, number_holder_t m2) { return moduleSchoolDiv(m1, m2); }
-    BigInt& divImpl(const BigInt &b); // Делит текущий объект на b
-    BigInt& remImpl(const BigInt &b); // получает остаток от деления в текущем объекте (всегда положительный)
+    static void moduleSchoolMulTo(number_holder_t &res, const number_holder_t &m1, const number_holder_t &m2);
+    static number_holder_t moduleAutoMul(const number_holder_t &m1, const number_holder_t &m2, const arithmetic_context &ctx=currentContext());
+    static number_holder_t moduleMul(const number_holder_t &m1, const number_holder_t &m2, const arithmetic_context &ctx=currentContext());
+
+    // Делит m1 на m2, остаток от деления остаётся в m1. Варианты ...To пишут частное в q
+    static void moduleSchoolDivTo(number_holder_t &q, number_holder_t &m1, const number_holder_t &m2, scratch_workspace &ws=scratch_workspace::threadLocal());
+    static number_holder_t moduleSchoolDiv(number_holder_t &m1, const number_holder_t &m2, scratch_workspace &ws=scratch_workspace::threadLocal());
+    static void moduleDivTo(number_holder_t &q, number_holder_t &m1, const number_holder_t &m2, const arithmetic_context &ctx=currentContext()) { moduleSchoolDivTo(q, m1, m2, ctx.getWorkspace()); }
+    static number_holder_t moduleDiv(number_holder_t &m1, const number_holder_t &m2, const arithmetic_context &ctx=currentContext()) { return moduleSchoolDiv(m1, m2, ctx.getWorkspace()); }
+    BigInt& divImpl(const BigInt &b, const arithmetic_context &ctx=currentContext()); // Делит текущий объект на b
+    BigInt& remImpl(const BigInt &b, const arithmetic_context &ctx=currentContext()); // получает остаток от деления в текущем объекте (всегда положительный)
     //static bool moduleIsZero(const number_holder_t &m);
 
 
@@ -600,7 +740,14 @@ protected: // operations implementation helpers
     int compareImpl(int signOther, const number_holder_t &moduleOther) const;
     int compareImpl(const BigInt& b) const { return compareImpl(b.m_sign, b.m_module); }
 
-    BigInt& mulImpl(const BigInt &b);
+    BigInt& mulImpl(const BigInt &b, const arithmetic_context &ctx=currentContext());
+    BigInt& sqrImpl(const arithmetic_context &ctx=currentContext());
+    BigInt& powImpl(unsigned exp, const arithmetic_context &ctx=currentContext());
+
+    // *this += signMul*a*b (signMul - 1 или -1), см. addmul/submul
+    BigInt& addmulImpl(int signMul, const BigInt &a, const BigInt &b, const arithmetic_context &ctx=currentContext());
+    // *this += signOther*moduleOther на месте, в своём буфере, без нового модуля
+    BigInt& addInplaceImpl(int signOther, const number_holder_t &moduleOther);
 
     BigInt& incImpl();
     BigInt& decImpl();
@@ -659,6 +806,27 @@ public: // misc methods
         return m_sign;
     }
 
+    // Чанки модуля, младшие - первые. Для своих алгоритмов поверх bigint_limbs::
+    const chunk_type* chunksData() const { return m_module.data(); }
+    std::size_t chunksSize() const { return m_module.size(); }
+
+    // Обратно - из массива чанков (ведущие нули допускаются)
+    static BigInt fromChunks(int sign, const chunk_type *pChunks, std::size_t nChunks)
+    {
+        BigInt res;
+        res.assignChunks(sign, pChunks, nChunks);
+        return res;
+    }
+
+    // То же на место, с сохранением ёмкости: если её хватает - без аллокации
+    BigInt& assignChunks(int sign, const chunk_type *pChunks, std::size_t nChunks)
+    {
+        m_module.assign(pChunks, pChunks+nChunks);
+        m_sign = sign<0 ? -1 : 1;
+        shrinkLeadingZeros();
+        return *this;
+    }
+
 
 protected: // to integral type convertion helpers
 
@@ -908,6 +1076,53 @@ public: // arithmetic operators '+', '-', '/', '*', ++, --
     BigInt& operator/=(const BigInt &b)       { return divImpl(b); }
     BigInt& operator%=(const BigInt &b)       { return remImpl(b); }
 
+    BigInt sqr() const                        { BigInt res = *this; return res.sqrImpl(); } // квадрат, быстрее a*a общего вида
+
+    // То же с явно заданным контекстом (метод умножения, пороги, рабочая область) вместо текущего
+    BigInt mul(const BigInt &b, const arithmetic_context &ctx) const { BigInt res = *this; return res.mulImpl(b, ctx); }
+    BigInt div(const BigInt &b, const arithmetic_context &ctx) const { BigInt res = *this; return res.divImpl(b, ctx); }
+    BigInt rem(const BigInt &b, const arithmetic_context &ctx) const { BigInt res = *this; return res.remImpl(b, ctx); }
+
+    // Частное и остаток за одно деление: {a/b, a%b}, как у операторов '/' и '%' (частное
+    // округляется к нулю, знак остатка - как у a)
+    static std::pair<BigInt, BigInt> divMod(const BigInt &a, const BigInt &b, const arithmetic_context &ctx=currentContext())
+    {
+        std::pair<BigInt, BigInt> res;
+        divMod(a, b, res.first, res.second, ctx);
+        return res;
+    }
+
+    // То же в готовые объекты, их буферы переиспользуются. q и r - разные объекты, но каждый
+    // может быть a или b
+    static void divMod(const BigInt &a, const BigInt &b, BigInt &q, BigInt &r, const arithmetic_context &ctx=currentContext());
+    BigInt sqr(const arithmetic_context &ctx) const                  { BigInt res = *this; return res.sqrImpl(ctx); }
+
+    // Степень: бинарное возведение слева направо на квадратах, множители 2 основания - одним
+    // сдвигом в конце. С методом auto_ и ниже порогов FFT/NTT/пула потоков квадраты и умножения
+    // идут в два заранее выделенных буфера без аллокаций; иначе каждый шаг - moduleSqr/moduleMul
+    // с новым модулем
+    BigInt pow(unsigned exp) const                                   { BigInt res = *this; return res.powImpl(exp); }
+    BigInt pow(unsigned exp, const arithmetic_context &ctx) const    { BigInt res = *this; return res.powImpl(exp, ctx); }
+
+    // *this += a*b и *this -= a*b без временного BigInt под произведение. Если один из
+    // множителей короче порога Карацубы (в том числе один чанк) - накопление прямо в чанки *this,
+    // иначе произведение считается выбранным методом и прибавляется на месте
+    BigInt& addmul(const BigInt &a, const BigInt &b, const arithmetic_context &ctx=currentContext()) { return addmulImpl( 1, a, b, ctx); }
+    BigInt& submul(const BigInt &a, const BigInt &b, const arithmetic_context &ctx=currentContext()) { return addmulImpl(-1, a, b, ctx); }
+
+    template < typename T, std::enable_if_t< std::is_integral_v<T>, int> = 0 >
+    BigInt& addmul(const BigInt &a, T t) { return addmul(a, BigInt(t)); }
+
+    template < typename T, std::enable_if_t< std::is_integral_v<T>, int> = 0 >
+    BigInt& submul(const BigInt &a, T t) { return submul(a, BigInt(t)); }
+
+    // base^exp mod m, exp>=0, m>0, результат в [0, m). По нечётному модулю - в форме Монтгомери
+    // (MontgomeryContext), по чётному - с редукцией Барретта (BarrettReducer), без деления.
+    // fixedWindow по нечётному модулю не зависит по времени от битов степени; по чётному
+    // фиксированы только последовательность операций и выбор из таблицы.
+    // Реализация - в impl/powmod.h
+    static BigInt powMod(const BigInt &base, const BigInt &exp, const BigInt &mod, PowModMethod pm=PowModMethod::slidingWindow);
+
 
     BigInt& operator++()    { incImpl(); return *this; } // увеличивает, и возвращает уменьшенное
     BigInt& operator--()    { decImpl(); return *this; } // уменьшает, и возвращает уменьшенное
@@ -994,6 +1209,16 @@ public: // bit ops
 }; // class BigInt
 
 //----------------------------------------------------------------------------
+//! a*b + c, произведение накапливается сразу в копию c (BigInt::addmul)
+inline
+BigInt fma(const BigInt &a, const BigInt &b, const BigInt &c)
+{
+    BigInt res = c;
+    res.addmul(a, b);
+    return res;
+}
+
+//----------------------------------------------------------------------------
 
 
 
@@ -1005,6 +1230,9 @@ public: // bit ops
 
 //----------------------------------------------------------------------------
 #include "impl/marty_bigint.h"
+#include "montgomery.h"
+#include "barrett.h"
+#include "impl/powmod.h"
 
 //----------------------------------------------------------------------------
 
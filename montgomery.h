@@ -0,0 +1,227 @@
+/*!
+    \file
+    \brief Контекст умножения Монтгомери для многократной модульной арифметики над marty::BigInt
+ */
+#pragma once
+
+#include "marty_bigint.h"
+
+//
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <stdexcept>
+
+//
+#include "undef_min_max.h"
+
+
+// #include "marty_bigint/montgomery.h"
+// marty::
+namespace marty {
+
+
+//----------------------------------------------------------------------------
+//! Модульное умножение по фиксированному нечётному модулю m без деления.
+//! Значения хранятся в форме Монтгомери x*R mod m (R = B^n, n - число чанков модуля):
+//! toMont переводит в неё, fromMont - обратно, mul/sqr работают только в ней. R^2 mod m
+//! и -m^-1 mod B считаются один раз в конструкторе.
+//! Аргументы mul/sqr/fromMont - неотрицательные и меньше модуля (то, что вернул сам контекст),
+//! знак не учитывается. Версии с результатом в r не аллоцируют, если ёмкости r хватает;
+//! временные значения - в рабочей области текущего контекста арифметики. Сам контекст после
+//! создания не меняется, так что один объект можно использовать из разных потоков
+class MontgomeryContext
+{
+    using chunk_type      = BigInt::chunk_type;
+    using number_holder_t = bigint_details::number_holder_t;
+
+    BigInt                   m_modulus;
+    BigInt                   m_one;       // R mod m - единица в форме Монтгомери
+    number_holder_t          m_m;         // модуль, n чанков
+    number_holder_t          m_r2;        // R^2 mod m, n чанков
+    chunk_type               m_mInv = 0;  // -m^-1 mod B
+
+public:
+
+    explicit MontgomeryContext(const BigInt &modulus)
+    : m_modulus(modulus)
+    {
+        if (modulus.sign()<=0 || !(modulus.getLowChunk()&1u))
+            throw std::invalid_argument("MontgomeryContext: modulus must be odd and positive");
+
+        m_m.assign(modulus.chunksData(), modulus.chunksData()+modulus.chunksSize());
+        m_mInv = bigint_limbs::montInverse(m_m[0]);
+
+        const int rBits = int(m_m.size()*sizeof(chunk_type)*CHAR_BIT);
+        const BigInt r2 = (BigInt(1)<<(2*rBits)) % modulus;
+        m_r2.assign(m_m.size(), chunk_type(0));
+        std::copy(r2.chunksData(), r2.chunksData()+r2.chunksSize(), m_r2.begin());
+
+        m_one = (BigInt(1)<<rBits) % modulus;
+    }
+
+    const BigInt& modulus() const { return m_modulus; }
+
+    //! Размер модуля в чанках
+    std::size_t size() const { return m_m.size(); }
+
+    //! Единица в форме Монтгомери
+    const BigInt& one() const { return m_one; }
+
+    //! a*R mod m, a - любое (в том числе отрицательное или больше модуля)
+    BigInt toMont(const BigInt &a) const
+    {
+        BigInt x = a % m_modulus;
+        if (x.sign()<0)
+            x += m_modulus;
+
+        const BigInt r2 = BigInt::fromChunks(1, m_r2.data(), m_r2.size());
+        mul(x, x, r2);
+        return x;
+    }
+
+    //! a/R mod m - обратно из формы Монтгомери
+    BigInt fromMont(const BigInt &a) const
+    {
+        BigInt res;
+        fromMont(res, a);
+        return res;
+    }
+
+    void fromMont(BigInt &r, const BigInt &a) const
+    {
+        const std::size_t n = m_m.size();
+        checkSize(a);
+
+        bigint_details::scratch_holder t(BigInt::currentContext().getWorkspace(), 2u*n);
+        t->assign(2u*n, chunk_type(0));
+        std::copy(a.chunksData(), a.chunksData()+a.chunksSize(), t->begin());
+
+        bigint_limbs::redc(t->data(), t->data(), m_m.data(), n, m_mInv);
+        r.assignChunks(1, t->data(), n);
+    }
+
+    //! a*b/R mod m
+    BigInt mul(const BigInt &a, const BigInt &b) const
+    {
+        BigInt res;
+        mul(res, a, b);
+        return res;
+    }
+
+    //! r = a*b/R mod m, r может быть a или b
+    void mul(BigInt &r, const BigInt &a, const BigInt &b) const
+    {
+        const std::size_t n = m_m.size();
+        checkSize(a);
+        checkSize(b);
+
+        const BigInt::arithmetic_context     &ctx = BigInt::currentContext();
+        const bigint_limbs::mul_thresholds   &th  = ctx.getMulThresholds();
+
+        // Ниже порога Карацубы - чередующийся CIOS, выше - быстрое умножение целиком и REDC
+        const bool        fast        = n>=th.karatsuba;
+        const std::size_t scratchSize = fast ? bigint_limbs::mulScratchSize(n, n, th) : 0u;
+
+        bigint_details::scratch_holder s(ctx.getWorkspace());
+        s->resize(2u*n + 2u*n+1u + scratchSize);
+
+        chunk_type       *pr = s->data();
+        const chunk_type *pa = padded(a, s->data());
+        const chunk_type *pb = padded(b, s->data()+n);
+        chunk_type       *t  = s->data()+2u*n;
+
+        if (fast)
+        {
+            bigint_limbs::mul(t, pa, n, pb, n, t+2u*n+1u, th);
+            bigint_limbs::redc(pr, t, m_m.data(), n, m_mInv);
+        }
+        else
+        {
+            bigint_limbs::mont_mul(pr, pa, pb, m_m.data(), n, m_mInv, t);
+        }
+
+        r.assignChunks(1, pr, n);
+    }
+
+    //! a^2/R mod m
+    BigInt sqr(const BigInt &a) const
+    {
+        BigInt res;
+        sqr(res, a);
+        return res;
+    }
+
+    //! r = a^2/R mod m, r может быть a
+    void sqr(BigInt &r, const BigInt &a) const
+    {
+        const std::size_t n = m_m.size();
+        checkSize(a);
+
+        const BigInt::arithmetic_context     &ctx = BigInt::currentContext();
+        const bigint_limbs::mul_thresholds   &th  = ctx.getMulThresholds();
+
+        const bool        fast        = n>=th.sqrKaratsuba;
+        const std::size_t scratchSize = fast ? bigint_limbs::sqrScratchSize(n, th) : 0u;
+
+        bigint_details::scratch_holder s(ctx.getWorkspace());
+        s->resize(n + 2u*n + scratchSize);
+
+        chunk_type       *pr = s->data();
+        const chunk_type *pa = padded(a, s->data());
+        chunk_type       *t  = s->data()+n;
+
+        if (fast)
+        {
+            bigint_limbs::sqr(t, pa, n, t+2u*n, th);
+            bigint_limbs::redc(pr, t, m_m.data(), n, m_mInv);
+        }
+        else
+        {
+            bigint_limbs::mont_sqr(pr, pa, m_m.data(), n, m_mInv, t);
+        }
+
+        r.assignChunks(1, pr, n);
+    }
+
+    //! r = a*b/R mod m над буферами ровно по size() чанков (mont_mul_fixed): без ветвлений по
+    //! значениям и без нормализации длины BigInt - для возведения в степень с равномерным
+    //! временем. t - рабочая область из 2*size()+1 чанков, r может совпадать с a или b
+    void mulFixed(chunk_type *r, const chunk_type *a, const chunk_type *b, chunk_type *t) const
+    {
+        bigint_limbs::mont_mul_fixed(r, a, b, m_m.data(), m_m.size(), m_mInv, t);
+    }
+
+protected:
+
+    void checkSize(const BigInt &a) const
+    {
+        if (a.chunksSize()>m_m.size())
+            throw std::invalid_argument("MontgomeryContext: value is not reduced modulo m");
+    }
+
+    // Чанки a, дополненные нулями до размера модуля: если a короче - копия в buf
+    const chunk_type* padded(const BigInt &a, chunk_type *buf) const
+    {
+        const std::size_t n = m_m.size();
+        if (a.chunksSize()==n)
+            return a.chunksData();
+
+        std::copy(a.chunksData(), a.chunksData()+a.chunksSize(), buf);
+        std::fill(buf+a.chunksSize(), buf+n, chunk_type(0));
+        return buf;
+    }
+
+}; // class MontgomeryContext
+
+//----------------------------------------------------------------------------
+
+} // namespace marty
+
+#define MARTY_BIGINT_MONTGOMERY_H
+
+// BigInt::powMod нужны и MontgomeryContext, и BarrettReducer - подключается, когда есть оба
+#include "impl/powmod.h"
+
+// marty::
+// #include "marty_bigint/montgomery.h"
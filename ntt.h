@@ -0,0 +1,453 @@
+/*!
+    \file
+    \brief Умножение чанков через NTT (number-theoretic transform) по трём простым модулям
+ */
+#pragma once
+
+#include "limbs.h"
+
+//
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+//
+#include "undef_min_max.h"
+
+
+// #include "marty_bigint/ntt.h"
+// marty::bigint_limbs::
+namespace marty {
+namespace bigint_limbs {
+
+
+//----------------------------------------------------------------------------
+// Множители режутся на куски (до 32 бит), каждый кусок - коэффициент многочлена.
+// Свёртка коэффициентов считается через NTT по модулю трёх простых p = c*2^k+1,
+// меньших 2^31, и собирается по китайской теореме об остатках (Гарнер).
+// Коэффициент свёртки не больше n*(2^32-1)^2 < 2^88 при n<=2^24, а p1*p2*p3 > 2^89,
+// так что результат точный - никакой плавающей точки и округлений.
+// Длина преобразования ограничена 2^24 (2-адичность 754974721), более длинные
+// множители умножаются блоками.
+
+namespace details {
+
+//----------------------------------------------------------------------------
+template<std::uint32_t P, std::uint32_t G>
+struct ntt_prime
+{
+    static constexpr std::uint32_t mod  = P;
+    static constexpr std::uint32_t root = G; // первообразный корень
+
+    static constexpr std::uint32_t add(std::uint32_t a, std::uint32_t b)
+    {
+        const std::uint32_t s = a+b; // P < 2^31, переполнения нет
+        return s>=P ? s-P : s;
+    }
+
+    static constexpr std::uint32_t sub(std::uint32_t a, std::uint32_t b)
+    {
+        return a>=b ? a-b : a+P-b;
+    }
+
+    // P - константа, компилятор заменяет деление умножением. Только для O(n) частей,
+    // в бабочках - Монтгомери
+    static constexpr std::uint32_t mul(std::uint32_t a, std::uint32_t b)
+    {
+        return std::uint32_t(std::uint64_t(a)*b % P);
+    }
+
+    static constexpr std::uint32_t pow(std::uint32_t a, std::uint64_t e)
+    {
+        std::uint32_t r = 1;
+        for(; e; e>>=1)
+        {
+            if (e&1u)
+                r = mul(r, a);
+            a = mul(a, a);
+        }
+        return r;
+    }
+
+    static constexpr std::uint32_t inv(std::uint32_t a)
+    {
+        return pow(a, P-2u);
+    }
+
+    // Монтгомери, R = 2^32: pinv = -P^-1 mod R, r2 = R^2 mod P
+    static constexpr std::uint32_t makePinv()
+    {
+        std::uint32_t x = P; // P*P == 1 (mod 8), дальше Ньютон
+        for(int i=0; i!=4; ++i)
+            x = std::uint32_t(x*(2u - P*x));
+        return std::uint32_t(0u-x);
+    }
+
+    static constexpr std::uint32_t pinv = makePinv();
+    static constexpr std::uint32_t r2   = std::uint32_t((std::uint64_t(0)-std::uint64_t(P)) % P); // 2^64 mod P
+
+    // t/R mod P, t < P*R
+    static constexpr std::uint32_t reduce(std::uint64_t t)
+    {
+        const std::uint32_t m = std::uint32_t(t)*pinv;
+        const std::uint32_t u = std::uint32_t((t + std::uint64_t(m)*P)>>32);
+        return u>=P ? u-P : u;
+    }
+
+    // a*b/R mod P. Если b хранится как b*R (форма Монтгомери) - обычное произведение
+    static constexpr std::uint32_t mulMont(std::uint32_t a, std::uint32_t b)
+    {
+        return reduce(std::uint64_t(a)*b);
+    }
+
+    static constexpr std::uint32_t toMont(std::uint32_t a)
+    {
+        return mulMont(a, r2);
+    }
+
+    // Таблица корней в форме Монтгомери: rt[h+j] = w_2h^j * R, h = 1, 2, 4, ..., n/2, j<h.
+    // rt - n элементов
+    static void makeRoots(std::uint32_t *rt, std::size_t n)
+    {
+        for(std::size_t h=1; h<n; h*=2)
+        {
+            const std::uint32_t w = toMont(pow(G, (P-1u)/(2u*h)));
+            std::uint32_t x = toMont(1u);
+            for(std::size_t j=0; j!=h; ++j)
+            {
+                rt[h+j] = x;
+                x = mulMont(x, w);
+            }
+        }
+    }
+
+    // Начиная с такой длины, преобразование идёт рекурсивно (сначала одна половина целиком,
+    // потом другая), чтобы последние этапы работали в кэше, а не проходили весь массив
+    static constexpr std::size_t recursiveSize = std::size_t(1)<<13;
+
+    // С этой длины половины в рекурсии - отдельные задачи invoke (если он параллельный)
+    static constexpr std::size_t parallelSize = std::size_t(1)<<15;
+
+    // Прямое преобразование (прореживание по частоте), на выходе - bit-reversed порядок
+    template<typename Invoke = serial_invoke>
+    static void forward(std::uint32_t *a, std::size_t n, const std::uint32_t *rt, const Invoke &invoke = Invoke())
+    {
+        for(std::size_t h=n/2; h; h/=2)
+        {
+            forwardStage(a, n, h, rt);
+            if (h>=recursiveSize)
+            {
+                if (invoke.parallel() && n>=parallelSize)
+                {
+                    invoke( [=, &invoke]() { forward(a  , h, rt, invoke); }
+                          , [=, &invoke]() { forward(a+h, h, rt, invoke); }
+                          );
+                }
+                else
+                {
+                    forward(a  , h, rt);
+                    forward(a+h, h, rt);
+                }
+                return;
+            }
+        }
+    }
+
+    static void forwardStage(std::uint32_t *a, std::size_t n, std::size_t h, const std::uint32_t *rt)
+    {
+        const std::uint32_t *w = rt+h;
+        for(std::size_t i=0; i<n; i+=2u*h)
+        {
+            std::uint32_t *x = a+i;
+            std::uint32_t *y = a+i+h;
+            for(std::size_t j=0; j!=h; ++j)
+            {
+                const std::uint32_t u = x[j];
+                const std::uint32_t v = y[j];
+                x[j] = add(u, v);
+                y[j] = mulMont(sub(u, v), w[j]);
+            }
+        }
+    }
+
+    // Обратное (прореживание по времени) из bit-reversed порядка, без деления на n.
+    // w_2h^-j = -w_2h^(h-j), поэтому таблица та же, а знак уходит в бабочку
+    template<typename Invoke = serial_invoke>
+    static void inverse(std::uint32_t *a, std::size_t n, const std::uint32_t *rt, const Invoke &invoke = Invoke())
+    {
+        std::size_t h = 1;
+        if (n>2u*recursiveSize)
+        {
+            if (invoke.parallel() && n>=parallelSize)
+            {
+                invoke( [=, &invoke]() { inverse(a    , n/2u, rt, invoke); }
+                      , [=, &invoke]() { inverse(a+n/2, n/2u, rt, invoke); }
+                      );
+            }
+            else
+            {
+                inverse(a    , n/2u, rt);
+                inverse(a+n/2, n/2u, rt);
+            }
+            h = n/2u;
+        }
+
+        for(; h<n; h*=2)
+            inverseStage(a, n, h, rt);
+    }
+
+    static void inverseStage(std::uint32_t *a, std::size_t n, std::size_t h, const std::uint32_t *rt)
+    {
+        const std::uint32_t *w = rt+h;
+        for(std::size_t i=0; i<n; i+=2u*h)
+        {
+            std::uint32_t *x = a+i;
+            std::uint32_t *y = a+i+h;
+
+            const std::uint32_t u0 = x[0];
+            const std::uint32_t v0 = y[0];
+            x[0] = add(u0, v0);
+            y[0] = sub(u0, v0);
+
+            for(std::size_t j=1; j!=h; ++j)
+            {
+                const std::uint32_t u = x[j];
+                const std::uint32_t v = mulMont(y[j], w[h-j]); // = -y*w^-j
+                x[j] = sub(u, v);
+                y[j] = add(u, v);
+            }
+        }
+    }
+
+}; // struct ntt_prime
+
+using ntt_prime1 = ntt_prime< 469762049u,  3u>; //  7*2^26+1
+using ntt_prime2 = ntt_prime< 754974721u, 11u>; // 45*2^24+1
+using ntt_prime3 = ntt_prime<2013265921u, 31u>; // 15*2^27+1
+
+constexpr const unsigned nttMaxLog = 24;
+
+//----------------------------------------------------------------------------
+// Куски, на которые режутся чанки: не длиннее 32 бит
+template<typename T>
+constexpr int nttPieceBits() { return limbBits<T>()<32 ? limbBits<T>() : 32; }
+
+template<typename T>
+constexpr std::size_t nttPiecesPerLimb() { return std::size_t(limbBits<T>()/nttPieceBits<T>()); }
+
+template<typename T>
+inline
+std::uint32_t nttGetPiece(const T *a, std::size_t idx)
+{
+    constexpr std::size_t ppl = nttPiecesPerLimb<T>();
+    const int shift = int(idx%ppl)*nttPieceBits<T>();
+    return std::uint32_t(std::uint64_t(a[idx/ppl]>>shift) & ((std::uint64_t(1)<<nttPieceBits<T>())-1u));
+}
+
+template<typename T>
+inline
+void nttSetPiece(T *a, std::size_t idx, std::uint32_t v)
+{
+    constexpr std::size_t ppl = nttPiecesPerLimb<T>();
+    const int shift = int(idx%ppl)*nttPieceBits<T>();
+    const T   mask  = T(T((std::uint64_t(1)<<nttPieceBits<T>())-1u)<<shift);
+    a[idx/ppl] = T(T(a[idx/ppl] & T(~mask)) | T(T(v)<<shift));
+}
+
+//----------------------------------------------------------------------------
+inline
+std::size_t nttSize(std::size_t na, std::size_t nb)
+{
+    std::size_t n = 1;
+    while(n<na+nb-1u)
+        n *= 2u;
+    return n;
+}
+
+// Максимальный блок (в чанках), чтобы свёртка двух блоков влезла в 2^nttMaxLog
+template<typename T>
+constexpr std::size_t nttMaxBlockLimbs() { return (std::size_t(1)<<(nttMaxLog-1u))/nttPiecesPerLimb<T>(); }
+
+//----------------------------------------------------------------------------
+// Свёртка по одному модулю: f = a (*) b mod P, g - временный массив, rt - под корни, все по n
+template<typename Prime, typename T, typename Invoke = serial_invoke>
+inline
+void nttConvolve(std::uint32_t *f, std::uint32_t *g, std::uint32_t *rt, const T *a, std::size_t na, const T *b, std::size_t nb, std::size_t n, const Invoke &invoke = Invoke())
+{
+    for(std::size_t i=0; i!=na; ++i)
+        f[i] = nttGetPiece(a, i) % Prime::mod;
+    std::fill(f+na, f+n, std::uint32_t(0));
+
+    // Квадрат - одно прямое преобразование вместо двух
+    const bool square = (a==b && na==nb);
+    if (!square)
+    {
+        for(std::size_t i=0; i!=nb; ++i)
+            g[i] = nttGetPiece(b, i) % Prime::mod;
+        std::fill(g+nb, g+n, std::uint32_t(0));
+    }
+
+    Prime::makeRoots(rt, n);
+    if (!square)
+    {
+        invoke( [&]() { Prime::forward(f, n, rt, invoke); }
+              , [&]() { Prime::forward(g, n, rt, invoke); }
+              );
+    }
+    else
+    {
+        Prime::forward(f, n, rt, invoke);
+        g = f;
+    }
+
+    // mulMont(f, g) = f*g/R, второй mulMont на invN*R^2 - деление на n и возврат из R
+    const std::uint32_t scale = Prime::toMont(Prime::toMont(Prime::inv(std::uint32_t(n % Prime::mod))));
+    for(std::size_t i=0; i!=n; ++i)
+        f[i] = Prime::mulMont(Prime::mulMont(f[i], g[i]), scale);
+
+    Prime::inverse(f, n, rt, invoke);
+}
+
+//----------------------------------------------------------------------------
+// r += a*b, r - rn чанков, сумма обязана влезть. work - не меньше 5*nttSize(кусков a, кусков b),
+// а если invoke параллельный - 9*nttSize: свёртки по трём модулям идут одновременно,
+// у каждой свои g и rt
+template<typename T, typename Invoke = serial_invoke>
+inline
+void nttMulAdd(T *r, std::size_t rn, const T *a, std::size_t an, const T *b, std::size_t bn, std::uint32_t *work, const Invoke &invoke = Invoke())
+{
+    constexpr std::size_t ppl = nttPiecesPerLimb<T>();
+    constexpr int         pb  = nttPieceBits<T>();
+
+    const std::size_t na = an*ppl;
+    const std::size_t nb = bn*ppl;
+    const std::size_t n  = nttSize(na, nb);
+
+    std::uint32_t *f1 = work;
+    std::uint32_t *f2 = f1 + n;
+    std::uint32_t *f3 = f2 + n;
+    std::uint32_t *g  = f3 + n;
+    std::uint32_t *rt = g  + n;
+
+    if (invoke.parallel())
+    {
+        std::uint32_t *g2  = rt  + n;
+        std::uint32_t *rt2 = g2  + n;
+        std::uint32_t *g3  = rt2 + n;
+        std::uint32_t *rt3 = g3  + n;
+
+        invoke( [&]() { nttConvolve<ntt_prime1>(f1, g , rt , a, na, b, nb, n, invoke); }
+              , [&]() { nttConvolve<ntt_prime2>(f2, g2, rt2, a, na, b, nb, n, invoke); }
+              , [&]() { nttConvolve<ntt_prime3>(f3, g3, rt3, a, na, b, nb, n, invoke); }
+              );
+    }
+    else
+    {
+        nttConvolve<ntt_prime1>(f1, g, rt, a, na, b, nb, n);
+        nttConvolve<ntt_prime2>(f2, g, rt, a, na, b, nb, n);
+        nttConvolve<ntt_prime3>(f3, g, rt, a, na, b, nb, n);
+    }
+
+    constexpr std::uint32_t p1 = ntt_prime1::mod;
+    constexpr std::uint32_t p2 = ntt_prime2::mod;
+    constexpr std::uint32_t inv1mod2  = ntt_prime2::inv(p1);
+    constexpr std::uint32_t inv12mod3 = ntt_prime3::inv(ntt_prime3::mul(p1, p2));
+
+    // Гарнер: x = r1 + p1*k2 + p1*p2*k3 < 2^90, складываем в r кусками по pb бит,
+    // acc - 128-битный перенос (lo, hi)
+    std::uint64_t accLo = 0;
+    std::uint64_t accHi = 0;
+
+    auto accAdd = [&](std::uint64_t lo, std::uint64_t hi)
+    {
+        std::uint64_t c = 0;
+        accLo = addCarry(accLo, lo, c);
+        accHi = accHi + hi + c;
+    };
+
+    auto accPop = [&]()
+    {
+        const std::uint32_t v = std::uint32_t(accLo & ((std::uint64_t(1)<<pb)-1u));
+        accLo = (accLo>>pb) | (accHi<<(64-pb));
+        accHi = accHi>>pb;
+        return v;
+    };
+
+    const std::size_t nc = na+nb-1u;
+    const std::size_t nr = rn*ppl;
+    std::size_t i = 0;
+    for(; i!=nc; ++i)
+    {
+        const std::uint32_t r1 = f1[i];
+        const std::uint32_t k2 = ntt_prime2::mul(ntt_prime2::sub(f2[i], r1), inv1mod2);
+        const std::uint32_t t3 = ntt_prime3::add(r1, ntt_prime3::mul(p1, k2));
+        const std::uint32_t k3 = ntt_prime3::mul(ntt_prime3::sub(f3[i], t3), inv12mod3);
+
+        const std::uint64_t m  = std::uint64_t(k2) + std::uint64_t(p2)*k3; // < p2*p3 < 2^61
+        std::uint64_t hi = 0;
+        std::uint64_t lo = mulWide(std::uint64_t(p1), m, hi);
+        std::uint64_t c  = 0;
+        lo = addCarry(lo, std::uint64_t(r1), c);
+        hi += c;
+
+        accAdd(lo, hi);
+        accAdd(nttGetPiece(r, i), 0);
+        nttSetPiece(r, i, accPop());
+    }
+
+    for(; (accLo|accHi) && i!=nr; ++i)
+    {
+        accAdd(nttGetPiece(r, i), 0);
+        nttSetPiece(r, i, accPop());
+    }
+}
+
+} // namespace details
+
+//----------------------------------------------------------------------------
+//! Размер рабочей области mul_ntt, в 32-битных словах (не в чанках).
+//! parallel - для mul_ntt с параллельным invoke, там рабочая область почти вдвое больше
+template<typename T>
+inline
+std::size_t nttWorkSize(std::size_t an, std::size_t bn, bool parallel = false)
+{
+    const std::size_t maxBlock = details::nttMaxBlockLimbs<T>();
+    const std::size_t ppl      = details::nttPiecesPerLimb<T>();
+    return (parallel ? 9u : 5u)*details::nttSize(std::min(an, maxBlock)*ppl, std::min(bn, maxBlock)*ppl);
+}
+
+//----------------------------------------------------------------------------
+//! r = a * b через NTT, an>=1, bn>=1, r - an+bn чанков и не пересекается с a и b.
+//! Результат точный, для любых длин; если свёртка не влезает в 2^24 - умножаем блоками.
+//! Если a и b - один и тот же массив (квадрат), прямых преобразований вдвое меньше.
+//! work - не меньше nttWorkSize<T>(an, bn, invoke.parallel()) 32-битных слов, других аллокаций нет.
+//! invoke - исполнитель для свёрток по модулям и половин рекурсии преобразований (см. serial_invoke)
+template<typename T, typename Invoke = serial_invoke>
+inline
+void mul_ntt(T *r, const T *a, std::size_t an, const T *b, std::size_t bn, std::uint32_t *work, const Invoke &invoke = Invoke())
+{
+    for(std::size_t i=0; i!=an+bn; ++i)
+        r[i] = 0;
+
+    const std::size_t maxBlock = details::nttMaxBlockLimbs<T>();
+    for(std::size_t i=0; i<an; i+=maxBlock)
+    {
+        for(std::size_t j=0; j<bn; j+=maxBlock)
+        {
+            details::nttMulAdd( r+i+j, an+bn-i-j
+                              , a+i, std::min(maxBlock, an-i)
+                              , b+j, std::min(maxBlock, bn-j)
+                              , work, invoke
+                              );
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+
+} // namespace bigint_limbs
+} // namespace marty
+
+// marty::bigint_limbs::
+// #include "marty_bigint/ntt.h"
+
@@ -0,0 +1,710 @@
+/*!
+    \file
+    \brief Контейнер для хранения модуля marty::BigInt
+ */
+#pragma once
+
+#include "defs.h"
+
+//
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(MARTY_BIGINT_USE_PMR) && MARTY_BIGINT_USE_PMR!=0
+    #include <memory_resource>
+#endif
+
+//
+#include "undef_min_max.h"
+
+
+// #include "marty_bigint/number_holder.h"
+// marty::bigint_details::
+namespace marty {
+namespace bigint_details {
+
+
+//----------------------------------------------------------------------------
+// Аллокатор, выделяющий память, выровненную по Alignment (по умолчанию - по границе кэш-линии).
+// Stateless, все экземпляры эквивалентны.
+template<typename T, std::size_t Alignment = MARTY_BIGINT_HEAP_ALIGNMENT>
+struct aligned_allocator
+{
+    static_assert(Alignment>=alignof(T) && (Alignment&(Alignment-1))==0, "aligned_allocator: Alignment must be a power of two, not less than alignof(T)");
+
+    using value_type      = T;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal                        = std::true_type;
+
+    template<typename U> struct rebind { using other = aligned_allocator<U, Alignment>; };
+
+    aligned_allocator() noexcept {}
+    template<typename U> aligned_allocator(const aligned_allocator<U, Alignment>&) noexcept {}
+
+    T* allocate(std::size_t n)
+    {
+        if (n>std::size_t(-1)/sizeof(T))
+            throw std::bad_array_new_length();
+        return static_cast<T*>(::operator new(n*sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept
+    {
+        MARTY_ARG_USED(n);
+        ::operator delete(static_cast<void*>(p), std::align_val_t(Alignment));
+    }
+
+    template<typename U>
+    bool operator==(const aligned_allocator<U, Alignment>&) const noexcept { return true;  }
+    template<typename U>
+    bool operator!=(const aligned_allocator<U, Alignment>&) const noexcept { return false; }
+
+}; // struct aligned_allocator
+
+//----------------------------------------------------------------------------
+
+
+
+#if defined(MARTY_BIGINT_USE_PMR) && MARTY_BIGINT_USE_PMR!=0
+
+//----------------------------------------------------------------------------
+// Текущий для потока memory_resource, через который аллоцируют новые BigInt.
+// nullptr - используем std::pmr::get_default_resource()
+inline
+std::pmr::memory_resource*& currentMemoryResourceRef()
+{
+    static thread_local std::pmr::memory_resource *pResource = nullptr;
+    return pResource;
+}
+
+inline
+std::pmr::memory_resource* getMemoryResource()
+{
+    std::pmr::memory_resource *pResource = currentMemoryResourceRef();
+    return pResource ? pResource : std::pmr::get_default_resource();
+}
+
+//----------------------------------------------------------------------------
+// Задаёт memory_resource для всех BigInt, создаваемых в текущем потоке, пока жив объект.
+// Типичное использование - все временные значения запроса живут в monotonic_buffer_resource,
+// и освобождаются разом. Результат надо присвоить в BigInt, созданный вне скоупа -
+// при присваивании аллокатор не распространяется, и данные копируются в память получателя.
+class memory_resource_scope
+{
+    std::pmr::memory_resource *m_pPrev = nullptr;
+
+public:
+
+    explicit memory_resource_scope(std::pmr::memory_resource *pResource)
+    : m_pPrev(currentMemoryResourceRef())
+    {
+        currentMemoryResourceRef() = pResource;
+    }
+
+    ~memory_resource_scope()
+    {
+        currentMemoryResourceRef() = m_pPrev;
+    }
+
+    memory_resource_scope(const memory_resource_scope&) = delete;
+    memory_resource_scope& operator=(const memory_resource_scope&) = delete;
+
+}; // class memory_resource_scope
+
+//----------------------------------------------------------------------------
+// Аллокатор поверх std::pmr::memory_resource с заданным выравниванием.
+// По умолчанию берёт текущий ресурс потока (см. memory_resource_scope).
+// Копия контейнера тоже берёт текущий ресурс потока, а не ресурс источника,
+// при присваивании и обмене аллокатор не распространяется - как у std::pmr::polymorphic_allocator.
+template<typename T, std::size_t Alignment = MARTY_BIGINT_HEAP_ALIGNMENT>
+class resource_allocator
+{
+    static_assert(Alignment>=alignof(T) && (Alignment&(Alignment-1))==0, "resource_allocator: Alignment must be a power of two, not less than alignof(T)");
+
+    template<typename U, std::size_t A> friend class resource_allocator;
+
+    std::pmr::memory_resource *m_pResource = nullptr;
+
+public:
+
+    using value_type      = T;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::false_type;
+    using propagate_on_container_swap            = std::false_type;
+    using is_always_equal                        = std::false_type;
+
+    template<typename U> struct rebind { using other = resource_allocator<U, Alignment>; };
+
+    resource_allocator() noexcept : m_pResource(getMemoryResource()) {}
+    resource_allocator(std::pmr::memory_resource *pResource) noexcept : m_pResource(pResource ? pResource : getMemoryResource()) {}
+    template<typename U> resource_allocator(const resource_allocator<U, Alignment> &other) noexcept : m_pResource(other.m_pResource) {}
+
+    std::pmr::memory_resource* resource() const noexcept { return m_pResource; }
+
+    resource_allocator select_on_container_copy_construction() const { return resource_allocator(); }
+
+    T* allocate(std::size_t n)
+    {
+        if (n>std::size_t(-1)/sizeof(T))
+            throw std::bad_array_new_length();
+        return static_cast<T*>(m_pResource->allocate(n*sizeof(T), Alignment));
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept
+    {
+        m_pResource->deallocate(static_cast<void*>(p), n*sizeof(T), Alignment);
+    }
+
+    template<typename U>
+    bool operator==(const resource_allocator<U, Alignment> &other) const noexcept
+    {
+        return m_pResource==other.m_pResource || m_pResource->is_equal(*other.m_pResource);
+    }
+
+    template<typename U>
+    bool operator!=(const resource_allocator<U, Alignment> &other) const noexcept { return !operator==(other); }
+
+}; // class resource_allocator
+
+//----------------------------------------------------------------------------
+
+#endif // MARTY_BIGINT_USE_PMR
+
+
+
+
+//----------------------------------------------------------------------------
+// Вектор чанков с встроенным буфером на InlineCapacity элементов (small buffer optimization).
+// Пока число влезает во встроенный буфер, аллокаций нет вообще. Когда не влезает -
+// выделяем память через аллокатор, размер блока округляем до кратного MARTY_BIGINT_HEAP_ALIGNMENT байт.
+// В отличие от std::basic_string, не тратим место на завершающий ноль, и не зависим от std::char_traits.
+// Хранить можно только тривиальные типы - нам нужны только целые.
+// Аллокатор хранится через EBO, для stateless аллокаторов места не занимает.
+template<typename T, std::size_t InlineCapacity, typename Allocator = aligned_allocator<T> >
+class basic_number_holder : private Allocator
+{
+    static_assert(std::is_trivial_v<T>, "basic_number_holder: T must be a trivial type");
+    static_assert(InlineCapacity>0, "basic_number_holder: InlineCapacity must be greater than zero");
+
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+public: // types
+
+    using value_type             = T;
+    using allocator_type         = Allocator;
+    using size_type              = std::size_t;
+    using difference_type        = std::ptrdiff_t;
+    using reference              = T&;
+    using const_reference        = const T&;
+    using pointer                = T*;
+    using const_pointer          = const T*;
+    using iterator               = T*;
+    using const_iterator         = const T*;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    constexpr const static inline size_type inline_capacity = InlineCapacity;
+
+
+protected: // member fields
+
+    T*         m_data     = m_inline;
+    size_type  m_size     = 0;
+    size_type  m_capacity = InlineCapacity;
+    T          m_inline[InlineCapacity];
+
+
+public: // ctors
+
+    basic_number_holder() noexcept(std::is_nothrow_default_constructible_v<Allocator>) : Allocator() {}
+
+    explicit basic_number_holder(const Allocator &a) noexcept : Allocator(a) {}
+
+    explicit basic_number_holder(size_type n, const T &v = T(), const Allocator &a = Allocator())
+    : Allocator(a)
+    {
+        assign(n, v);
+    }
+
+    template<typename InputIt, std::enable_if_t< !std::is_integral_v<InputIt>, int> = 0 >
+    basic_number_holder(InputIt b, InputIt e, const Allocator &a = Allocator())
+    : Allocator(a)
+    {
+        assign(b, e);
+    }
+
+    basic_number_holder(std::initializer_list<T> il, const Allocator &a = Allocator())
+    : Allocator(a)
+    {
+        assign(il.begin(), il.end());
+    }
+
+    basic_number_holder(const basic_number_holder &other)
+    : Allocator(alloc_traits::select_on_container_copy_construction(other.getAllocatorRef()))
+    {
+        assign(other.begin(), other.end());
+    }
+
+    basic_number_holder(const basic_number_holder &other, const Allocator &a)
+    : Allocator(a)
+    {
+        assign(other.begin(), other.end());
+    }
+
+    basic_number_holder(basic_number_holder &&other) noexcept
+    : Allocator(std::move(other.getAllocatorRef()))
+    {
+        stealFrom(other);
+    }
+
+    basic_number_holder(basic_number_holder &&other, const Allocator &a)
+    : Allocator(a)
+    {
+        if (getAllocatorRef()==other.getAllocatorRef())
+        {
+            stealFrom(other);
+        }
+        else
+        {
+            assign(other.begin(), other.end());
+            other.clear();
+        }
+    }
+
+    ~basic_number_holder()
+    {
+        freeHeap();
+    }
+
+    basic_number_holder& operator=(const basic_number_holder &other)
+    {
+        if (this==&other)
+            return *this;
+
+        if constexpr (alloc_traits::propagate_on_container_copy_assignment::value)
+        {
+            if (getAllocatorRef()!=other.getAllocatorRef())
+                freeHeap();
+            getAllocatorRef() = other.getAllocatorRef();
+        }
+
+        assign(other.begin(), other.end());
+        return *this;
+    }
+
+    basic_number_holder& operator=(basic_number_holder &&other) noexcept(alloc_traits::propagate_on_container_move_assignment::value || alloc_traits::is_always_equal::value)
+    {
+        if (this==&other)
+            return *this;
+
+        if (!other.isHeap())
+        {
+            // Во встроенном буфере - просто копируем, свою память (если есть) оставляем себе
+            copyInline(other);
+            return *this;
+        }
+
+        if constexpr (alloc_traits::propagate_on_container_move_assignment::value)
+        {
+            freeHeap();
+            getAllocatorRef() = std::move(other.getAllocatorRef());
+            stealFrom(other);
+        }
+        else
+        {
+            if (getAllocatorRef()==other.getAllocatorRef())
+            {
+                freeHeap();
+                stealFrom(other);
+            }
+            else
+            {
+                assign(other.begin(), other.end());
+                other.clear();
+            }
+        }
+
+        return *this;
+    }
+
+    basic_number_holder& operator=(std::initializer_list<T> il)
+    {
+        assign(il.begin(), il.end());
+        return *this;
+    }
+
+    allocator_type get_allocator() const { return getAllocatorRef(); }
+
+
+public: // iterators
+
+    iterator               begin()         noexcept { return m_data; }
+    iterator               end()           noexcept { return m_data+m_size; }
+    const_iterator         begin()   const noexcept { return m_data; }
+    const_iterator         end()     const noexcept { return m_data+m_size; }
+    const_iterator         cbegin()  const noexcept { return m_data; }
+    const_iterator         cend()    const noexcept { return m_data+m_size; }
+
+    reverse_iterator       rbegin()        noexcept { return reverse_iterator(end()); }
+    reverse_iterator       rend()          noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin()  const noexcept { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend()    const noexcept { return const_reverse_iterator(begin()); }
+    const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(end()); }
+    const_reverse_iterator crend()   const noexcept { return const_reverse_iterator(begin()); }
+
+
+public: // size & capacity
+
+    size_type size()     const noexcept { return m_size; }
+    bool      empty()    const noexcept { return m_size==0; }
+    size_type capacity() const noexcept { return m_capacity; }
+    size_type max_size() const noexcept { return std::min(size_type(alloc_traits::max_size(getAllocatorRef())), size_type(std::numeric_limits<difference_type>::max())/sizeof(T)); }
+
+    void reserve(size_type n)
+    {
+        if (n>m_capacity)
+            reallocate(n);
+    }
+
+    // Если данные влезают во встроенный буфер - возвращаемся в него, иначе ничего не делаем
+    void shrink_to_fit()
+    {
+        if (!isHeap() || m_size>InlineCapacity)
+            return;
+
+        T *heapData = m_data;
+        size_type heapCapacity = m_capacity;
+        copyElements(m_inline, heapData, m_size);
+        m_data     = m_inline;
+        m_capacity = InlineCapacity;
+        alloc_traits::deallocate(getAllocatorRef(), heapData, heapCapacity);
+    }
+
+    bool is_inline() const noexcept { return !isHeap(); }
+
+
+public: // element access
+
+    reference       operator[](size_type i)       noexcept { return m_data[i]; }
+    const_reference operator[](size_type i) const noexcept { return m_data[i]; }
+
+    reference at(size_type i)
+    {
+        if (i>=m_size)
+            throw std::out_of_range("basic_number_holder::at: index out of range");
+        return m_data[i];
+    }
+
+    const_reference at(size_type i) const
+    {
+        if (i>=m_size)
+            throw std::out_of_range("basic_number_holder::at: index out of range");
+        return m_data[i];
+    }
+
+    reference       front()       noexcept { return m_data[0]; }
+    const_reference front() const noexcept { return m_data[0]; }
+    reference       back()        noexcept { return m_data[m_size-1]; }
+    const_reference back()  const noexcept { return m_data[m_size-1]; }
+
+    T*              data()        noexcept { return m_data; }
+    const T*        data()  const noexcept { return m_data; }
+
+
+public: // modifiers
+
+    void clear() noexcept { m_size = 0; }
+
+    void push_back(const T &v)
+    {
+        const T val = v; // v может ссылаться на наш же элемент, а буфер при росте переезжает
+        if (m_size==m_capacity)
+            reallocate(m_size+1);
+        m_data[m_size++] = val;
+    }
+
+    template<typename... Args>
+    reference emplace_back(Args&&... args)
+    {
+        push_back(T(std::forward<Args>(args)...));
+        return back();
+    }
+
+    void pop_back() noexcept { --m_size; }
+
+    void resize(size_type n)
+    {
+        resize(n, T());
+    }
+
+    void resize(size_type n, const T &v)
+    {
+        if (n>m_size)
+        {
+            const T val = v;
+            reserve(n);
+            std::fill(m_data+m_size, m_data+n, val);
+        }
+        m_size = n;
+    }
+
+    void assign(size_type n, const T &v)
+    {
+        m_size = 0;
+        resize(n, v);
+    }
+
+    template<typename InputIt, std::enable_if_t< !std::is_integral_v<InputIt>, int> = 0 >
+    void assign(InputIt b, InputIt e)
+    {
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category>)
+        {
+            const size_type n = size_type(std::distance(b, e));
+            if (n>m_capacity)
+            {
+                // Свой диапазон сюда попасть не может - он влезает в текущую ёмкость
+                m_size = 0;
+                reallocate(n);
+            }
+            // Если источник - наши же данные, то он лежит не левее m_data, и прямое копирование безопасно
+            std::copy(b, e, m_data);
+            m_size = n;
+        }
+        else
+        {
+            m_size = 0;
+            for(; b!=e; ++b)
+                push_back(*b);
+        }
+    }
+
+    iterator insert(const_iterator pos, const T &v)
+    {
+        return insert(pos, size_type(1), v);
+    }
+
+    iterator insert(const_iterator pos, size_type n, const T &v)
+    {
+        const size_type idx = size_type(pos-m_data);
+        const T val = v;
+        makeGap(idx, n);
+        std::fill(m_data+idx, m_data+idx+n, val);
+        return m_data+idx;
+    }
+
+    template<typename InputIt, std::enable_if_t< !std::is_integral_v<InputIt>, int> = 0 >
+    iterator insert(const_iterator pos, InputIt b, InputIt e)
+    {
+        const size_type idx = size_type(pos-m_data);
+
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category>)
+        {
+            const size_type n = size_type(std::distance(b, e));
+            // Источник может указывать на наши собственные данные, поэтому копируем его
+            // до того, как что-то раздвигать
+            if (n && isOwnRange(b))
+            {
+                basic_number_holder tmp(b, e);
+                return insert(pos, tmp.begin(), tmp.end());
+            }
+            makeGap(idx, n);
+            std::copy(b, e, m_data+idx);
+        }
+        else
+        {
+            size_type i = idx;
+            for(; b!=e; ++b, ++i)
+            {
+                makeGap(i, 1);
+                m_data[i] = *b;
+            }
+        }
+
+        return m_data+idx;
+    }
+
+    iterator insert(const_iterator pos, std::initializer_list<T> il)
+    {
+        return insert(pos, il.begin(), il.end());
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        return erase(pos, pos+1);
+    }
+
+    iterator erase(const_iterator b, const_iterator e)
+    {
+        const size_type idxB = size_type(b-m_data);
+        const size_type idxE = size_type(e-m_data);
+        if (idxB!=idxE)
+        {
+            std::memmove(m_data+idxB, m_data+idxE, (m_size-idxE)*sizeof(T));
+            m_size -= idxE-idxB;
+        }
+        return m_data+idxB;
+    }
+
+    void swap(basic_number_holder &other) noexcept(alloc_traits::propagate_on_container_swap::value || alloc_traits::is_always_equal::value)
+    {
+        if (this==&other)
+            return;
+
+        const bool canSwapBuffers = isHeap() && other.isHeap()
+                                 && (alloc_traits::propagate_on_container_swap::value || getAllocatorRef()==other.getAllocatorRef());
+        if (canSwapBuffers)
+        {
+            std::swap(m_data    , other.m_data    );
+            std::swap(m_size    , other.m_size    );
+            std::swap(m_capacity, other.m_capacity);
+            if constexpr (alloc_traits::propagate_on_container_swap::value)
+            {
+                using std::swap;
+                swap(getAllocatorRef(), other.getAllocatorRef());
+            }
+            return;
+        }
+
+        basic_number_holder tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    friend void swap(basic_number_holder &h1, basic_number_holder &h2) noexcept(noexcept(h1.swap(h2)))
+    {
+        h1.swap(h2);
+    }
+
+
+public: // compare
+
+    friend bool operator==(const basic_number_holder &h1, const basic_number_holder &h2)
+    {
+        return h1.size()==h2.size() && std::equal(h1.begin(), h1.end(), h2.begin());
+    }
+
+    friend bool operator!=(const basic_number_holder &h1, const basic_number_holder &h2)
+    {
+        return !(h1==h2);
+    }
+
+
+protected: // helpers
+
+    Allocator&       getAllocatorRef()       noexcept { return static_cast<Allocator&>(*this); }
+    const Allocator& getAllocatorRef() const noexcept { return static_cast<const Allocator&>(*this); }
+
+    bool isHeap() const noexcept { return m_data!=m_inline; }
+
+    template<typename InputIt>
+    bool isOwnRange(InputIt it) const
+    {
+        if constexpr (std::is_pointer_v<InputIt>)
+            return std::less_equal<const T*>()(m_data, it) && std::less<const T*>()(it, m_data+m_capacity);
+        else
+            return false;
+    }
+
+    static void copyElements(T *pDst, const T *pSrc, size_type n) noexcept
+    {
+        if (n)
+            std::memcpy(pDst, pSrc, n*sizeof(T));
+    }
+
+    // Округляем размер блока вверх до границы выравнивания
+    static size_type roundUpCapacity(size_type n) noexcept
+    {
+        constexpr const size_type alignElements = (MARTY_BIGINT_HEAP_ALIGNMENT>sizeof(T)) ? size_type(MARTY_BIGINT_HEAP_ALIGNMENT)/sizeof(T) : size_type(1);
+        return (n+alignElements-1)/alignElements*alignElements;
+    }
+
+    void reallocate(size_type requiredCapacity)
+    {
+        if (requiredCapacity>max_size())
+            throw std::length_error("basic_number_holder: requested size is too large");
+
+        // Растём как минимум вдвое, чтобы push_back был амортизированно константным
+        size_type newCapacity = std::max(requiredCapacity, 2u*m_capacity);
+        newCapacity = std::min(roundUpCapacity(newCapacity), max_size());
+
+        T *pNew = alloc_traits::allocate(getAllocatorRef(), newCapacity);
+        copyElements(pNew, m_data, m_size);
+        freeHeap();
+        m_data     = pNew;
+        m_capacity = newCapacity;
+    }
+
+    void makeGap(size_type idx, size_type n)
+    {
+        if (!n)
+            return;
+
+        if (m_size+n>m_capacity)
+            reallocate(m_size+n);
+
+        if (idx!=m_size)
+            std::memmove(m_data+idx+n, m_data+idx, (m_size-idx)*sizeof(T));
+
+        m_size += n;
+    }
+
+    void freeHeap() noexcept
+    {
+        if (isHeap())
+            alloc_traits::deallocate(getAllocatorRef(), m_data, m_capacity);
+        m_data     = m_inline;
+        m_capacity = InlineCapacity;
+    }
+
+    // Копируем данные из встроенного буфера other, other очищаем
+    void copyInline(basic_number_holder &other) noexcept
+    {
+        // Встроенный буфер other всегда влезает в нашу ёмкость
+        copyElements(m_data, other.m_data, other.m_size);
+        m_size = other.m_size;
+        other.m_size = 0;
+    }
+
+    // Аллокатор уже должен быть установлен, своего буфера в куче быть не должно
+    void stealFrom(basic_number_holder &other) noexcept
+    {
+        if (!other.isHeap())
+        {
+            copyInline(other);
+            return;
+        }
+
+        m_data     = other.m_data;
+        m_size     = other.m_size;
+        m_capacity = other.m_capacity;
+
+        other.m_data     = other.m_inline;
+        other.m_size     = 0;
+        other.m_capacity = InlineCapacity;
+    }
+
+}; // class basic_number_holder
+
+//----------------------------------------------------------------------------
+
+} // namespace bigint_details
+} // namespace marty
+
+// marty::bigint_details::
+// #include "marty_bigint/number_holder.h"
+
@@ -0,0 +1,182 @@
+/*!
+    \file
+    \brief Рабочая область для временных значений алгоритмов marty::BigInt
+ */
+#pragma once
+
+#include "types.h"
+
+//
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+//
+#include "undef_min_max.h"
+
+
+// #include "marty_bigint/scratch.h"
+// marty::bigint_details::
+namespace marty {
+namespace bigint_details {
+
+
+//----------------------------------------------------------------------------
+// Пул временных буферов для алгоритмов умножения/деления.
+// Буфер берётся из пула, после использования возвращается обратно очищенным,
+// но с сохранённой ёмкостью. В установившемся режиме повторные умножения/деления
+// не делают аллокаций под временные значения - только под результат.
+// По умолчанию используется рабочая область текущего потока (threadLocal()),
+// но можно создать свою и передавать явно.
+class scratch_workspace
+{
+    std::vector<number_holder_t>  m_holders;
+
+#if defined(MARTY_BIGINT_USE_PMR) && MARTY_BIGINT_USE_PMR!=0
+
+    // Рабочая область живёт долго, поэтому её буферы не должны попадать
+    // во временные ресурсы, заданные через memory_resource_scope
+    std::pmr::memory_resource    *m_pResource = nullptr;
+
+    // Вычеты для NTT - 32-битные слова, а не чанки, поэтому отдельно от m_holders
+    std::pmr::vector<std::uint32_t>  m_residues;
+    std::pmr::vector<double>         m_fftData;
+
+public:
+
+    explicit scratch_workspace(std::pmr::memory_resource *pResource = std::pmr::new_delete_resource())
+    : m_pResource(pResource)
+    , m_residues(pResource)
+    , m_fftData(pResource)
+    {}
+
+protected:
+
+    number_holder_t makeHolder() const { return number_holder_t(number_allocator_t(m_pResource)); }
+
+#else
+
+public:
+
+    scratch_workspace() {}
+
+protected:
+
+    number_holder_t makeHolder() const { return number_holder_t(); }
+
+    // Вычеты для NTT - 32-битные слова, а не чанки, поэтому отдельно от m_holders
+    std::vector<std::uint32_t>       m_residues;
+    // Комплексные массивы FFT
+    std::vector<double>              m_fftData;
+
+#endif
+
+public:
+
+    scratch_workspace(const scratch_workspace&) = delete;
+    scratch_workspace& operator=(const scratch_workspace&) = delete;
+
+    //! Берёт пустой буфер из пула, с ёмкостью не менее reserveSize
+    number_holder_t acquire(std::size_t reserveSize=0)
+    {
+        number_holder_t h = makeHolder();
+        if (!m_holders.empty())
+        {
+            h = std::move(m_holders.back());
+            m_holders.pop_back();
+        }
+
+        h.clear();
+        h.reserve(reserveSize);
+        return h;
+    }
+
+    //! Возвращает буфер в пул. Возвращать можно только буферы, полученные через acquire
+    void release(number_holder_t &&h)
+    {
+        h.clear();
+        m_holders.emplace_back(std::move(h));
+    }
+
+    //! Буфер для вычетов NTT, не меньше size слов. Один на рабочую область,
+    //! содержимое не сохраняется между вызовами, ёмкость - сохраняется
+    std::uint32_t* residues(std::size_t size)
+    {
+        if (m_residues.size()<size)
+            m_residues.resize(size);
+        return m_residues.data();
+    }
+
+    //! То же для FFT в double
+    double* fftData(std::size_t size)
+    {
+        if (m_fftData.size()<size)
+            m_fftData.resize(size);
+        return m_fftData.data();
+    }
+
+    //! Освобождает всю память пула
+    void clear()
+    {
+        m_holders.clear();
+        m_holders.shrink_to_fit();
+        m_residues.clear();
+        m_residues.shrink_to_fit();
+        m_fftData.clear();
+        m_fftData.shrink_to_fit();
+    }
+
+    std::size_t size() const { return m_holders.size(); }
+
+    static scratch_workspace& threadLocal()
+    {
+        static thread_local scratch_workspace ws;
+        return ws;
+    }
+
+}; // class scratch_workspace
+
+//----------------------------------------------------------------------------
+// Временный буфер из рабочей области, возвращается в пул при разрушении
+class scratch_holder
+{
+    scratch_workspace  &m_ws;
+    number_holder_t     m_holder;
+
+public:
+
+    explicit scratch_holder(scratch_workspace &ws, std::size_t reserveSize=0)
+    : m_ws(ws)
+    , m_holder(ws.acquire(reserveSize))
+    {}
+
+    ~scratch_holder()
+    {
+        m_ws.release(std::move(m_holder));
+    }
+
+    scratch_holder(const scratch_holder&) = delete;
+    scratch_holder& operator=(const scratch_holder&) = delete;
+
+    number_holder_t&       get()              { return m_holder; }
+    const number_holder_t& get()        const { return m_holder; }
+
+    number_holder_t&       operator*()        { return m_holder; }
+    const number_holder_t& operator*()  const { return m_holder; }
+    number_holder_t*       operator->()       { return &m_holder; }
+    const number_holder_t* operator->() const { return &m_holder; }
+
+    operator number_holder_t&()               { return m_holder; }
+    operator const number_holder_t&()   const { return m_holder; }
+
+}; // class scratch_holder
+
+//----------------------------------------------------------------------------
+
+} // namespace bigint_details
+} // namespace marty
+
+// marty::bigint_details::
+// #include "marty_bigint/scratch.h"
+
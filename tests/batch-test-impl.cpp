@@ -0,0 +1,403 @@
+/*! \file
+    \brief Тестим marty::BigIntBatch против marty::BigInt по каждому числу пачки, и ядра
+           bigint_batch::details (scalar, AVX2, AVX-512) друг против друга
+ */
+
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+//
+#include "marty_bigint/marty_bigint.h"
+#include "marty_bigint/bigint_batch.h"
+
+#include <windows.h>
+
+#include "marty_bigint/undef_min_max.h"
+
+
+
+using marty::BigInt;
+using marty::BigIntBatch;
+
+
+int unsafeMain(int argc, char* argv[]);
+
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        return unsafeMain(argc, argv);
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    catch(...)
+    {
+        std::cerr << "unknown error\n";
+        return 2;
+    }
+
+}
+
+
+//----------------------------------------------------------------------------
+// Доступ к защищённому расширению ширины
+struct BigIntBatchOps : public BigIntBatch
+{
+    using BigIntBatch::BigIntBatch;
+    using BigIntBatch::setWidth;
+};
+
+//----------------------------------------------------------------------------
+inline
+bool checkCondition(int &nTotal, int &nPassed, const std::string &what, bool bGood)
+{
+    ++nTotal;
+    if (bGood)
+        ++nPassed;
+    else
+        std::cout << "[-]   " << what << " - failed\n" << std::flush;
+
+    return bGood;
+}
+
+inline
+bool checkResult(int &nTotal, int &nPassed, const std::string &what, const BigInt &res, const BigInt &expected)
+{
+    using std::to_string;
+
+    const bool bGood = res==expected;
+
+    ++nTotal;
+    if (bGood)
+        ++nPassed;
+    else
+        std::cout << "[-]   " << what << " - failed, result: " << to_string(res) << ", expected: " << to_string(expected) << "\n" << std::flush;
+
+    return bGood;
+}
+
+//----------------------------------------------------------------------------
+//! Сколько 32-битных слов нужно числу в дополнительном коде
+inline
+std::size_t batchWords(const BigInt &v)
+{
+    std::size_t w = 1;
+    while(v >= (BigInt(1)<<int(32u*w-1u)) || v < -(BigInt(1)<<int(32u*w-1u)))
+        ++w;
+    return w;
+}
+
+//----------------------------------------------------------------------------
+//! n чисел не шире maxWords слов: края диапазона k слов (2^(32k-1)-1, -2^(32k-1)), +-(2^32k - 1)
+//! и +-2^32k (если влезают), 0, +-1 и случайные значения разной длины и знака
+inline
+std::vector<BigInt> makeValues(std::mt19937_64 &rng, std::size_t n, std::size_t maxWords)
+{
+    std::vector<BigInt> edges;
+    edges.emplace_back(0);
+    edges.emplace_back(1);
+    edges.emplace_back(-1);
+    for(std::size_t k=1; k<=maxWords; ++k)
+    {
+        const BigInt half = BigInt(1)<<int(32u*k-1u);
+        edges.emplace_back(half-1);
+        edges.emplace_back(-half);
+        edges.emplace_back(-half+1);
+        if (k<maxWords)
+        {
+            const BigInt full = BigInt(1)<<int(32u*k);
+            edges.emplace_back(full-1);
+            edges.emplace_back(-(full-1));
+            edges.emplace_back(full);
+            edges.emplace_back(-full);
+        }
+    }
+
+    std::vector<BigInt> res;
+    for(std::size_t i=0; i!=n; ++i)
+    {
+        if ((rng()%3u)==0)
+        {
+            res.emplace_back(edges[std::size_t(rng()%edges.size())]);
+            continue;
+        }
+
+        // Случайное: k слов, у старшего из maxWords слов - 31 бит, чтобы влезал знак
+        const std::size_t k = 1u + std::size_t(rng()%maxWords);
+        BigInt v = 0;
+        for(std::size_t w=0; w!=k; ++w)
+        {
+            std::uint64_t word = rng() & 0xFFFFFFFFu;
+            if (w==0 && k==maxWords)
+                word &= 0x7FFFFFFFu;
+            v = (v<<32) + BigInt(word);
+        }
+        res.emplace_back((rng()&1u) ? -v : v);
+    }
+
+    return res;
+}
+
+//----------------------------------------------------------------------------
+inline
+std::string batchName(const char *op, std::size_t n, std::size_t wa, std::size_t wb, std::size_t i)
+{
+    using std::to_string;
+    return std::string(op) + ", n=" + to_string(n) + ", widths " + to_string(wa) + "/" + to_string(wb) + ", lane " + to_string(i);
+}
+
+//----------------------------------------------------------------------------
+//! Операции BigIntBatch по каждому числу против BigInt
+inline
+void testBatchOps(int &nTotal, int &nPassed, std::mt19937_64 &rng, std::size_t n, std::size_t wa, std::size_t wb)
+{
+    const std::vector<BigInt> va = makeValues(rng, n, wa);
+    const std::vector<BigInt> vb = makeValues(rng, n, wb);
+
+    const BigIntBatch a(va);
+    const BigIntBatch b(vb.begin(), vb.end());
+
+    const BigIntBatch sum  = a + b;
+    const BigIntBatch diff = a - b;
+    const BigIntBatch prod = a * b;
+    const std::vector<int> cmp = a.compare(b);
+
+    BigIntBatch acc = a;
+    acc += b;
+    acc *= b;
+    acc -= a;
+
+    for(std::size_t i=0; i!=n; ++i)
+    {
+        checkResult(nTotal, nPassed, batchName("get"    , n, wa, wb, i), a.get(i), va[i]);
+        checkResult(nTotal, nPassed, batchName("[]"     , n, wa, wb, i), b[i]    , vb[i]);
+        checkResult(nTotal, nPassed, batchName("+"      , n, wa, wb, i), sum[i]  , va[i]+vb[i]);
+        checkResult(nTotal, nPassed, batchName("-"      , n, wa, wb, i), diff[i] , va[i]-vb[i]);
+        checkResult(nTotal, nPassed, batchName("*"      , n, wa, wb, i), prod[i] , va[i]*vb[i]);
+        checkResult(nTotal, nPassed, batchName("+=*=-=" , n, wa, wb, i), acc[i]  , (va[i]+vb[i])*vb[i]-va[i]);
+
+        const int expected = va[i]<vb[i] ? -1 : (va[i]==vb[i] ? 0 : 1);
+        checkCondition(nTotal, nPassed, batchName("compare", n, wa, wb, i), cmp[i]==expected);
+    }
+
+    checkCondition(nTotal, nPassed, batchName("compare size", n, wa, wb, 0), cmp.size()==n);
+    checkCondition(nTotal, nPassed, batchName("toVector", n, wa, wb, 0), a.toVector()==va);
+
+    // Ширина результата: сумма/разность - на слово шире, произведение - сумма ширин
+    checkCondition(nTotal, nPassed, batchName("width +", n, wa, wb, 0), sum.width()==std::max(a.width(), b.width())+1u);
+    checkCondition(nTotal, nPassed, batchName("width *", n, wa, wb, 0), prod.width()==a.width()+b.width());
+
+    // shrinkToFit - минимальная ширина, в которую влезают все числа, значения те же
+    {
+        BigIntBatch s = prod;
+        s.shrinkToFit();
+
+        std::size_t minWidth = 1;
+        for(std::size_t i=0; i!=n; ++i)
+        {
+            minWidth = std::max(minWidth, batchWords(va[i]*vb[i]));
+            checkResult(nTotal, nPassed, batchName("shrinkToFit", n, wa, wb, i), s[i], va[i]*vb[i]);
+        }
+        checkCondition(nTotal, nPassed, batchName("shrinkToFit width", n, wa, wb, 0), s.width()==minWidth);
+    }
+
+    // setWidth - расширение со знаком
+    {
+        BigIntBatchOps w(va);
+        const std::size_t width = w.width()+3u;
+        w.setWidth(width);
+        checkCondition(nTotal, nPassed, batchName("setWidth width", n, wa, wb, 0), w.width()==width);
+        for(std::size_t i=0; i!=n; ++i)
+            checkResult(nTotal, nPassed, batchName("setWidth", n, wa, wb, i), w[i], va[i]);
+
+        const BigIntBatch p = w*b;
+        for(std::size_t i=0; i!=n; ++i)
+            checkResult(nTotal, nPassed, batchName("setWidth *", n, wa, wb, i), p[i], va[i]*vb[i]);
+    }
+
+    // set - шире текущей ширины (пачка расширяется), уже и отрицательное; остальные числа не трогаются
+    {
+        BigIntBatch s = a;
+        std::vector<BigInt> expected = va;
+
+        const BigInt wide = -((BigInt(1)<<int(32u*(s.width()+2u)-5)) + BigInt(12345));
+        const std::size_t iWide   = n-1u;
+        const std::size_t iNarrow = n/2u;
+
+        s.set(iWide, wide);
+        expected[iWide] = wide;
+        s.set(iNarrow, BigInt(-7));
+        expected[iNarrow] = BigInt(-7);
+
+        checkCondition(nTotal, nPassed, batchName("set width", n, wa, wb, 0), s.width()==batchWords(wide));
+        for(std::size_t i=0; i!=n; ++i)
+            checkResult(nTotal, nPassed, batchName("set", n, wa, wb, i), s[i], expected[i]);
+    }
+}
+
+//----------------------------------------------------------------------------
+//! Ожидаем исключение типа E от f
+template<typename E, typename F>
+bool checkThrows(int &nTotal, int &nPassed, const std::string &what, F f)
+{
+    bool bGood = false;
+    try
+    {
+        f();
+    }
+    catch(const E &)
+    {
+        bGood = true;
+    }
+
+    return checkCondition(nTotal, nPassed, what + ", no exception", bGood);
+}
+
+//! Ошибки: пачки разного размера, индекс за пределами
+inline
+void testBatchErrors(int &nTotal, int &nPassed)
+{
+    const BigIntBatch a(std::size_t(5));
+    const BigIntBatch b(std::size_t(6));
+
+    checkThrows<std::invalid_argument>(nTotal, nPassed, "a + b, sizes differ"  , [&]() { (void)(a + b); });
+    checkThrows<std::invalid_argument>(nTotal, nPassed, "a * b, sizes differ"  , [&]() { (void)(a * b); });
+    checkThrows<std::invalid_argument>(nTotal, nPassed, "compare, sizes differ", [&]() { (void)a.compare(b); });
+    checkThrows<std::out_of_range    >(nTotal, nPassed, "get out of range"     , [&]() { (void)a.get(5); });
+    checkThrows<std::out_of_range    >(nTotal, nPassed, "set out of range"     , [&]() { BigIntBatch c = a; c.set(5, 1); });
+}
+
+//----------------------------------------------------------------------------
+//! Ядра всех уровней, что умеет процессор, на тех же данных - побитно то же, что scalar
+inline
+void testKernelTiers(int &nTotal, int &nPassed, std::mt19937_64 &rng, std::size_t n, std::size_t wa, std::size_t wb)
+{
+    namespace details = marty::bigint_batch::details;
+
+    const BigIntBatch a(makeValues(rng, n, wa));
+    const BigIntBatch b(makeValues(rng, n, wb));
+
+    const std::size_t stride = a.stride();
+    const std::size_t na     = a.width();
+    const std::size_t nb     = b.width();
+    const std::size_t wMax   = std::max(na, nb);
+
+    // Разрядность суммы: по модулю (wMax), точная (wMax+1), с запасом - расширение знака
+    const std::size_t addWidths[] = { wMax, wMax+1u, wMax+3u };
+
+    std::vector<std::vector<std::uint64_t>> addRef;
+    for(auto wr : addWidths)
+    {
+        for(int sub=0; sub!=2; ++sub)
+        {
+            addRef.emplace_back(wr*stride);
+            details::addsubScalar(addRef.back().data(), wr, a.data(), na, b.data(), nb, stride, sub!=0);
+        }
+    }
+
+    std::vector<std::uint64_t> mulRef((na+nb)*stride);
+    details::mulScalar(mulRef.data(), a.data(), na, b.data(), nb, stride);
+
+    std::vector<int> cmpRef(n);
+    details::compareScalar(cmpRef.data(), n, a.data(), na, b.data(), nb, stride);
+
+    // Итог scalar - тот же, что у BigIntBatch (а он проверен против BigInt)
+    const BigIntBatch prod = a*b;
+    checkCondition(nTotal, nPassed, batchName("scalar * vs batch", n, wa, wb, 0), std::equal(mulRef.begin(), mulRef.end(), prod.data()));
+
+    auto checkTier = [&](const char *tierName, auto addsubFn, auto mulFn, auto compareFn)
+    {
+        const std::string tier = tierName;
+
+        std::size_t idx = 0;
+        for(auto wr : addWidths)
+        {
+            for(int sub=0; sub!=2; ++sub, ++idx)
+            {
+                std::vector<std::uint64_t> r(wr*stride, 0xDEADBEEFu);
+                addsubFn(r.data(), wr, a.data(), na, b.data(), nb, stride, sub!=0);
+                checkCondition(nTotal, nPassed, batchName((tier + (sub ? " sub" : " add")).c_str(), n, wa, wb, wr), r==addRef[idx]);
+            }
+        }
+
+        std::vector<std::uint64_t> r((na+nb)*stride, 0xDEADBEEFu);
+        mulFn(r.data(), a.data(), na, b.data(), nb, stride);
+        checkCondition(nTotal, nPassed, batchName((tier + " mul").c_str(), n, wa, wb, 0), r==mulRef);
+
+        std::vector<int> c(n, 5);
+        compareFn(c.data(), n, a.data(), na, b.data(), nb, stride);
+        checkCondition(nTotal, nPassed, batchName((tier + " compare").c_str(), n, wa, wb, 0), c==cmpRef);
+    };
+
+#if defined(MARTY_BIGINT_BATCH_SIMD)
+
+    if (marty::bigint_limbs::details::cpuHasAvx2())
+        checkTier("avx2", details::addsubAvx2, details::mulAvx2, details::compareAvx2);
+
+    if (marty::bigint_limbs::details::cpuHasAvx512f())
+        checkTier("avx512", details::addsubAvx512, details::mulAvx512, details::compareAvx512);
+
+#else
+
+    MARTY_ARG_USED(checkTier);
+
+#endif
+}
+
+
+
+int unsafeMain(int argc, char* argv[])
+{
+    MARTY_ARG_USED(argc);
+    MARTY_ARG_USED(argv);
+
+    std::cout << "BigInt chunk size: " << sizeof(marty::BigInt::chunk_type) << "\n" << std::flush;
+
+#if defined(MARTY_BIGINT_BATCH_SIMD)
+    std::cout << "Kernel tiers: scalar"
+              << (marty::bigint_limbs::details::cpuHasAvx2()    ? ", avx2"   : "")
+              << (marty::bigint_limbs::details::cpuHasAvx512f() ? ", avx512" : "")
+              << "\n";
+#else
+    std::cout << "Kernel tiers: scalar\n";
+#endif
+
+    std::cout << "-------------------------\n\n" << std::flush;
+
+    int nTest   = 0;
+    int nPassed = 0;
+
+    std::mt19937_64 rng(0x62617463u);
+
+    // Размеры не кратны laneBlock (хвосты AVX2 и AVX-512), кроме 16
+    const std::size_t sizes[] = { 1, 3, 4, 5, 7, 9, 12, 13, 16, 17, 31, 33 };
+    const std::pair<std::size_t, std::size_t> widths[] = { { 1, 1 }, { 1, 3 }, { 3, 1 }, { 2, 5 }, { 4, 4 }, { 7, 2 }, { 12, 9 } };
+
+    for(auto n : sizes)
+    {
+        for(auto w : widths)
+        {
+            testBatchOps   (nTest, nPassed, rng, n, w.first, w.second);
+            testKernelTiers(nTest, nPassed, rng, n, w.first, w.second);
+        }
+    }
+
+    testBatchErrors(nTest, nPassed);
+
+    int nFailed = nTest - nPassed;
+
+    std::cout << "\n\nTotal tests: " << nTest << ", passed: " << nPassed << ", failed: " << nFailed << "\n\n";
+
+    return nFailed ? 1 : 0;
+}
@@ -0,0 +1,9 @@
+/*! \file
+    \brief Тестим marty::BigIntBatch с дефолтным для текущей системы размером чанка (обычно std::uint32_t)
+ */
+
+#ifdef MARTY_BIGINT_FORCE_NUMBER_UNDERLYING_TYPE
+    #undef MARTY_BIGINT_FORCE_NUMBER_UNDERLYING_TYPE
+#endif
+
+#include "batch-test-impl.cpp"
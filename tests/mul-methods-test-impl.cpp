@@ -0,0 +1,299 @@
+/*! \file
+    \brief Сверяем все методы умножения marty::BigInt с умножением "столбиком" (school)
+ */
+
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+//
+#include "marty_bigint/marty_bigint.h"
+
+#include <windows.h>
+
+#include "marty_bigint/undef_min_max.h"
+
+
+
+using marty::BigInt;
+
+
+int unsafeMain(int argc, char* argv[]);
+
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        return unsafeMain(argc, argv);
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    catch(...)
+    {
+        std::cerr << "unknown error\n";
+        return 2;
+    }
+
+}
+
+
+//----------------------------------------------------------------------------
+const std::array<BigInt::MultiplicationMethod, 7> testedMethods =
+{ BigInt::MultiplicationMethod::karatsuba
+, BigInt::MultiplicationMethod::comba
+, BigInt::MultiplicationMethod::toom3
+, BigInt::MultiplicationMethod::toom4
+, BigInt::MultiplicationMethod::ntt
+, BigInt::MultiplicationMethod::fft
+, BigInt::MultiplicationMethod::auto_
+};
+
+//----------------------------------------------------------------------------
+// Число из n чанков со старшим чанком не ноль. kind: 0 - случайные чанки, 1 - все биты
+// единицы (максимум переносов), 2 - почти все чанки нулевые
+inline
+BigInt makeNumber(std::mt19937_64 &rng, std::size_t n, int kind)
+{
+    using chunk_type = BigInt::chunk_type;
+
+    std::vector<chunk_type> chunks(n);
+    for(auto &c : chunks)
+    {
+        switch(kind)
+        {
+            case 1 : c = chunk_type(~chunk_type(0)); break;
+            case 2 : c = (rng()%8u)==0 ? chunk_type(rng()) : chunk_type(0); break;
+            default: c = chunk_type(rng());
+        }
+    }
+
+    if (chunks[n-1u]==0)
+        chunks[n-1u] = 1;
+
+    return BigInt::fromChunks((rng()&1u) ? 1 : -1, chunks.data(), n);
+}
+
+//----------------------------------------------------------------------------
+inline
+bool checkResult(int &nTotal, int &nPassed, const char *what, BigInt::MultiplicationMethod mm, std::size_t an, std::size_t bn, const BigInt &res, const BigInt &expected)
+{
+    const bool bGood = res==expected;
+
+    ++nTotal;
+    if (bGood)
+    {
+        ++nPassed;
+    }
+    else
+    {
+        std::cout << "[-]   " << what << " " << an << " x " << bn << " chunks (" << BigInt::getMultiplicationMethodName(mm) << ") - failed\n" << std::flush;
+    }
+
+    return bGood;
+}
+
+//----------------------------------------------------------------------------
+// a*b и a^2 всеми методами против school
+inline
+void testMulPair(int &nTotal, int &nPassed, const BigInt &a, const BigInt &b)
+{
+    const BigInt::MultiplicationMethod prevMethod = BigInt::setMultiplicationMethod(BigInt::MultiplicationMethod::school);
+    const BigInt expectedMul = a*b;
+    const BigInt expectedSqr = a*BigInt(a);
+
+    for(auto mm : testedMethods)
+    {
+        BigInt::setMultiplicationMethod(mm);
+        checkResult(nTotal, nPassed, "mul", mm, a.chunksSize(), b.chunksSize(), a*b, expectedMul);
+        checkResult(nTotal, nPassed, "mul", mm, b.chunksSize(), a.chunksSize(), b*a, expectedMul);
+        checkResult(nTotal, nPassed, "sqr", mm, a.chunksSize(), a.chunksSize(), a.sqr(), expectedSqr);
+    }
+
+    BigInt::setMultiplicationMethod(prevMethod);
+}
+
+//----------------------------------------------------------------------------
+// Размеры вокруг порогов: t-1, t, t+1, а также 2t и 3t - там рекурсия переходит порог на
+// следующем уровне. Пары - равной длины и несбалансированные (короткий - 1, 2, n/3, n/2, n-1)
+inline
+void testThresholdBoundaries(int &nTotal, int &nPassed, std::mt19937_64 &rng, const BigInt::mul_thresholds &th, std::size_t maxSize)
+{
+    std::vector<std::size_t> sizes;
+    for(std::size_t n=1; n<=16 && n<=maxSize; ++n)
+        sizes.push_back(n);
+
+    const std::size_t thresholds[] = { th.karatsuba, th.sqrKaratsuba, th.toom3, th.toom4, th.toom32, th.fft, th.ntt };
+    for(auto t : thresholds)
+    {
+        const std::size_t candidates[] = { t-1u, t, t+1u, 2u*t-1u, 2u*t, 2u*t+1u, 3u*t, 3u*t+1u };
+        for(auto n : candidates)
+        {
+            if (n>0 && n<=maxSize)
+                sizes.push_back(n);
+        }
+    }
+
+    int kind = 0;
+    for(auto n : sizes)
+    {
+        const std::size_t shortSizes[] = { n, n-1u, n/2u, n/3u, 2u, 1u };
+        for(auto m : shortSizes)
+        {
+            if (m==0 || m>n)
+                continue;
+
+            testMulPair(nTotal, nPassed, makeNumber(rng, n, kind), makeNumber(rng, m, (kind+1)%3));
+            kind = (kind+1)%3;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Произведение по модулю нескольких простых - проверка для размеров, где school слишком медленный
+inline
+bool checkByResidues(const BigInt &a, const BigInt &b, const BigInt &res)
+{
+    const std::uint32_t primes[] = { 2147483647u, 2147483629u, 2147483587u, 4294967291u };
+    for(auto p : primes)
+    {
+        const BigInt bp = BigInt(p);
+        if (res%bp != (a%bp)*(b%bp)%bp)
+            return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------
+inline
+std::size_t fftWorkSize(std::size_t an, std::size_t bn)
+{
+    return marty::bigint_limbs::fftWorkSize<BigInt::chunk_type>(an, bn);
+}
+
+//----------------------------------------------------------------------------
+// Наименьшая длина длинного множителя (при коротком bn), для которой fftWorkSize==0, то есть
+// FFT одним куском точности не даёт
+inline
+std::size_t findFftLimit(std::size_t bn, bool balanced)
+{
+    std::size_t hi = 1;
+    while(fftWorkSize(hi, balanced ? hi : bn)!=0)
+        hi *= 2u;
+
+    std::size_t lo = hi/2u;
+    while(lo+1u<hi)
+    {
+        const std::size_t mid = lo + (hi-lo)/2u;
+        if (fftWorkSize(mid, balanced ? mid : bn)!=0)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    return hi;
+}
+
+//----------------------------------------------------------------------------
+// Метод fft там, где fftWorkSize==0: несбалансированные множители идут кусками по длине
+// короткого (moduleChunkedFftMul), сбалансированные - в NTT
+inline
+void testFftFallback(int &nTotal, int &nPassed, std::mt19937_64 &rng)
+{
+    const BigInt::MultiplicationMethod prevMethod = BigInt::setMultiplicationMethod(BigInt::MultiplicationMethod::fft);
+
+    const std::size_t bnShort = 300;
+    const std::size_t anLong  = findFftLimit(bnShort, false);
+    const std::size_t nBal    = findFftLimit(0, true);
+
+    const std::pair<std::size_t, std::size_t> cases[] = { { anLong, bnShort }, { nBal, nBal } };
+    for(auto sz : cases)
+    {
+        const bool chunked = fftWorkSize(sz.second, sz.second)!=0;
+        std::cout << "FFT fallback, " << sz.first << " x " << sz.second << " chunks (" << (chunked ? "chunked FFT" : "NTT") << ")\n" << std::flush;
+
+        const BigInt a = makeNumber(rng, sz.first , 0);
+        const BigInt b = makeNumber(rng, sz.second, 0);
+
+        const BigInt res = a*b;
+
+        ++nTotal;
+        if (checkByResidues(a, b, res))
+            ++nPassed;
+        else
+            std::cout << "[-]   fft fallback " << sz.first << " x " << sz.second << " chunks - failed\n" << std::flush;
+    }
+
+    BigInt::setMultiplicationMethod(prevMethod);
+}
+
+
+
+int unsafeMain(int argc, char* argv[])
+{
+    MARTY_ARG_USED(argc);
+    MARTY_ARG_USED(argv);
+
+    std::cout << "BigInt chunk size: " << sizeof(marty::BigInt::chunk_type) << "\n" << std::flush;
+    std::cout << "-------------------------\n\n" << std::flush;
+
+    int nTest   = 0;
+    int nPassed = 0;
+
+    std::mt19937_64 rng(0x6d756c74u);
+
+    const BigInt::mul_thresholds defaultThresholds = BigInt::getMulThresholds();
+
+    // Пороги снижены, чтобы все переходы между алгоритмами (и рекурсия через несколько
+    // уровней) попадали на размеры, где school ещё быстрый
+    {
+        BigInt::mul_thresholds th;
+        th.karatsuba    = 4;
+        th.sqrKaratsuba = 6;
+        th.toom32       = 6;
+        th.toom3        = 9;
+        th.toom4        = 16;
+        th.ntt          = 40;
+        th.fft          = 48;
+        th.parallel     = defaultThresholds.parallel;
+        BigInt::setMulThresholds(th);
+
+        std::cout << "--- lowered thresholds\n" << std::flush;
+        testThresholdBoundaries(nTest, nPassed, rng, BigInt::getMulThresholds(), 200);
+
+        // То же, но с пулом потоков - верхние уровни рекурсии идут задачами пула
+        BigInt::thread_pool pool(4);
+        BigInt::currentContext().setThreadPool(&pool);
+        th.parallel = 12;
+        BigInt::setMulThresholds(th);
+
+        std::cout << "--- lowered thresholds, thread pool\n" << std::flush;
+        testThresholdBoundaries(nTest, nPassed, rng, BigInt::getMulThresholds(), 200);
+
+        BigInt::currentContext().setThreadPool(nullptr);
+    }
+
+    // Пороги по умолчанию - до FFT включительно, NTT тут слишком далеко для school
+    {
+        BigInt::setMulThresholds(defaultThresholds);
+
+        std::cout << "--- default thresholds\n" << std::flush;
+        testThresholdBoundaries(nTest, nPassed, rng, BigInt::getMulThresholds(), defaultThresholds.fft+1u);
+    }
+
+    testFftFallback(nTest, nPassed, rng);
+
+    int nFailed = nTest - nPassed;
+
+    std::cout << "\n\nTotal tests: " << nTest << ", passed: " << nPassed << ", failed: " << nFailed << "\n\n";
+
+    return nFailed ? 1 : 0;
+}
@@ -3,6 +3,7 @@
  */
 
 #include <array>
+#include <chrono>
 #include <iostream>
 #include <iomanip>
 #include <string>
@@ -15,6 +16,7 @@
 
 //
 #include "marty_bigint/marty_bigint.h"
+#include "marty_bigint/bigint_batch.h"
 
 #include <windows.h>
 
@@ -42,9 +44,9 @@ std::uint32_t getMillisecTick()
             #pragma warning(pop)
         #endif
 
-    #else // Linups users can add native millisec counter getter or new std chrono fns
+    #else
 
-        return 0;
+        return (std::uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 
     #endif
 }
@@ -490,7 +492,17 @@ int unsafeMain(int argc, char* argv[])
 
     std::array<BigInt::MultiplicationMethod, 4> mMethods = { BigInt::MultiplicationMethod::auto_, BigInt::MultiplicationMethod::school, BigInt::MultiplicationMethod::karatsuba, BigInt::MultiplicationMethod::furer };
 
-    std::array<bool, 4> excluded = { false,false,false,false };
+    // Последний вариант - те же произведения соседних чисел пачкой BigIntBatch (упаковка
+    // в пачку и распаковка результатов - вне замера)
+    constexpr const std::size_t nVariants = 5;
+    const std::size_t batchIdx = mMethods.size();
+
+    auto variantName = [&](std::size_t idx) -> std::string
+    {
+        return idx==batchIdx ? std::string("batch") : std::string(BigInt::getMultiplicationMethodName(mMethods[idx]));
+    };
+
+    std::array<bool, nVariants> excluded = { false,false,false,false,false };
     
 
     std::size_t idx = 0;
@@ -520,18 +532,14 @@ int unsafeMain(int argc, char* argv[])
                       ;
         }
 
-        std::array<std::uint32_t, 4> ticksElapsed = { 0,0,0,0 };
-        std::array<BigInt::chunk_type, 4> calculatedChunks = { 0,0,0,0 };
-        std::array<unsigned, 4> calculatedPercents = { 0,0,0,0 };
+        std::array<std::uint32_t, nVariants> ticksElapsed = { 0,0,0,0,0 };
+        std::array<BigInt::chunk_type, nVariants> calculatedChunks = { 0,0,0,0,0 };
+        std::array<unsigned, nVariants> calculatedPercents = { 0,0,0,0,0 };
         
 
         std::size_t methodIdx = 0;
-        for(; methodIdx!=mMethods.size(); ++methodIdx)
+        for(; methodIdx!=nVariants; ++methodIdx)
         {
-            auto mm = mMethods[methodIdx];
-
-            BigInt::setMultiplicationMethod(mm);
-
             // BigInt::chunk_type counter = 0;
 
             if (excluded[methodIdx])
@@ -539,16 +547,36 @@ int unsafeMain(int argc, char* argv[])
                 calculatedPercents[methodIdx] = unsigned(-1);
                 continue;
             }
-            
-            std::uint32_t startTick = getMillisecTick();
-            std::vector<BigInt>::const_iterator it1 = v.begin();
-            std::vector<BigInt>::const_iterator it2 = v.begin(); ++it2; // у нас вектора большие, проблем нет
-            for(; it2!=v.end(); ++it1, ++it2)
+
+            std::uint32_t elapsed = 0;
+
+            if (methodIdx==batchIdx)
+            {
+                const marty::BigIntBatch batch1(v.begin(), v.end()-1);
+                const marty::BigIntBatch batch2(v.begin()+1, v.end());
+
+                std::uint32_t startTick = getMillisecTick();
+                const marty::BigIntBatch prod = batch1 * batch2;
+                elapsed = getMillisecTick() - startTick;
+
+                for(std::size_t i=0; i!=prod.size(); ++i)
+                    calculatedChunks[methodIdx] += prod.get(i).getHighChunk();
+            }
+            else
             {
-                calculatedChunks[methodIdx] += (*it1 * *it2).getHighChunk();
+                BigInt::setMultiplicationMethod(mMethods[methodIdx]);
+
+                std::uint32_t startTick = getMillisecTick();
+                std::vector<BigInt>::const_iterator it1 = v.begin();
+                std::vector<BigInt>::const_iterator it2 = v.begin(); ++it2; // у нас вектора большие, проблем нет
+                for(; it2!=v.end(); ++it1, ++it2)
+                {
+                    calculatedChunks[methodIdx] += (*it1 * *it2).getHighChunk();
+                }
+
+                elapsed = getMillisecTick() - startTick;
             }
 
-            auto elapsed = getMillisecTick() - startTick;
             ticksElapsed[methodIdx] = elapsed;
 
             if (!bCsv)
@@ -598,7 +626,7 @@ int unsafeMain(int argc, char* argv[])
 
         // std::size_t 
         methodIdx = 0;
-        for(; methodIdx!=mMethods.size(); ++methodIdx)
+        for(; methodIdx!=nVariants; ++methodIdx)
         {
             if (!bCsv)
             {
@@ -609,7 +637,7 @@ int unsafeMain(int argc, char* argv[])
 
             if (!bCsv)
             {
-                std::cout << BigInt::getMultiplicationMethodName(mMethods[methodIdx]) << ": ";
+                std::cout << variantName(methodIdx) << ": ";
             }
 
             if (excluded[methodIdx])
@@ -638,7 +666,7 @@ int unsafeMain(int argc, char* argv[])
                 std::cout << "  ";
             }
 
-            if (methodIdx!=(mMethods.size()-1))
+            if (methodIdx!=(nVariants-1))
             {
                 if (bCsv)
                    std::cout << ";";
@@ -82,10 +82,11 @@ int main(int argc, char* argv[])
 
 }
 
+// "---" в начале знака операции - результат не сравнивается
 inline
 bool isIgnoreResultOpSign(const std::string &s)
 {
-    return s.size()>=3;
+    return s.compare(0, 3, "---")==0;
 }
 
 inline
@@ -335,6 +336,538 @@ bool testBigIntInvert(int &nTotal, int &nPassed, std::int64_t i1, std::int64_t i
                   );
 }
 
+inline
+bool testBigIntLess(int &nTotal, int &nPassed, std::int64_t i1, std::int64_t i2)
+{
+    return
+    testBigIntImpl( nTotal, nPassed, i1, i2
+                  , [](std::int64_t &iRes, marty::BigInt &bRes, std::int64_t &i1, std::int64_t &i2) -> std::string
+                    {
+                        iRes = i1 < i2 ? 1 : 0;
+                        bRes = marty::BigInt(i1) < marty::BigInt(i2) ? 1 : 0;
+                        return "<";
+                    }
+                  );
+}
+
+inline
+bool testBigIntGreater(int &nTotal, int &nPassed, std::int64_t i1, std::int64_t i2)
+{
+    return
+    testBigIntImpl( nTotal, nPassed, i1, i2
+                  , [](std::int64_t &iRes, marty::BigInt &bRes, std::int64_t &i1, std::int64_t &i2) -> std::string
+                    {
+                        iRes = i1 > i2 ? 1 : 0;
+                        bRes = marty::BigInt(i1) > marty::BigInt(i2) ? 1 : 0;
+                        return ">";
+                    }
+                  );
+}
+
+inline
+bool testBigIntAddmul(int &nTotal, int &nPassed, std::int64_t i1, std::int64_t i2)
+{
+    return
+    testBigIntImpl( nTotal, nPassed, i1, i2
+                  , [](std::int64_t &iRes, marty::BigInt &bRes, std::int64_t &i1, std::int64_t &i2) -> std::string
+                    {
+                        iRes = i2 + i1*i2;
+                        bRes = marty::BigInt(i2);
+                        bRes.addmul(marty::BigInt(i1), marty::BigInt(i2));
+                        return "+*="; // i2 += i1*i2
+                    }
+                  );
+}
+
+inline
+bool testBigIntSubmul(int &nTotal, int &nPassed, std::int64_t i1, std::int64_t i2)
+{
+    return
+    testBigIntImpl( nTotal, nPassed, i1, i2
+                  , [](std::int64_t &iRes, marty::BigInt &bRes, std::int64_t &i1, std::int64_t &i2) -> std::string
+                    {
+                        iRes = i2 - i1*i2;
+                        bRes = marty::BigInt(i2);
+                        bRes.submul(marty::BigInt(i1), marty::BigInt(i2));
+                        return "-*="; // i2 -= i1*i2
+                    }
+                  );
+}
+
+inline
+bool testBigIntFma(int &nTotal, int &nPassed, std::int64_t i1, std::int64_t i2)
+{
+    return
+    testBigIntImpl( nTotal, nPassed, i1, i2
+                  , [](std::int64_t &iRes, marty::BigInt &bRes, std::int64_t &i1, std::int64_t &i2) -> std::string
+                    {
+                        iRes = i1*i2 - i1;
+                        bRes = marty::fma(marty::BigInt(i1), marty::BigInt(i2), marty::BigInt(-i1));
+                        return "fma"; // i1*i2 + (-i1)
+                    }
+                  );
+}
+
+//! Аккумулятор - он же множитель: a.addmul(a, b), a.addmul(a, a), a.submul(a, a)
+inline
+bool testBigIntAddmulAliasing(int &nTotal, int &nPassed, std::int64_t i1, std::int64_t i2)
+{
+    bool bGood = true;
+
+    bGood &= testBigIntImpl( nTotal, nPassed, i1, i2
+                           , [](std::int64_t &iRes, marty::BigInt &bRes, std::int64_t &i1, std::int64_t &i2) -> std::string
+                             {
+                                 iRes = i1 + i1*i2;
+                                 bRes = marty::BigInt(i1);
+                                 bRes.addmul(bRes, marty::BigInt(i2));
+                                 return "+*a"; // a=i1; a += a*i2
+                             }
+                           );
+
+    bGood &= testBigIntImpl( nTotal, nPassed, i1, i2
+                           , [](std::int64_t &iRes, marty::BigInt &bRes, std::int64_t &i1, std::int64_t &i2) -> std::string
+                             {
+                                 i2   = i1;
+                                 iRes = i1 + i1*i1;
+                                 bRes = marty::BigInt(i1);
+                                 bRes.addmul(bRes, bRes);
+                                 return "+aa"; // a=i1; a += a*a
+                             }
+                           );
+
+    bGood &= testBigIntImpl( nTotal, nPassed, i1, i2
+                           , [](std::int64_t &iRes, marty::BigInt &bRes, std::int64_t &i1, std::int64_t &i2) -> std::string
+                             {
+                                 i2   = i1;
+                                 iRes = i1 - i1*i1;
+                                 bRes = marty::BigInt(i1);
+                                 bRes.submul(bRes, bRes);
+                                 return "-aa"; // a=i1; a -= a*a
+                             }
+                           );
+
+    return bGood;
+}
+
+//----------------------------------------------------------------------------
+//! Проверка тождества над многочанковыми числами, где int64 уже не хватает
+inline
+bool testBigIntCheck(int &nTotal, int &nPassed, const std::string &what, const marty::BigInt &res, const marty::BigInt &expected)
+{
+    using std::to_string;
+
+    const bool bGood = res==expected;
+
+    std::cout << mkMarker(bGood, false) << what;
+    if (bGood)
+        std::cout << " - passed\n" << std::flush;
+    else
+        std::cout << " - failed, result: " << to_string(res) << ", expected: " << to_string(expected) << "\n" << std::flush;
+
+    ++nTotal;
+
+    if (bGood)
+       ++nPassed;
+
+    return bGood;
+}
+
+//! Число из i1 и i2, растянутое сдвигом на несколько чанков
+inline
+marty::BigInt makeLongBigInt(std::int64_t i1, std::int64_t i2, int shift)
+{
+    return (marty::BigInt(i1)<<shift) + marty::BigInt(i2);
+}
+
+//! addmul/submul/fma многочанковых чисел против c + a*b: короткий множитель (строки
+//! addmul_1/submul_1 в аккумулятор), длинный (от порога Карацубы), смена знака аккумулятора
+inline
+void testBigAddmul(int &nTotal, int &nPassed, std::int64_t i1, std::int64_t i2)
+{
+    using std::to_string;
+
+    const int shifts[] = { 0, 40, 130, 700, 2100 };
+    for(auto sa : shifts)
+    {
+        for(auto sb : shifts)
+        {
+            const marty::BigInt a = makeLongBigInt(i1, i2, sa);
+            const marty::BigInt b = makeLongBigInt(i2, -i1, sb);
+            const marty::BigInt c = makeLongBigInt(i2, i1, sa+sb/2);
+
+            const std::string sz = " (" + to_string(sa) + ", " + to_string(sb) + ")";
+
+            marty::BigInt r = c;
+            r.addmul(a, b);
+            testBigIntCheck(nTotal, nPassed, "c.addmul(a, b)" + sz, r, c + a*b);
+
+            r = c;
+            r.submul(a, b);
+            testBigIntCheck(nTotal, nPassed, "c.submul(a, b)" + sz, r, c - a*b);
+
+            // Аккумулятор меньше произведения и противоположного знака - результат меняет знак
+            r = marty::BigInt(i1);
+            r.submul(a, b);
+            testBigIntCheck(nTotal, nPassed, "i1.submul(a, b)" + sz, r, marty::BigInt(i1) - a*b);
+
+            testBigIntCheck(nTotal, nPassed, "fma(a, b, c)" + sz, marty::fma(a, b, c), a*b + c);
+
+            r = a;
+            r.addmul(r, r);
+            testBigIntCheck(nTotal, nPassed, "a.addmul(a, a)" + sz, r, a + a*a);
+
+            r = a;
+            r.submul(b, r);
+            testBigIntCheck(nTotal, nPassed, "a.submul(b, a)" + sz, r, a - b*a);
+        }
+    }
+}
+
+//! Степень против произведения exp множителей
+inline
+marty::BigInt powByMul(const marty::BigInt &a, unsigned exp)
+{
+    marty::BigInt res = 1;
+    for(unsigned i=0; i!=exp; ++i)
+        res *= a;
+    return res;
+}
+
+//! pow: нечётное, чётное (хвостовые нули уходят в сдвиг) и отрицательное основание, чистая
+//! степень двойки (только сдвиг), 0 и 1. Прогон текущим методом и auto_ - и через
+//! moduleSqr/moduleMul, и в заранее выделенных буферах
+inline
+void testBigPow(int &nTotal, int &nPassed, std::int64_t i1, std::int64_t i2)
+{
+    using std::to_string;
+
+    const std::array<marty::BigInt::MultiplicationMethod, 2> methods = { marty::BigInt::getMultiplicationMethod(), marty::BigInt::MultiplicationMethod::auto_ };
+    const marty::BigInt::MultiplicationMethod prevMethod = methods[0];
+
+    const unsigned exps[] = { 0, 1, 2, 3, 5, 8, 13, 32 };
+    const int      shifts[] = { 0, 40, 130, 700, 2100 };
+
+    for(auto mm : methods)
+    {
+        marty::BigInt::setMultiplicationMethod(mm);
+        const std::string mmName = std::string(" (") + marty::BigInt::getMultiplicationMethodName() + ")";
+
+        for(auto sh : shifts)
+        {
+            const std::pair<const char*, marty::BigInt> bases[] =
+                { { "i1<<sh + i2"     , makeLongBigInt(i1, i2, sh)                   }
+                , { "(i1<<sh)*6"      , makeLongBigInt(i1, 0, sh) * marty::BigInt(6) } // чётное
+                , { "sign(i1)<<(sh+3)", marty::BigInt(i1<0 ? -1 : 1)<<(sh+3)         } // степень двойки
+                };
+            for(const auto &a : bases)
+            {
+                for(auto e : exps)
+                {
+                    // Длинные основания - только с малыми степенями, иначе произведение слишком долгое
+                    if (sh>700 && e>13)
+                        continue;
+
+                    const std::string what = "(" + std::string(a.first) + ").pow(" + to_string(e) + "), i1=" + to_string(i1) + ", i2=" + to_string(i2) + ", sh=" + to_string(sh) + mmName;
+                    testBigIntCheck(nTotal, nPassed, what, a.second.pow(e), powByMul(a.second, e));
+                }
+            }
+        }
+
+        testBigIntCheck(nTotal, nPassed, "0.pow(0)"  + mmName, marty::BigInt(0).pow(0) , marty::BigInt(1));
+        testBigIntCheck(nTotal, nPassed, "0.pow(5)"  + mmName, marty::BigInt(0).pow(5) , marty::BigInt(0));
+        testBigIntCheck(nTotal, nPassed, "-1.pow(7)" + mmName, marty::BigInt(-1).pow(7), marty::BigInt(-1));
+        testBigIntCheck(nTotal, nPassed, "-1.pow(8)" + mmName, marty::BigInt(-1).pow(8), marty::BigInt(1));
+    }
+
+    marty::BigInt::setMultiplicationMethod(prevMethod);
+}
+
+//! Частное и остаток a/b, a%b: a == q*b + r, |r| < |b|, знак r - как у a (или r - ноль)
+inline
+bool testBigIntDivResult(int &nTotal, int &nPassed, const std::string &what, const marty::BigInt &a, const marty::BigInt &b, const marty::BigInt &q, const marty::BigInt &r)
+{
+    using std::to_string;
+
+    const marty::BigInt absR = r.sign()<0 ? -r : r;
+    const marty::BigInt absB = b.sign()<0 ? -b : b;
+
+    const bool bIdentity = q*b + r == a;
+    const bool bRange    = absR < absB;
+    const bool bSign     = r.sign()==0 || r.sign()==a.sign();
+    const bool bGood     = bIdentity && bRange && bSign;
+
+    std::cout << mkMarker(bGood, false) << what;
+    if (bGood)
+        std::cout << " - passed\n" << std::flush;
+    else
+        std::cout << " - failed" << (bIdentity ? "" : ", a != q*b + r") << (bRange ? "" : ", |r| >= |b|") << (bSign ? "" : ", sign(r) != sign(a)")
+                  << ", a: " << to_string(a) << ", b: " << to_string(b) << ", q: " << to_string(q) << ", r: " << to_string(r) << "\n" << std::flush;
+
+    ++nTotal;
+
+    if (bGood)
+       ++nPassed;
+
+    return bGood;
+}
+
+//! a/b и a%b во всех комбинациях знаков
+inline
+void testBigIntDivSigns(int &nTotal, int &nPassed, const std::string &what, const marty::BigInt &a, const marty::BigInt &b)
+{
+    const int signs[] = { 1, -1 };
+    for(auto sa : signs)
+    {
+        for(auto sb : signs)
+        {
+            const marty::BigInt x = sa<0 ? -a : a;
+            const marty::BigInt y = sb<0 ? -b : b;
+            testBigIntDivResult(nTotal, nPassed, what + (sa<0 ? ", -a" : ", +a") + (sb<0 ? "/-b" : "/+b"), x, y, x/y, x%y);
+        }
+    }
+}
+
+//! Многочанковое деление (алгоритм D): делители разной длины, делитель со старшим чанком
+//! ровно B/2 (нормализация сдвигом на один бит) и B-1 (без сдвига), делимые, на которых
+//! оценка цифры частного завышена и нужно обратное сложение. B - основание чанка, так что
+//! для восьмибитного чанка те же случаи - на числах в несколько байт
+inline
+void testBigDiv(int &nTotal, int &nPassed, std::int64_t i1, std::int64_t i2)
+{
+    using std::to_string;
+    using chunk_type = marty::BigInt::chunk_type;
+
+    const int cb = int(sizeof(chunk_type)*CHAR_BIT);
+
+    const int shifts[] = { 0, 40, 130, 700, 2100 };
+    for(auto sa : shifts)
+    {
+        for(auto sb : shifts)
+        {
+            if (sb>sa)
+                continue;
+
+            const marty::BigInt a = makeLongBigInt(i1, i2, sa);
+            const marty::BigInt b = makeLongBigInt(i2, i1, sb);
+            testBigIntDivSigns(nTotal, nPassed, "long div, sh=(" + to_string(sa) + ", " + to_string(sb) + ")", a*b + makeLongBigInt(i1, i2, sb/2), b);
+            testBigIntDivSigns(nTotal, nPassed, "long div, a/b, sh=(" + to_string(sa) + ", " + to_string(sb) + ")", a, b);
+        }
+    }
+
+    const marty::BigInt low = marty::BigInt(i2<0 ? -i2 : i2);
+
+    const int limbCounts[] = { 2, 3, 5, 17 };
+    for(auto k : limbCounts)
+    {
+        const marty::BigInt half   = marty::BigInt(1)<<(k*cb-1);                  // старший чанк - B/2
+        const marty::BigInt maxTop = (marty::BigInt(1)<<(k*cb))-1;                // старший чанк - B-1
+        const marty::BigInt lowK   = low % (marty::BigInt(1)<<((k-1)*cb));        // старший чанк не трогает
+
+        const marty::BigInt divisors[] = { half, half + lowK, half + (marty::BigInt(1)<<((k-1)*cb)) - 1, maxTop, maxTop - lowK };
+        for(const auto &d : divisors)
+        {
+            const std::string dName = ", k=" + to_string(k) + ", d=" + to_string(d);
+            testBigIntDivSigns(nTotal, nPassed, "top B/2 or B-1, d*d-1"      + dName, d*d - 1, d);
+            testBigIntDivSigns(nTotal, nPassed, "top B/2 or B-1, d*i1+i2"    + dName, d*marty::BigInt(i1) + low, d);
+            testBigIntDivSigns(nTotal, nPassed, "top B/2 or B-1, long*d-1"   + dName, makeLongBigInt(i1, i2, 300)*d - 1, d);
+            testBigIntDivSigns(nTotal, nPassed, "top B/2 or B-1, B^3*d-1"    + dName, (d<<(3*cb)) - 1, d);
+        }
+    }
+
+    // Обратное сложение: u = (0, 0, B/2, B/2-1), v = (1, 0, B/2) и u = (3, 0, B/2), v = (1, 0, B/8)
+    // (младшие чанки первыми) - оценка по двум чанкам проходит, а вычитание даёт заём. Оба
+    // случая сдвинуты на k чанков, младшие чанки делимого заполнены
+    {
+        const chunk_type h = chunk_type(chunk_type(1)<<(cb-1));
+
+        const chunk_type u1[] = { 0, 0, h, chunk_type(h-1u) };
+        const chunk_type v1[] = { 1, 0, h };
+        const chunk_type u2[] = { 3, 0, h };
+        const chunk_type v2[] = { 1, 0, chunk_type(h>>2) };
+
+        const marty::BigInt bu1 = marty::BigInt::fromChunks(1, u1, 4);
+        const marty::BigInt bv1 = marty::BigInt::fromChunks(1, v1, 3);
+        const marty::BigInt bu2 = marty::BigInt::fromChunks(1, u2, 3);
+        const marty::BigInt bv2 = marty::BigInt::fromChunks(1, v2, 3);
+
+        const int ks[] = { 0, 1, 3 };
+        for(auto k : ks)
+        {
+            const marty::BigInt lowMax = (marty::BigInt(1)<<(k*cb)) - 1; // младшие k чанков - все единицы
+            const marty::BigInt lowAny = low % (lowMax + 1);
+
+            const std::string kName = ", k=" + to_string(k);
+            testBigIntDivSigns(nTotal, nPassed, "add back #1"        + kName, bu1<<(k*cb), bv1<<(k*cb));
+            testBigIntDivSigns(nTotal, nPassed, "add back #1, low"   + kName, (bu1<<(k*cb)) + lowMax, (bv1<<(k*cb)) + lowAny/2);
+            testBigIntDivSigns(nTotal, nPassed, "add back #2"        + kName, bu2<<(k*cb), bv2<<(k*cb));
+            testBigIntDivSigns(nTotal, nPassed, "add back #2, low"   + kName, (bu2<<(k*cb)) + lowAny, bv2<<(k*cb));
+        }
+    }
+}
+
+//! divMod против int64: частное к нулю, знак остатка - как у делимого
+inline
+bool testBigIntDivMod(int &nTotal, int &nPassed, std::int64_t i1, std::int64_t i2)
+{
+    bool bGood = true;
+
+    bGood &= testBigIntImpl( nTotal, nPassed, i1, i2
+                           , [](std::int64_t &iRes, marty::BigInt &bRes, std::int64_t &i1, std::int64_t &i2) -> std::string
+                             {
+                                 iRes = i1/i2;
+                                 bRes = marty::BigInt::divMod(marty::BigInt(i1), marty::BigInt(i2)).first;
+                                 return "divMod.q";
+                             }
+                           );
+
+    bGood &= testBigIntImpl( nTotal, nPassed, i1, i2
+                           , [](std::int64_t &iRes, marty::BigInt &bRes, std::int64_t &i1, std::int64_t &i2) -> std::string
+                             {
+                                 iRes = i1%i2;
+                                 bRes = marty::BigInt::divMod(marty::BigInt(i1), marty::BigInt(i2)).second;
+                                 return "divMod.r";
+                             }
+                           );
+
+    return bGood;
+}
+
+//! Ожидаем исключение типа E от f
+template<typename E, typename F>
+bool testBigIntThrows(int &nTotal, int &nPassed, const std::string &what, F f)
+{
+    bool bGood = false;
+    try
+    {
+        f();
+    }
+    catch(const E &)
+    {
+        bGood = true;
+    }
+
+    std::cout << mkMarker(bGood, false) << what << (bGood ? " - throws, passed\n" : " - failed, no exception\n") << std::flush;
+
+    ++nTotal;
+
+    if (bGood)
+       ++nPassed;
+
+    return bGood;
+}
+
+//! divMod многочанковых чисел против / и %: в новые объекты, в объекты со старыми значениями
+//! (буферы переиспользуются), q или r - делимое или делитель, делимое и делитель - один объект.
+//! q и r - один объект, деление на ноль - исключения
+inline
+void testBigDivMod(int &nTotal, int &nPassed, std::int64_t i1, std::int64_t i2)
+{
+    using std::to_string;
+
+    const int shifts[] = { 0, 40, 130, 700 };
+    for(auto sa : shifts)
+    {
+        for(auto sb : shifts)
+        {
+            const marty::BigInt a = makeLongBigInt(i1, i2, sa+sb);
+            const marty::BigInt b = makeLongBigInt(i2, i1, sb);
+            const marty::BigInt q = a/b;
+            const marty::BigInt r = a%b;
+
+            const std::string sz = ", sh=(" + to_string(sa+sb) + ", " + to_string(sb) + ")";
+
+            const auto res = marty::BigInt::divMod(a, b);
+            testBigIntCheck(nTotal, nPassed, "divMod(a, b).q" + sz, res.first , q);
+            testBigIntCheck(nTotal, nPassed, "divMod(a, b).r" + sz, res.second, r);
+            testBigIntDivResult(nTotal, nPassed, "divMod(a, b)" + sz, a, b, res.first, res.second);
+
+            // Выходы со старыми значениями длиннее результата
+            marty::BigInt oq  =  makeLongBigInt(i1, i1, 900);
+            marty::BigInt orr = -makeLongBigInt(i2, i2, 1000);
+            marty::BigInt::divMod(a, b, oq, orr);
+            testBigIntCheck(nTotal, nPassed, "divMod(a, b, q, r).q, reused" + sz, oq , q);
+            testBigIntCheck(nTotal, nPassed, "divMod(a, b, q, r).r, reused" + sz, orr, r);
+
+            marty::BigInt x = a;
+            marty::BigInt y;
+            marty::BigInt::divMod(x, b, x, y);
+            testBigIntCheck(nTotal, nPassed, "divMod(a, b, a, r).q" + sz, x, q);
+            testBigIntCheck(nTotal, nPassed, "divMod(a, b, a, r).r" + sz, y, r);
+
+            x = a;
+            marty::BigInt::divMod(x, b, y, x);
+            testBigIntCheck(nTotal, nPassed, "divMod(a, b, q, a).q" + sz, y, q);
+            testBigIntCheck(nTotal, nPassed, "divMod(a, b, q, a).r" + sz, x, r);
+
+            x = b;
+            marty::BigInt::divMod(a, x, x, y);
+            testBigIntCheck(nTotal, nPassed, "divMod(a, b, b, r).q" + sz, x, q);
+            testBigIntCheck(nTotal, nPassed, "divMod(a, b, b, r).r" + sz, y, r);
+
+            x = b;
+            marty::BigInt::divMod(a, x, y, x);
+            testBigIntCheck(nTotal, nPassed, "divMod(a, b, q, b).q" + sz, y, q);
+            testBigIntCheck(nTotal, nPassed, "divMod(a, b, q, b).r" + sz, x, r);
+
+            // Делимое и делитель - один объект, он же частное или остаток
+            x = a;
+            marty::BigInt::divMod(x, x, x, y);
+            testBigIntCheck(nTotal, nPassed, "divMod(a, a, a, r).q" + sz, x, marty::BigInt(1));
+            testBigIntCheck(nTotal, nPassed, "divMod(a, a, a, r).r" + sz, y, marty::BigInt(0));
+
+            x = a;
+            marty::BigInt::divMod(x, x, y, x);
+            testBigIntCheck(nTotal, nPassed, "divMod(a, a, q, a).q" + sz, y, marty::BigInt(1));
+            testBigIntCheck(nTotal, nPassed, "divMod(a, a, q, a).r" + sz, x, marty::BigInt(0));
+        }
+    }
+
+    const marty::BigInt a = makeLongBigInt(i1, i2, 130);
+
+    const auto zeroRes = marty::BigInt::divMod(marty::BigInt(0), a);
+    testBigIntCheck(nTotal, nPassed, "divMod(0, a).q", zeroRes.first , marty::BigInt(0));
+    testBigIntCheck(nTotal, nPassed, "divMod(0, a).r", zeroRes.second, marty::BigInt(0));
+
+    testBigIntThrows<std::invalid_argument>(nTotal, nPassed, "divMod(a, b, q, q)", [&]() { marty::BigInt q; marty::BigInt::divMod(a, marty::BigInt(i2), q, q); });
+    testBigIntThrows<std::overflow_error  >(nTotal, nPassed, "divMod(a, 0)"      , [&]() { marty::BigInt::divMod(a, marty::BigInt(0)); });
+    testBigIntThrows<std::overflow_error  >(nTotal, nPassed, "divMod(a, 0, a, r)", [&]() { marty::BigInt x = a; marty::BigInt y; marty::BigInt::divMod(x, marty::BigInt(0), x, y); });
+}
+
+// Доступ к защищённым операциям над модулями
+struct BigIntModuleOps : public marty::BigInt
+{
+    using marty::BigInt::number_holder_t;
+    using marty::BigInt::moduleSub;
+    using marty::BigInt::moduleSubInplace;
+};
+
+//! Вычитание из модуля большего модуля - исключение, а не молчаливый заём
+inline
+bool testModuleSubUnderflow(int &nTotal, int &nPassed, std::int64_t i1, std::int64_t i2)
+{
+    using std::to_string;
+    using holder_t = BigIntModuleOps::number_holder_t;
+
+    if (i1<0) i1 = -i1;
+    if (i2<0) i2 = -i2;
+    if (i1==i2)
+        return true;
+
+    const marty::BigInt bSmall = std::min(i1, i2);
+    const marty::BigInt bLarge = std::max(i1, i2);
+
+    const holder_t mSmall(bSmall.chunksData(), bSmall.chunksData()+(bSmall.sign()==0 ? 0u : bSmall.chunksSize()));
+    const holder_t mLarge(bLarge.chunksData(), bLarge.chunksData()+bLarge.chunksSize());
+
+    const std::string what = to_string(std::min(i1, i2)) + " -(module) " + to_string(std::max(i1, i2));
+
+    bool bGood = true;
+    bGood &= testBigIntThrows<std::underflow_error>(nTotal, nPassed, what, [&]() { BigIntModuleOps::moduleSub(mSmall, mLarge); });
+    bGood &= testBigIntThrows<std::underflow_error>(nTotal, nPassed, what + " (inplace)", [&]() { holder_t m = mSmall; BigIntModuleOps::moduleSubInplace(m, mLarge); });
+
+    return bGood;
+}
+
 inline void testConversions(std::int64_t i)
 {
     using std::to_string;
@@ -418,6 +951,22 @@ void doTestImpl(int &nTest, int &nPassed, std::int64_t i1, std::int64_t i2)
     testBigIntXor   (nTest, nPassed, i1, i2);
     testBigIntInvert(nTest, nPassed, i1, i2);
 
+    testBigIntLess   (nTest, nPassed, i1, i2);
+    testBigIntGreater(nTest, nPassed, i1, i2);
+
+    testModuleSubUnderflow(nTest, nPassed, i1, i2);
+
+    testBigIntAddmul        (nTest, nPassed, i1, i2);
+    testBigIntSubmul        (nTest, nPassed, i1, i2);
+    testBigIntFma           (nTest, nPassed, i1, i2);
+    testBigIntAddmulAliasing(nTest, nPassed, i1, i2);
+    testBigIntDivMod        (nTest, nPassed, i1, i2);
+
+    testBigAddmul(nTest, nPassed, i1, i2);
+    testBigPow   (nTest, nPassed, i1, i2);
+    testBigDiv   (nTest, nPassed, i1, i2);
+    testBigDivMod(nTest, nPassed, i1, i2);
+
 }
 
 inline
@@ -0,0 +1,202 @@
+/*! \file
+    \brief Тестим режим MARTY_BIGINT_USE_PMR: BigInt аллоцируют через ресурс memory_resource_scope,
+           вне скоупа - через ресурс по умолчанию
+ */
+
+
+#include <cstdint>
+#include <iostream>
+#include <memory_resource>
+#include <string>
+
+//
+#include "marty_bigint/marty_bigint.h"
+
+#include <windows.h>
+
+#include "marty_bigint/undef_min_max.h"
+
+
+#if !defined(MARTY_BIGINT_USE_PMR) || MARTY_BIGINT_USE_PMR==0
+    #error "pmr-test must be built with MARTY_BIGINT_USE_PMR=1"
+#endif
+
+
+using marty::BigInt;
+
+
+int unsafeMain(int argc, char* argv[]);
+
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        return unsafeMain(argc, argv);
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    catch(...)
+    {
+        std::cerr << "unknown error\n";
+        return 2;
+    }
+
+}
+
+
+//----------------------------------------------------------------------------
+//! Ресурс-счётчик поверх new/delete: число аллокаций и неосвобождённые байты
+class counting_resource : public std::pmr::memory_resource
+{
+
+public:
+
+    std::size_t    nAllocs       = 0;
+    std::size_t    nDeallocs     = 0;
+    std::ptrdiff_t bytesInUse    = 0;
+
+protected:
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        ++nAllocs;
+        bytesInUse += std::ptrdiff_t(bytes);
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override
+    {
+        ++nDeallocs;
+        bytesInUse -= std::ptrdiff_t(bytes);
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this==&other;
+    }
+
+}; // class counting_resource
+
+//----------------------------------------------------------------------------
+inline
+bool checkCondition(int &nTotal, int &nPassed, const std::string &what, bool bGood)
+{
+    ++nTotal;
+    if (bGood)
+    {
+        ++nPassed;
+        std::cout << "[+]   " << what << " - passed\n" << std::flush;
+    }
+    else
+    {
+        std::cout << "[-]   " << what << " - failed\n" << std::flush;
+    }
+
+    return bGood;
+}
+
+//----------------------------------------------------------------------------
+//! Числа длиннее встроенного буфера - умножение, деление, степень, строка. Результат - остаток
+//! по малому модулю, чтобы сверить прогоны в разных ресурсах
+inline
+BigInt runWorkload(BigInt *pKeep)
+{
+    const BigInt a = (BigInt(1)<<3000) - BigInt(12345);
+    const BigInt b = (BigInt(1)<<1700) + BigInt(777);
+
+    BigInt p = a*b;
+    p += a.sqr();
+
+    const auto qr = BigInt::divMod(p, b);
+    BigInt s = qr.first.pow(3) - qr.second;
+
+    const std::string str = to_string(s);
+    const BigInt parsed = BigInt(str);
+
+    if (pKeep)
+        *pKeep = parsed;
+
+    return parsed % BigInt(1000000007);
+}
+
+
+
+int unsafeMain(int argc, char* argv[])
+{
+    MARTY_ARG_USED(argc);
+    MARTY_ARG_USED(argv);
+
+    std::cout << "BigInt chunk size: " << sizeof(marty::BigInt::chunk_type) << "\n" << std::flush;
+    std::cout << "-------------------------\n\n" << std::flush;
+
+    int nTest   = 0;
+    int nPassed = 0;
+
+    // Рабочую область потока создаём заранее - её буферы идут в new_delete_resource, а не в
+    // текущий ресурс, и не должны попасть ни в один из счётчиков
+    runWorkload(nullptr);
+
+    counting_resource defaultRes;
+    counting_resource scopedRes;
+    counting_resource innerRes;
+
+    std::pmr::memory_resource *pPrevDefault = std::pmr::set_default_resource(&defaultRes);
+
+    BigInt outer = 1; // создан вне скоупа - аллоцирует через ресурс по умолчанию
+    BigInt expected;
+
+    {
+        BigInt::memory_resource_scope scope(&scopedRes);
+
+        BigInt kept;
+        expected = runWorkload(&kept);
+
+        checkCondition(nTest, nPassed, "scope: allocations go to the scoped resource", scopedRes.nAllocs!=0);
+        checkCondition(nTest, nPassed, "scope: default resource is not used", defaultRes.nAllocs==0);
+        checkCondition(nTest, nPassed, "scope: new BigInt takes the scoped resource", kept.get_allocator().resource()==&scopedRes);
+
+        // Присваивание не переносит аллокатор - outer остаётся в своём ресурсе
+        outer = kept;
+        checkCondition(nTest, nPassed, "scope: assignment keeps the target resource", outer.get_allocator().resource()==&defaultRes && defaultRes.nAllocs!=0);
+
+        // Вложенный скоуп и возврат к внешнему
+        {
+            BigInt::memory_resource_scope innerScope(&innerRes);
+            const BigInt r = runWorkload(nullptr);
+            checkCondition(nTest, nPassed, "nested scope: allocations go to the inner resource", innerRes.nAllocs!=0);
+            checkCondition(nTest, nPassed, "nested scope: same result", r==expected);
+        }
+
+        const BigInt afterInner = (BigInt(1)<<4000) + kept;
+        checkCondition(nTest, nPassed, "nested scope: outer resource restored", afterInner.get_allocator().resource()==&scopedRes);
+    }
+
+    checkCondition(nTest, nPassed, "scope end: everything from the scoped resource freed", scopedRes.bytesInUse==0 && scopedRes.nDeallocs==scopedRes.nAllocs);
+    checkCondition(nTest, nPassed, "scope end: everything from the inner resource freed" , innerRes.bytesInUse==0 && innerRes.nDeallocs==innerRes.nAllocs);
+
+    {
+        const std::size_t scopedAllocs  = scopedRes.nAllocs;
+        const std::size_t defaultAllocs = defaultRes.nAllocs;
+
+        BigInt kept;
+        const BigInt r = runWorkload(&kept);
+
+        checkCondition(nTest, nPassed, "after scope: default resource is used again", defaultRes.nAllocs>defaultAllocs);
+        checkCondition(nTest, nPassed, "after scope: scoped resource is not used", scopedRes.nAllocs==scopedAllocs);
+        checkCondition(nTest, nPassed, "after scope: new BigInt takes the default resource", kept.get_allocator().resource()==&defaultRes);
+        checkCondition(nTest, nPassed, "after scope: same result", r==expected);
+    }
+
+    std::pmr::set_default_resource(pPrevDefault);
+
+    int nFailed = nTest - nPassed;
+
+    std::cout << "\n\nTotal tests: " << nTest << ", passed: " << nPassed << ", failed: " << nFailed << "\n\n";
+
+    return nFailed ? 1 : 0;
+}
@@ -0,0 +1,15 @@
+/*! \file
+    \brief Тестим режим MARTY_BIGINT_USE_PMR с дефолтным для текущей системы размером чанка (обычно std::uint32_t)
+ */
+
+#ifdef MARTY_BIGINT_FORCE_NUMBER_UNDERLYING_TYPE
+    #undef MARTY_BIGINT_FORCE_NUMBER_UNDERLYING_TYPE
+#endif
+
+#ifdef MARTY_BIGINT_USE_PMR
+    #undef MARTY_BIGINT_USE_PMR
+#endif
+
+#define MARTY_BIGINT_USE_PMR 1
+
+#include "pmr-test-impl.cpp"
@@ -0,0 +1,19 @@
+/*! \file
+    \brief Тестим режим MARTY_BIGINT_USE_PMR с чанком std::uint8_t
+ */
+
+#ifdef MARTY_BIGINT_FORCE_NUMBER_UNDERLYING_TYPE
+    #undef MARTY_BIGINT_FORCE_NUMBER_UNDERLYING_TYPE
+#endif
+
+#ifndef MARTY_BIGINT_FORCE_NUMBER_UNDERLYING_TYPE
+    #define MARTY_BIGINT_FORCE_NUMBER_UNDERLYING_TYPE  std::uint8_t
+#endif
+
+#ifdef MARTY_BIGINT_USE_PMR
+    #undef MARTY_BIGINT_USE_PMR
+#endif
+
+#define MARTY_BIGINT_USE_PMR 1
+
+#include "pmr-test-impl.cpp"
@@ -0,0 +1,323 @@
+/*! \file
+    \brief Тестим marty::BigInt::powMod, BarrettReducer и MontgomeryContext против pow и %
+ */
+
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//
+#include "marty_bigint/marty_bigint.h"
+
+#include <windows.h>
+
+#include "marty_bigint/undef_min_max.h"
+
+
+
+using marty::BigInt;
+
+
+int unsafeMain(int argc, char* argv[]);
+
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        return unsafeMain(argc, argv);
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    catch(...)
+    {
+        std::cerr << "unknown error\n";
+        return 2;
+    }
+
+}
+
+
+//----------------------------------------------------------------------------
+inline
+bool checkResult(int &nTotal, int &nPassed, const std::string &what, const BigInt &res, const BigInt &expected)
+{
+    using std::to_string;
+
+    const bool bGood = res==expected;
+
+    ++nTotal;
+    if (bGood)
+    {
+        ++nPassed;
+    }
+    else
+    {
+        std::cout << "[-]   " << what << " - failed, result: " << to_string(res) << ", expected: " << to_string(expected) << "\n" << std::flush;
+    }
+
+    return bGood;
+}
+
+//----------------------------------------------------------------------------
+// Случайное неотрицательное число из n чанков со старшим чанком не ноль
+inline
+BigInt makeNumber(std::mt19937_64 &rng, std::size_t n)
+{
+    using chunk_type = BigInt::chunk_type;
+
+    std::vector<chunk_type> chunks(n);
+    for(auto &c : chunks)
+        c = chunk_type(rng());
+
+    if (chunks[n-1u]==0)
+        chunks[n-1u] = 1;
+
+    return BigInt::fromChunks(1, chunks.data(), n);
+}
+
+//----------------------------------------------------------------------------
+// Остаток в [0, m) - как у powMod и BarrettReducer, % даёт знак делимого
+inline
+BigInt modPositive(const BigInt &a, const BigInt &m)
+{
+    BigInt r = a % m;
+    if (r.sign()<0)
+        r += m;
+    return r;
+}
+
+//----------------------------------------------------------------------------
+inline
+std::string powModName(const BigInt &base, unsigned e, const BigInt &m, BigInt::PowModMethod pm)
+{
+    using std::to_string;
+    return "powMod(" + to_string(base) + ", " + to_string(e) + ", " + to_string(m) + ", "
+         + (pm==BigInt::PowModMethod::fixedWindow ? "fixed" : "sliding") + ")";
+}
+
+//----------------------------------------------------------------------------
+// Модули: 1, 2, степени двойки, B^k (у mu Барретта тогда лишний чанк), нечётные (Монтгомери)
+// и чётные (Барретт) разной длины
+inline
+std::vector<BigInt> makeModuli(std::mt19937_64 &rng)
+{
+    const int chunkBits = int(sizeof(BigInt::chunk_type)*CHAR_BIT);
+
+    std::vector<BigInt> res;
+    res.emplace_back(1);
+    res.emplace_back(2);
+    res.emplace_back(3);
+    res.emplace_back(BigInt(1)<<chunkBits);
+    res.emplace_back(BigInt(1)<<(3*chunkBits));
+    res.emplace_back((BigInt(1)<<(2*chunkBits)) - 1);
+    res.emplace_back((BigInt(1)<<(2*chunkBits)) + 1);
+
+    const std::size_t sizes[] = { 1, 2, 3, 5, 8, 40 }; // 40 - от порога Карацубы, у Барретта быстрое умножение
+    for(auto n : sizes)
+    {
+        BigInt m = makeNumber(rng, n);
+        if (m.getLowChunk()&1u)
+            m += 1; // чётный
+        res.emplace_back(m);
+        res.emplace_back(m+1); // нечётный
+        res.emplace_back(m*BigInt(6)+3);
+    }
+
+    return res;
+}
+
+//----------------------------------------------------------------------------
+// Основания: 0, 1, m-1, m (= 0 mod m), кратное m, m+1 (= 1 mod m), случайное, не приведённое
+// (длиннее модуля) и отрицательные
+inline
+std::vector<BigInt> makeBases(std::mt19937_64 &rng, const BigInt &m)
+{
+    const std::size_t n = m.chunksSize();
+
+    std::vector<BigInt> res;
+    res.emplace_back(0);
+    res.emplace_back(1);
+    res.emplace_back(m-1);
+    res.emplace_back(m);
+    res.emplace_back(m*makeNumber(rng, 2));
+    res.emplace_back(m+1);
+    res.emplace_back(modPositive(makeNumber(rng, n+1u), m));
+    res.emplace_back(makeNumber(rng, 2u*n+3u));
+    res.emplace_back(-modPositive(makeNumber(rng, n), m));
+    res.emplace_back(-makeNumber(rng, 3u*n+1u));
+    res.emplace_back(-(m*BigInt(5)));
+
+    return res;
+}
+
+//----------------------------------------------------------------------------
+inline
+void testPowMod(int &nTotal, int &nPassed, std::mt19937_64 &rng)
+{
+    using std::to_string;
+
+    const unsigned exps[] = { 0, 1, 2, 3, 7, 24, 25, 80, 241 };
+    const BigInt::PowModMethod methods[] = { BigInt::PowModMethod::slidingWindow, BigInt::PowModMethod::fixedWindow };
+
+    for(const auto &m : makeModuli(rng))
+    {
+        for(const auto &base : makeBases(rng, m))
+        {
+            for(auto e : exps)
+            {
+                // pow(base, e) растёт быстро - длинные основания только с малыми степенями
+                if (base.chunksSize()>m.chunksSize() && e>25)
+                    continue;
+
+                const BigInt expected = modPositive(base.pow(e), m);
+                for(auto pm : methods)
+                    checkResult(nTotal, nPassed, powModName(base, e, m, pm), BigInt::powMod(base, BigInt(e), m, pm), expected);
+            }
+        }
+    }
+
+    // Степень длиннее одного чанка - по малой теореме Ферма: a^(p-1) = 1 mod p, a^p = a mod p,
+    // и, раз чётность a^p та же, что у a, a^p = a mod 2p (чётный модуль - Барретт)
+    {
+        const BigInt p = (BigInt(1)<<127) - 1; // простое Мерсенна
+        const BigInt a = makeNumber(rng, 3);
+        for(auto pm : methods)
+        {
+            const std::string suffix = pm==BigInt::PowModMethod::fixedWindow ? ", fixed" : ", sliding";
+            checkResult(nTotal, nPassed, "Fermat a^(p-1) mod p" + suffix, BigInt::powMod(a, p-1, p, pm), BigInt(1));
+            checkResult(nTotal, nPassed, "Fermat a^p mod 2p"    + suffix, BigInt::powMod(a, p, p*2, pm), modPositive(a, p*2));
+        }
+    }
+
+    // Недопустимые аргументы
+    const std::pair<BigInt, BigInt> badArgs[] = { { BigInt(3), BigInt(0) }, { BigInt(3), BigInt(-7) }, { BigInt(-1), BigInt(7) } }; // exp, mod
+    for(const auto &args : badArgs)
+    {
+        bool bGood = false;
+        try
+        {
+            BigInt::powMod(BigInt(2), args.first, args.second);
+        }
+        catch(const std::invalid_argument &)
+        {
+            bGood = true;
+        }
+
+        ++nTotal;
+        if (bGood)
+            ++nPassed;
+        else
+            std::cout << "[-]   powMod(2, " << to_string(args.first) << ", " << to_string(args.second) << ") - failed, no exception\n" << std::flush;
+    }
+}
+
+//----------------------------------------------------------------------------
+// BarrettReducer: числа длиннее 2n чанков (приводятся окнами), отрицательные, диапазоны, mul/sqr
+inline
+void testBarrett(int &nTotal, int &nPassed, std::mt19937_64 &rng)
+{
+    using std::to_string;
+
+    for(const auto &m : makeModuli(rng))
+    {
+        const marty::BarrettReducer br(m);
+        const std::size_t n = br.size();
+
+        std::vector<BigInt> values;
+        const std::size_t lengths[] = { 1, n, 2u*n-1u, 2u*n, 2u*n+1u, 3u*n, 3u*n+1u, 5u*n+3u, 9u*n+2u };
+        for(auto len : lengths)
+        {
+            if (!len)
+                continue;
+            values.emplace_back( makeNumber(rng, len));
+            values.emplace_back(-makeNumber(rng, len));
+        }
+        values.emplace_back(0);
+        values.emplace_back(m);
+        values.emplace_back(-m);
+        values.emplace_back(m*makeNumber(rng, 3u*n));
+
+        for(const auto &a : values)
+        {
+            const std::string name = "BarrettReducer(" + to_string(m) + ")";
+            checkResult(nTotal, nPassed, name + ".reduce(" + to_string(a) + ")", br.reduce(a), modPositive(a, m));
+
+            BigInt r = a;
+            br.reduce(r, r);
+            checkResult(nTotal, nPassed, name + ".reduce(r, r), r=" + to_string(a), r, modPositive(a, m));
+        }
+
+        std::vector<BigInt> reduced(values.size());
+        br.reduce(values.begin(), values.end(), reduced.begin());
+        for(std::size_t i=0; i!=values.size(); ++i)
+            checkResult(nTotal, nPassed, "BarrettReducer(" + to_string(m) + ") range #" + to_string(i), reduced[i], modPositive(values[i], m));
+
+        for(std::size_t i=0; i+1u<reduced.size(); ++i)
+        {
+            checkResult(nTotal, nPassed, "BarrettReducer(" + to_string(m) + ").mul #" + to_string(i), br.mul(reduced[i], reduced[i+1u]), modPositive(reduced[i]*reduced[i+1u], m));
+            checkResult(nTotal, nPassed, "BarrettReducer(" + to_string(m) + ").sqr #" + to_string(i), br.sqr(reduced[i]), modPositive(reduced[i]*reduced[i], m));
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+inline
+void testMontgomery(int &nTotal, int &nPassed, std::mt19937_64 &rng)
+{
+    using std::to_string;
+
+    for(const auto &m : makeModuli(rng))
+    {
+        if (!(m.getLowChunk()&1u) || m==BigInt(1))
+            continue;
+
+        const marty::MontgomeryContext ctx(m);
+        const std::string name = "MontgomeryContext(" + to_string(m) + ")";
+
+        const BigInt a = modPositive(makeNumber(rng, ctx.size()+1u), m);
+        const BigInt b = modPositive(makeNumber(rng, ctx.size()), m);
+
+        const BigInt am = ctx.toMont(a);
+        const BigInt bm = ctx.toMont(b);
+
+        checkResult(nTotal, nPassed, name + " round trip", ctx.fromMont(am), a);
+        checkResult(nTotal, nPassed, name + ".mul", ctx.fromMont(ctx.mul(am, bm)), modPositive(a*b, m));
+        checkResult(nTotal, nPassed, name + ".sqr", ctx.fromMont(ctx.sqr(am)), modPositive(a*a, m));
+        checkResult(nTotal, nPassed, name + ".one", ctx.fromMont(ctx.one()), BigInt(1));
+    }
+}
+
+
+
+int unsafeMain(int argc, char* argv[])
+{
+    MARTY_ARG_USED(argc);
+    MARTY_ARG_USED(argv);
+
+    std::cout << "BigInt chunk size: " << sizeof(marty::BigInt::chunk_type) << "\n" << std::flush;
+    std::cout << "-------------------------\n\n" << std::flush;
+
+    int nTest   = 0;
+    int nPassed = 0;
+
+    std::mt19937_64 rng(0x706f776du);
+
+    testPowMod    (nTest, nPassed, rng);
+    testBarrett   (nTest, nPassed, rng);
+    testMontgomery(nTest, nPassed, rng);
+
+    int nFailed = nTest - nPassed;
+
+    std::cout << "\n\nTotal tests: " << nTest << ", passed: " << nPassed << ", failed: " << nFailed << "\n\n";
+
+    return nFailed ? 1 : 0;
+}
@@ -0,0 +1,354 @@
+/*! \file
+    \brief Подбор порогов алгоритмов marty::BigInt под текущую машину и тип чанка
+
+    Меряет умножение и квадрат разными алгоритмами на сетке размеров, находит размеры,
+    с которых более сложный алгоритм начинает выигрывать, и пишет marty_bigint_tuning.h
+    (путь к файлу - первый аргумент, по умолчанию - в текущий каталог).
+    Деление и toString тоже меряются и попадают в заголовок комментарием, для сравнения
+    машин между собой - переключаемых алгоритмов у них пока нет.
+
+    Сгенерированный файл надо положить рядом с defs.h (или в пути поиска заголовков)
+    и пересобрать - defs.h подхватит его сам. Пороги действуют для того типа чанка,
+    с которым собрана утилита.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//
+#include "marty_bigint/marty_bigint.h"
+
+#include "marty_bigint/undef_min_max.h"
+
+
+using marty::BigInt;
+namespace limbs = marty::bigint_limbs;
+
+using chunk_t        = BigInt::chunk_type;
+using mul_thresholds = BigInt::mul_thresholds;
+
+constexpr const std::size_t noThreshold = std::size_t(-1) / 4u; // алгоритм не включается никогда
+
+
+//----------------------------------------------------------------------------
+// Лучшее из нескольких замеров, каждый - не короче minMicrosec, в микросекундах на вызов.
+// Минимум, а не среднее - меньше шума от планировщика и от смены частоты
+template<typename Fn>
+double measureUs(Fn &&fn, double minMicrosec = 2000.0, int nRuns = 5)
+{
+    using clock = std::chrono::steady_clock;
+
+    double best = 1e300;
+    for(int k=0; k!=nRuns; ++k)
+    {
+        std::size_t reps    = 0;
+        double      elapsed = 0;
+        const auto  t0      = clock::now();
+        do
+        {
+            fn();
+            ++reps;
+            elapsed = std::chrono::duration<double, std::micro>(clock::now()-t0).count();
+        } while(elapsed<minMicrosec);
+
+        best = std::min(best, elapsed/double(reps));
+    }
+
+    return best;
+}
+
+//----------------------------------------------------------------------------
+std::mt19937_64 rng(20240611u);
+
+std::vector<chunk_t> randomLimbs(std::size_t n)
+{
+    std::vector<chunk_t> v(n);
+    for(auto &c : v)
+        c = chunk_t(rng());
+    v.back() = chunk_t(v.back() | 1u); // старший чанк не ноль
+    return v;
+}
+
+BigInt randomBigInt(std::size_t nLimbs)
+{
+    BigInt r = 1;
+    for(std::size_t i=0; i!=nLimbs*sizeof(chunk_t); ++i)
+    {
+        r <<= 8;
+        r += BigInt(unsigned(rng() & 0xFFu));
+    }
+    return r;
+}
+
+//----------------------------------------------------------------------------
+std::vector<std::size_t> linearGrid(std::size_t from, std::size_t to, std::size_t step)
+{
+    std::vector<std::size_t> res;
+    for(std::size_t n=from; n<=to; n+=step)
+        res.emplace_back(n);
+    return res;
+}
+
+std::vector<std::size_t> geometricGrid(std::size_t from, std::size_t to, double factor)
+{
+    std::vector<std::size_t> res;
+    for(double n=double(from); n<=double(to); n*=factor)
+        res.emplace_back(std::size_t(n));
+    return res;
+}
+
+//----------------------------------------------------------------------------
+// Первый размер сетки, на котором fast заметно быстрее slow - и на нём, и на следующей точке
+// (одиночный выигрыш может быть шумом). Если fast не выигрывает нигде - fallback.
+// slow(n) и fast(n) возвращают время в микросекундах
+template<typename SlowFn, typename FastFn>
+std::size_t findCrossover(const char *name, const std::vector<std::size_t> &grid, std::size_t fallback, SlowFn slow, FastFn fast)
+{
+    std::cout << name << ":\n";
+    std::cout << "    " << std::setw(8) << "limbs" << std::setw(14) << "slow, us" << std::setw(14) << "fast, us" << "\n";
+
+    std::size_t candidate = noThreshold;
+    for(auto n : grid)
+    {
+        const double ts = slow(n);
+        const double tf = fast(n);
+        std::cout << "    " << std::setw(8) << n << std::setw(14) << std::fixed << std::setprecision(3) << ts << std::setw(14) << tf << "\n" << std::flush;
+
+        if (tf<ts*0.97) // выигрыш меньше 3% - шум, усложнять алгоритм ради него незачем
+        {
+            if (candidate!=noThreshold)
+                break; // второй выигрыш подряд
+            candidate = n;
+        }
+        else
+        {
+            candidate = noThreshold;
+        }
+    }
+
+    if (candidate==noThreshold)
+    {
+        std::cout << "    -> not found, keep " << fallback << "\n\n";
+        return fallback;
+    }
+
+    std::cout << "    -> " << candidate << "\n\n";
+    return candidate;
+}
+
+//----------------------------------------------------------------------------
+double timeMul(std::size_t an, std::size_t bn, const mul_thresholds &th)
+{
+    const auto a = randomLimbs(an);
+    const auto b = randomLimbs(bn);
+    std::vector<chunk_t> r(an+bn);
+    std::vector<chunk_t> s(limbs::mulScratchSize(an, bn, th)+1u);
+    return measureUs([&]() { limbs::mul(r.data(), a.data(), an, b.data(), bn, s.data(), th); });
+}
+
+double timeMul(std::size_t n, const mul_thresholds &th)
+{
+    return timeMul(n, n, th);
+}
+
+double timeSqr(std::size_t n, const mul_thresholds &th)
+{
+    const auto a = randomLimbs(n);
+    std::vector<chunk_t> r(2u*n);
+    std::vector<chunk_t> s(limbs::sqrScratchSize(n, th)+1u);
+    return measureUs([&]() { limbs::sqr(r.data(), a.data(), n, s.data(), th); });
+}
+
+//----------------------------------------------------------------------------
+int unsafeMain(int argc, char* argv[])
+{
+    const std::string outName = argc>1 ? std::string(argv[1]) : std::string("marty_bigint_tuning.h");
+
+    std::cout << "BigInt chunk size: " << sizeof(chunk_t) << "\n";
+    std::cout << "-------------------------\n\n" << std::flush;
+
+    const mul_thresholds defaults = mul_thresholds().normalized();
+
+    mul_thresholds th;
+    th.toom3  = noThreshold;
+    th.toom4  = noThreshold;
+    th.toom32 = noThreshold;
+
+    // Карацуба: один шаг Карацубы (половинки - уже простым умножением) против простого
+    const std::size_t karatsuba = findCrossover( "karatsuba", linearGrid(8, 160, 8), defaults.karatsuba
+        , [](std::size_t n)
+          {
+              const auto a = randomLimbs(n);
+              const auto b = randomLimbs(n);
+              std::vector<chunk_t> r(2u*n);
+              return measureUs([&]() { limbs::details::mul_small(r.data(), a.data(), n, b.data(), n); });
+          }
+        , [&th](std::size_t n) { mul_thresholds t = th; t.karatsuba = n; return timeMul(n, t); }
+        );
+    th.karatsuba = karatsuba;
+
+    // То же для квадратов
+    const std::size_t sqrKaratsuba = findCrossover( "sqr karatsuba", linearGrid(16, 240, 8), defaults.sqrKaratsuba
+        , [](std::size_t n)
+          {
+              const auto a = randomLimbs(n);
+              std::vector<chunk_t> r(2u*n);
+              return measureUs([&]() { limbs::sqr_basecase(r.data(), a.data(), n); });
+          }
+        , [&th](std::size_t n) { mul_thresholds t = th; t.karatsuba = std::min(t.karatsuba, n); t.sqrKaratsuba = n; return timeSqr(n, t); }
+        );
+    th.sqrKaratsuba = std::max(th.karatsuba, sqrKaratsuba);
+
+    // Тоом-3 на верхнем уровне против Карацубы
+    const std::size_t toom3 = findCrossover( "toom3", geometricGrid(64, 1500, 1.15), defaults.toom3
+        , [&th](std::size_t n) { return timeMul(n, th); }
+        , [&th](std::size_t n) { mul_thresholds t = th; t.toom3 = n; return timeMul(n, t); }
+        );
+    th.toom3 = toom3;
+
+    // Тоом-4 против Тоома-3
+    const std::size_t toom4 = findCrossover( "toom4", geometricGrid(th.toom3*3u/2u, 6000, 1.2), std::max(defaults.toom4, th.toom3)
+        , [&th](std::size_t n) { return timeMul(n, th); }
+        , [&th](std::size_t n) { mul_thresholds t = th; t.toom4 = n; return timeMul(n, t); }
+        );
+    th.toom4 = toom4;
+
+    // Тоом-2.5/3.5 для множителей разной длины (длинный в 1.7 раза длиннее) против шага Карацубы
+    const std::size_t toom32 = findCrossover( "toom32 (unbalanced)", geometricGrid(32, 1200, 1.2), defaults.toom32
+        , [&th](std::size_t n) { return timeMul(n*17u/10u, n, th); }
+        , [&th](std::size_t n) { mul_thresholds t = th; t.toom32 = n; return timeMul(n*17u/10u, n, t); }
+        );
+    th.toom32 = toom32;
+
+    // FFT в double против Карацубы/Тоома
+    const std::size_t fft = findCrossover( "fft", geometricGrid(500, 80000, 1.3), defaults.fft
+        , [&th](std::size_t n) { return timeMul(n, th); }
+        , [](std::size_t n)
+          {
+              const std::size_t workSize = limbs::fftWorkSize<chunk_t>(n, n);
+              if (!workSize)
+                  return 1e300; // точность не гарантирована - FFT тут не работает
+
+              const auto a = randomLimbs(n);
+              const auto b = randomLimbs(n);
+              std::vector<chunk_t> r(2u*n);
+              std::vector<double>  w(workSize);
+              return measureUs([&]() { limbs::mul_fft(r.data(), a.data(), n, b.data(), n, w.data()); });
+          }
+        );
+    th.fft = fft;
+
+    // NTT против Карацубы/Тоома - там, где FFT уже не годится, или если FFT не выигрывает
+    const std::size_t ntt = findCrossover( "ntt", geometricGrid(1000, 160000, 1.4), defaults.ntt
+        , [&th](std::size_t n) { return timeMul(n, th); }
+        , [](std::size_t n)
+          {
+              const auto a = randomLimbs(n);
+              const auto b = randomLimbs(n);
+              std::vector<chunk_t>       r(2u*n);
+              std::vector<std::uint32_t> w(limbs::nttWorkSize<chunk_t>(n, n));
+              return measureUs([&]() { limbs::mul_ntt(r.data(), a.data(), n, b.data(), n, w.data()); });
+          }
+        );
+    th.ntt = ntt;
+
+    // Справочно: деление 2n на n чанков и перевод в десятичную строку
+    std::ostringstream profile;
+    std::cout << "div / toString:\n";
+    for(std::size_t n : { std::size_t(4), std::size_t(16), std::size_t(64), std::size_t(256), std::size_t(1024) })
+    {
+        const BigInt a = randomBigInt(2u*n);
+        const BigInt b = randomBigInt(n);
+        BigInt q;
+        std::string str;
+        const double tDiv = measureUs([&]() { q = a/b; });
+        const double tStr = measureUs([&]() { str = b.toString(); });
+
+        std::ostringstream line;
+        line << std::setw(6) << n << " limbs: div(2n/n) " << std::fixed << std::setprecision(3) << std::setw(12) << tDiv << " us"
+             << ", toString " << std::setw(12) << tStr << " us";
+        std::cout << "    " << line.str() << "\n" << std::flush;
+        profile << "//   " << line.str() << "\n";
+    }
+    std::cout << "\n";
+
+    // Пишем заголовок. Пороги - под своими именами MARTY_BIGINT_TUNING_xxx: defs.h берёт их, только
+    // если размер чанка сборки совпадает с MARTY_BIGINT_TUNING_CHUNK_BITS, и если порог не задан -D...
+    std::ofstream out(outName);
+    if (!out)
+    {
+        std::cerr << "Failed to create '" << outName << "'\n";
+        return 1;
+    }
+
+    const std::time_t now = std::time(nullptr);
+    char timeBuf[64] = { 0 };
+    std::strftime(timeBuf, sizeof(timeBuf), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+
+    out << "/*! \\file\n";
+    out << "    \\brief Пороги алгоритмов marty::BigInt, подобранные tests/tune-thresholds\n";
+    out << "\n";
+    out << "    Сгенерировано " << timeBuf << ", чанк " << sizeof(chunk_t)*8u << " бит.\n";
+    out << "    Файл генерируется - не редактировать руками, а перезапустить утилиту\n";
+    out << " */\n";
+    out << "#pragma once\n\n";
+    out << "// Размер чанка, для которого подобраны пороги\n";
+    out << "#define MARTY_BIGINT_TUNING_CHUNK_BITS " << sizeof(chunk_t)*8u << "\n\n";
+
+    auto writeMacro = [&](const char *name, std::size_t value)
+    {
+        out << "#define " << name << " " << value << "\n";
+    };
+
+    writeMacro("MARTY_BIGINT_TUNING_KARATSUBA_THRESHOLD"    , th.karatsuba);
+    writeMacro("MARTY_BIGINT_TUNING_SQR_KARATSUBA_THRESHOLD", th.sqrKaratsuba);
+    writeMacro("MARTY_BIGINT_TUNING_TOOM3_THRESHOLD"        , th.toom3);
+    writeMacro("MARTY_BIGINT_TUNING_TOOM4_THRESHOLD"        , th.toom4);
+    writeMacro("MARTY_BIGINT_TUNING_TOOM32_THRESHOLD"       , th.toom32);
+    writeMacro("MARTY_BIGINT_TUNING_FFT_THRESHOLD"          , th.fft);
+    writeMacro("MARTY_BIGINT_TUNING_NTT_THRESHOLD"          , th.ntt);
+    out << "\n";
+
+    out << "// Профиль деления и toString на этой машине (справочно):\n";
+    out << profile.str();
+
+    std::cout << "Thresholds written to '" << outName << "'\n";
+    std::cout << "    karatsuba     : " << th.karatsuba    << "\n";
+    std::cout << "    sqr karatsuba : " << th.sqrKaratsuba << "\n";
+    std::cout << "    toom3         : " << th.toom3        << "\n";
+    std::cout << "    toom4         : " << th.toom4        << "\n";
+    std::cout << "    toom32        : " << th.toom32       << "\n";
+    std::cout << "    fft           : " << th.fft          << "\n";
+    std::cout << "    ntt           : " << th.ntt          << "\n";
+
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    try
+    {
+        return unsafeMain(argc, argv);
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    catch(...)
+    {
+        std::cerr << "unknown error\n";
+        return 2;
+    }
+}
+
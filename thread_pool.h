@@ -0,0 +1,351 @@
+/*!
+    \file
+    \brief Пул потоков с перехватом задач (work stealing) для многопоточного умножения marty::BigInt
+ */
+#pragma once
+
+//
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//
+#include "undef_min_max.h"
+
+
+// #include "marty_bigint/thread_pool.h"
+// marty::bigint_details::
+namespace marty {
+namespace bigint_details {
+
+
+//----------------------------------------------------------------------------
+// Пул потоков для fork-join параллелизма внутри умножения: invoke(f1, f2, ...) выполняет
+// первую функцию сам, остальные кладёт в свою очередь задач и, пока они не доделаны,
+// выполняет задачи из очередей (свои или чужие), а если их нет - спит, пока группа не
+// завершится или не появятся новые задачи. У каждого рабочего потока своя очередь: свои
+// задачи берутся с конца (последняя положенная - самая "горячая" в кэше), чужие
+// перехватываются с начала (там самые крупные куски рекурсии). Потоки не из пула
+// кладут задачи в общую очередь.
+// Задачи ссылаются на функции на стеке invoke и не аллоцируются - invoke не возвращается,
+// пока все его задачи не выполнены. Исключение из задачи перебрасывается из invoke.
+// Пул не копируется и должен жить дольше всех, кто им пользуется.
+class thread_pool
+{
+    struct task_group
+    {
+        std::atomic<std::size_t>  pending;
+        std::atomic<bool>         failed;
+        std::exception_ptr        exception;
+
+        explicit task_group(std::size_t n) : pending(n), failed(false) {}
+
+        void setException(std::exception_ptr e)
+        {
+            if (!failed.exchange(true))
+                exception = e;
+        }
+    };
+
+    struct task
+    {
+        bool       (*run)(void *fn, task_group *pGroup) = nullptr;
+        void        *fn     = nullptr;
+        task_group  *pGroup = nullptr;
+    };
+
+    struct task_queue
+    {
+        std::mutex        mutex;
+        std::deque<task>  tasks;
+    };
+
+    // По очереди на рабочий поток, последняя - общая, для потоков не из пула
+    std::vector<std::unique_ptr<task_queue>>  m_queues;
+    std::vector<std::thread>                  m_threads;
+
+    std::atomic<std::size_t>                  m_queued;
+    bool                                      m_stop = false; // под m_sleepMutex
+    std::mutex                                m_sleepMutex;
+    std::condition_variable                   m_wakeUp;
+
+public:
+
+    //! nThreads - сколько всего потоков считает (вместе с тем, кто вызывает invoke),
+    //! 0 - по числу ядер. Рабочих потоков создаётся на один меньше
+    explicit thread_pool(std::size_t nThreads = 0)
+    : m_queued(0)
+    {
+        if (!nThreads)
+            nThreads = std::thread::hardware_concurrency();
+        if (!nThreads)
+            nThreads = 1;
+
+        for(std::size_t i=0; i!=nThreads; ++i)
+            m_queues.emplace_back(std::make_unique<task_queue>());
+
+        try
+        {
+            for(std::size_t i=0; i+1u<nThreads; ++i)
+                m_threads.emplace_back([this, i]() { workerLoop(i); });
+        }
+        catch(...)
+        {
+            stop();
+            throw;
+        }
+    }
+
+    ~thread_pool()
+    {
+        stop();
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    //! Сколько потоков может работать одновременно (рабочие + вызывающий)
+    std::size_t concurrency() const { return m_threads.size()+1u; }
+
+    //! Выполняет все функции (возможно, в разных потоках) и возвращается, когда все отработали.
+    //! Первая выполняется в текущем потоке. Если какая-то бросила исключение - оно (первое)
+    //! бросается отсюда, но только после завершения остальных
+    template<typename Fn0, typename... Fns>
+    void invoke(Fn0 &&fn0, Fns&&... fns)
+    {
+        if constexpr (sizeof...(Fns)==0)
+        {
+            fn0();
+        }
+        else
+        {
+            task_group group(sizeof...(Fns));
+            task       tasks[] = { makeTask(fns, group)... };
+
+            const std::size_t self = currentQueueIndex();
+            for(auto &t : tasks)
+            {
+                // Не удалось положить в очередь (нет памяти) - выполняем сразу
+                if (!push(self, t))
+                    t.run(t.fn, t.pGroup);
+            }
+
+            try
+            {
+                fn0();
+            }
+            catch(...)
+            {
+                group.setException(std::current_exception());
+            }
+
+            // Пока есть задачи - помогаем, нет - спим до завершения какой-нибудь группы
+            // или до новой задачи
+            while(group.pending.load(std::memory_order_acquire)!=0)
+            {
+                if (runOne(self))
+                    continue;
+
+                std::unique_lock<std::mutex> lock(m_sleepMutex);
+                m_wakeUp.wait(lock, [this, &group]() { return group.pending.load(std::memory_order_acquire)==0 || m_queued.load(std::memory_order_acquire)!=0; });
+            }
+
+            if (group.exception)
+                std::rethrow_exception(group.exception);
+        }
+    }
+
+protected:
+
+    // true - это была последняя задача группы
+    template<typename Fn>
+    static bool runTask(void *fn, task_group *pGroup)
+    {
+        try
+        {
+            (*static_cast<std::remove_reference_t<Fn>*>(fn))();
+        }
+        catch(...)
+        {
+            pGroup->setException(std::current_exception());
+        }
+
+        // После этого группа может быть уже разрушена
+        return pGroup->pending.fetch_sub(1u, std::memory_order_acq_rel)==1u;
+    }
+
+    template<typename Fn>
+    static task makeTask(Fn &fn, task_group &group)
+    {
+        task t;
+        t.run    = &runTask<Fn>;
+        t.fn     = const_cast<void*>(static_cast<const void*>(std::addressof(fn)));
+        t.pGroup = &group;
+        return t;
+    }
+
+    // Рабочий поток и его пул - чтобы отличить свои потоки от чужих (и от потоков другого пула)
+    struct worker_info
+    {
+        const thread_pool *pPool = nullptr;
+        std::size_t        idx   = 0;
+    };
+
+    static worker_info& currentWorker()
+    {
+        static thread_local worker_info info;
+        return info;
+    }
+
+    std::size_t currentQueueIndex() const
+    {
+        const worker_info &info = currentWorker();
+        return info.pPool==this ? info.idx : m_queues.size()-1u;
+    }
+
+    bool push(std::size_t self, const task &t)
+    {
+        // Счётчик - до того, как задачу можно перехватить, иначе он может уйти в минус
+        m_queued.fetch_add(1u, std::memory_order_release);
+
+        try
+        {
+            std::lock_guard<std::mutex> lock(m_queues[self]->mutex);
+            m_queues[self]->tasks.push_back(t);
+        }
+        catch(...)
+        {
+            m_queued.fetch_sub(1u, std::memory_order_relaxed);
+            return false;
+        }
+
+        // Захват мьютекса не даёт уведомлению потеряться между проверкой условия и засыпанием
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+        }
+        m_wakeUp.notify_one();
+
+        return true;
+    }
+
+    // Своя очередь - с конца, чужие - с начала
+    bool pop(std::size_t self, task &t)
+    {
+        if (m_queued.load(std::memory_order_acquire)==0)
+            return false;
+
+        const std::size_t nQueues = m_queues.size();
+        for(std::size_t i=0; i!=nQueues; ++i)
+        {
+            const std::size_t idx = (self+i)%nQueues;
+            task_queue &q = *m_queues[idx];
+
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.tasks.empty())
+                continue;
+
+            if (i==0)
+            {
+                t = q.tasks.back();
+                q.tasks.pop_back();
+            }
+            else
+            {
+                t = q.tasks.front();
+                q.tasks.pop_front();
+            }
+
+            m_queued.fetch_sub(1u, std::memory_order_relaxed);
+            return true;
+        }
+
+        return false;
+    }
+
+    bool runOne(std::size_t self)
+    {
+        task t;
+        if (!pop(self, t))
+            return false;
+
+        // Группа завершена - будим того, кто ждёт её в invoke. Спящие рабочие потоки
+        // проснутся тоже, но это раз на группу
+        if (t.run(t.fn, t.pGroup))
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_sleepMutex);
+            }
+            m_wakeUp.notify_all();
+        }
+
+        return true;
+    }
+
+    void workerLoop(std::size_t idx)
+    {
+        currentWorker().pPool = this;
+        currentWorker().idx   = idx;
+
+        for(;;)
+        {
+            if (runOne(idx))
+                continue;
+
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_wakeUp.wait(lock, [this]() { return m_stop || m_queued.load(std::memory_order_acquire)!=0; });
+            if (m_stop)
+                return;
+        }
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_stop = true;
+        }
+        m_wakeUp.notify_all();
+
+        for(auto &t : m_threads)
+            t.join();
+        m_threads.clear();
+    }
+
+}; // class thread_pool
+
+//----------------------------------------------------------------------------
+//! Исполнитель для алгоритмов bigint_limbs (mul_parallel, mul_fft, mul_ntt) поверх thread_pool,
+//! см. bigint_limbs::serial_invoke
+class pool_invoke
+{
+    thread_pool *m_pPool = nullptr;
+
+public:
+
+    explicit pool_invoke(thread_pool &pool) : m_pPool(&pool) {}
+
+    bool parallel() const { return m_pPool->concurrency()>1u; }
+
+    template<typename... Fn>
+    void operator()(Fn&&... fns) const
+    {
+        m_pPool->invoke(std::forward<Fn>(fns)...);
+    }
+
+}; // class pool_invoke
+
+//----------------------------------------------------------------------------
+
+} // namespace bigint_details
+} // namespace marty
+
+// marty::bigint_details::
+// #include "marty_bigint/thread_pool.h"
@@ -7,24 +7,21 @@
 
 
 #include "defs.h"
+#include "number_holder.h"
 
 //
+#include <climits>
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <type_traits>
 
 //
 #include "undef_min_max.h"
 
 
-// Под отладкой вектора гораздо приятнее разглядывать как последовательности чисел, а не символов. А на производительность - наплевать. Алгоритмы отлаживаем на векторах.
-#if defined(DEBUG) || defined(_DEBUG)
-
-    #if !defined(MARTY_BIGINT_USE_VECTOR)
-        #define MARTY_BIGINT_USE_VECTOR
-    #endif
-
-#endif
+// Для отладки можно хранить модуль в std::vector - задаём MARTY_BIGINT_USE_VECTOR.
+// По умолчанию используется basic_number_holder со встроенным буфером.
 
 
 
@@ -35,26 +32,16 @@ namespace bigint_details {
 
 
 
-    // Мы храним модуль числа в релизе не в векторе, а в std::string
-    // В std::string применяется small string optimization оптимизация
-    // Обычно буфер, хранящийся в строке - 16 байт, поэтому без аллокации
-    // обходятся строки до 15ти char'ов (+1 байт на завершающий ноль),
-    // или строки до 7ти wchar_t'ов (под виндой, sizeof(wchar_t)==2).
-
-    // По идее, в 16 байт влезает два 64битных целых - одно будет само значение,
-    // второе - завершающий 0, но это не точно - можем и не вписаться по какой-либо причине.
+    // Модуль числа храним в basic_number_holder - это вектор со встроенным буфером
+    // (small buffer optimization). Раньше для этого использовался std::basic_string,
+    // но у него SSO буфер - 16 байт, и из них ещё надо выделить место под завершающий ноль,
+    // а кроме того, std::char_traits<unsigned> в новых версиях libc++ больше нет.
+    // Размер встроенного буфера задаётся MARTY_BIGINT_INLINE_BUFFER_SIZE (в байтах),
+    // или MARTY_BIGINT_INLINE_CAPACITY (в чанках).
 
-    // Если мы сложим два 64битных целых - то можем уже вылезти за два 64битных целых
-    // и будет аллокация.
-
-    // Но если мы будем хранить BigInt чанками по 32 бита - то аллокации будут происходить
-    // позже, по крайней мере, для '+'/'-'
-
-    // Но, скорее всего, если использовать чанки по 32 бита, то все операции будут несколько медленнее.
-    // Вопрос в том, насколько медленнее, и где мы больше потеряем - на возможных лишних аллокациях
-    // для больших значений, или на более медленном исполнении при использовании более мелких чанков?
-
-    // Надо тестировать, а пока ограничим размер чанка 32мя битами.
+    // На 64х битных платформах размер чанка - std::uint_fast32_t, под glibc это 64 бита,
+    // под MSVC - 32 бита. Для 64х битных чанков двойной тип - unsigned __int128,
+    // если его нет - используем интринсики или переносимую эмуляцию (см. limbs.h).
 
     // Также нам надо иметь тип, вдвое более широкий, чем тип хранения, для реализации
     // умножения - двойной тип должен без потерь вмещать результат умножения двух одинарных значений.
@@ -105,25 +92,44 @@ namespace detail {
 
 template<bool B> struct always_false : std::false_type {};
 
+#if defined(MARTY_BIGINT_HAS_INT128) && MARTY_BIGINT_HAS_INT128!=0
+
+    __extension__ typedef unsigned __int128 uint128_t;
+    __extension__ typedef          __int128  int128_t;
+
+    constexpr const inline bool has_uint128 = true;
+
+#else
+
+    constexpr const inline bool has_uint128 = false;
+
+#endif
+
 template<size_t Size, bool IsUnsigned> struct double_size_helper;
 
 // Signed types
 template<> struct double_size_helper<1, false> { using type = std::int16_t; };
 template<> struct double_size_helper<2, false> { using type = std::int32_t; };
 template<> struct double_size_helper<4, false> { using type = std::int64_t; };
-// template<> struct double_size_helper<8, false>
-// {
-//     static_assert(always_false<false>::value, "128-bit signed type not supported");
-// };
 
 // Unsigned types
 template<> struct double_size_helper<1, true> { using type = std::uint16_t; };
 template<> struct double_size_helper<2, true> { using type = std::uint32_t; };
 template<> struct double_size_helper<4, true> { using type = std::uint64_t; };
-// template<> struct double_size_helper<8, true>
-// {
-//     static_assert(always_false<false>::value, "128-bit unsigned type not supported");
-// };
+
+#if defined(MARTY_BIGINT_HAS_INT128) && MARTY_BIGINT_HAS_INT128!=0
+
+    template<> struct double_size_helper<8, false> { using type = int128_t ; };
+    template<> struct double_size_helper<8, true > { using type = uint128_t; };
+
+#else
+
+    // 128ми битного типа нет (MSVC) - для 64х битных чанков двойного типа нет,
+    // все операции, которым он нужен, идут через bigint_limbs::mulWide/divWide
+    template<> struct double_size_helper<8, false> { using type = void; };
+    template<> struct double_size_helper<8, true > { using type = void; };
+
+#endif
 
 
 template<typename T>
@@ -133,7 +139,7 @@ struct double_size
 
     static constexpr size_t size = sizeof(T);
 
-    static_assert(size == 1 || size == 2 || size == 4  /* || size == 8 */ , "Unsupported size for doubling");
+    static_assert(size == 1 || size == 2 || size == 4 || size == 8, "Unsupported size for doubling");
 
     using type = typename detail::double_size_helper<size, std::is_unsigned_v<T>>::type;
 };
@@ -151,13 +157,41 @@ template<typename T> using double_size_t = typename double_size<T>::type;
 using unsigned_t  = underlying_unsigned_t;
 using unsigned2_t = detail::double_size_t<unsigned_t>;
 
+// Пороги из marty_bigint_tuning.h годятся только для того размера чанка, на котором подобраны -
+// у той же сборки с другим MARTY_BIGINT_FORCE_NUMBER_UNDERLYING_TYPE переходы совсем другие
+#if defined(MARTY_BIGINT_TUNING_CHUNK_BITS)
+    constexpr const inline bool tuning_chunk_matches = std::size_t(MARTY_BIGINT_TUNING_CHUNK_BITS)==sizeof(unsigned_t)*CHAR_BIT;
+#else
+    constexpr const inline bool tuning_chunk_matches = false;
+#endif
+
+#if defined(MARTY_BIGINT_INLINE_CAPACITY)
+
+    constexpr const inline std::size_t number_holder_inline_capacity = std::size_t(MARTY_BIGINT_INLINE_CAPACITY);
+
+#else
+
+    constexpr const inline std::size_t number_holder_inline_capacity = (MARTY_BIGINT_INLINE_BUFFER_SIZE>sizeof(unsigned_t)) ? std::size_t(MARTY_BIGINT_INLINE_BUFFER_SIZE)/sizeof(unsigned_t) : std::size_t(1);
+
+#endif
+
+#if defined(MARTY_BIGINT_USE_PMR) && MARTY_BIGINT_USE_PMR!=0
+
+    typedef resource_allocator<unsigned_t> number_allocator_t;
+
+#else
+
+    typedef aligned_allocator<unsigned_t>  number_allocator_t;
+
+#endif
+
 #ifndef MARTY_BIGINT_USE_VECTOR
 
-    typedef std::basic_string<unsigned_t> number_holder_t;
+    typedef basic_number_holder<unsigned_t, number_holder_inline_capacity, number_allocator_t> number_holder_t;
 
 #else
 
-    typedef std::vector<unsigned_t>       number_holder_t;
+    typedef std::vector<unsigned_t, number_allocator_t> number_holder_t;
 
 #endif
 
@@ -7,6 +7,7 @@
 #include "defs.h"
 
 //
+#include <climits>
 #include <cstdint>
 #include <type_traits>
 #include <limits>
@@ -256,9 +257,10 @@ constexpr int getTypeDecimalDigits()
     return int(std::numeric_limits<T>::digits10);
 }
 
-inline unsigned getPower10(int p)
+template < typename T = unsigned, std::enable_if_t< std::is_integral_v<T>, int> = 0 >
+inline T getPower10(int p)
 {
-    unsigned res = 1;
+    T res = 1;
     for(; p>0; --p)
        res *= 10;
 
@@ -271,9 +273,10 @@ constexpr int getTypeOctalDigits()
     return (sizeof(T) * CHAR_BIT) / 3;
 }
 
-inline unsigned getPower8(int p)
+template < typename T = unsigned, std::enable_if_t< std::is_integral_v<T>, int> = 0 >
+inline T getPower8(int p)
 {
-    unsigned res = 1;
+    T res = 1;
     for(; p>0; --p)
        res *= 8;
 